@@ -0,0 +1,113 @@
+/*
+ * File:
+ *   bgsched.h
+ * Description:
+ *   Adaptive sleep time of the skip list background threads.
+ *
+ *   The no hot spot and rotating skip lists leave their index to a
+ *   background thread that sleeps between passes over the list. After
+ *   each pass the controller looks at how much of the list the pass had
+ *   to change (nodes raised into the index and deletes finished, which
+ *   follow the inserts and deletes since the previous pass) and at the
+ *   longest run of level 0 nodes it met, which bounds the bottom-level
+ *   part of a search path. It halves the sleep time when either shows
+ *   the index falling behind and doubles it when the list is quiet and
+ *   balanced, between BG_SLEEP_MIN and BG_SLEEP_MAX. A sleep time of 0
+ *   (continuous passes) or a fixed one set by the harness is kept as is.
+ *
+ * bgsched.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef BGSCHED_H
+#define BGSCHED_H
+
+#include <stdio.h>
+
+#define BG_SLEEP_MIN                    100       /* us */
+#define BG_SLEEP_MAX                    1000000   /* us */
+#define BG_BUSY                         16        /* changed nodes per mille */
+#define BG_QUIET                        2         /* changed nodes per mille */
+#define BG_RUN_MAX                      8         /* level 0 nodes in a row */
+
+typedef struct bg_sched {
+  int adaptive;                   /* 0 = keep the sleep time */
+  int sleep;                      /* current sleep time in us */
+  unsigned long passes;           /* passes decided on */
+  unsigned long faster;           /* sleep time halved */
+  unsigned long slower;           /* sleep time doubled */
+  unsigned long long slept;       /* sum of the sleep times */
+  int min, max;                   /* sleep time range reached */
+  unsigned long max_pressure;     /* most nodes changed per mille */
+  unsigned long max_run;          /* longest level 0 run */
+} bg_sched_t;
+
+static inline void bg_sched_init(bg_sched_t *s, int sleep_time, int adaptive)
+{
+  s->adaptive = adaptive && sleep_time > 0;
+  s->sleep = sleep_time;
+  s->passes = s->faster = s->slower = 0;
+  s->slept = 0;
+  s->min = s->max = sleep_time;
+  s->max_pressure = s->max_run = 0;
+}
+
+/*
+ * Decide the sleep time before the next pass, from the number of live
+ * nodes the last pass saw, the number it raised or finished deleting
+ * and the longest run of level 0 nodes it met.
+ */
+static inline int bg_sched_next(bg_sched_t *s, unsigned long nodes,
+                                unsigned long changed, unsigned long run)
+{
+  unsigned long pressure = changed * 1000 / (nodes ? nodes : 1);
+
+  s->passes++;
+  if (pressure > s->max_pressure)
+    s->max_pressure = pressure;
+  if (run > s->max_run)
+    s->max_run = run;
+  if (s->adaptive) {
+    if (pressure >= BG_BUSY || run > BG_RUN_MAX) {
+      if (s->sleep > BG_SLEEP_MIN) {
+        s->sleep = s->sleep / 2 < BG_SLEEP_MIN ? BG_SLEEP_MIN : s->sleep / 2;
+        s->faster++;
+      }
+    } else if (pressure < BG_QUIET && run <= BG_RUN_MAX / 2) {
+      if (s->sleep < BG_SLEEP_MAX) {
+        s->sleep = s->sleep * 2 > BG_SLEEP_MAX ? BG_SLEEP_MAX : s->sleep * 2;
+        s->slower++;
+      }
+    }
+    if (s->sleep < s->min)
+      s->min = s->sleep;
+    if (s->sleep > s->max)
+      s->max = s->sleep;
+  }
+  s->slept += s->sleep;
+  return s->sleep;
+}
+
+static inline void bg_sched_print(const bg_sched_t *s)
+{
+  printf("BG sleep     : %s, %lu passes, %.0f us on average (%d to %d)\n",
+         s->adaptive ? "adaptive" : "fixed", s->passes,
+         s->passes ? (double)s->slept / s->passes : (double)s->sleep,
+         s->min, s->max);
+  printf("  #faster    : %lu\n", s->faster);
+  printf("  #slower    : %lu\n", s->slower);
+  printf("  #kept      : %lu\n", s->passes - s->faster - s->slower);
+  printf("  #changed   : %lu per mille at most\n", s->max_pressure);
+  printf("  #run       : %lu level 0 nodes at most\n", s->max_run);
+}
+
+#endif /* BGSCHED_H */
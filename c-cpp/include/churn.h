@@ -0,0 +1,155 @@
+/*
+ * File:
+ *   churn.h
+ * Description:
+ *   Thread churn for the benchmark harnesses.
+ *
+ *   With -c <n>, every worker returns after n operations and the main
+ *   thread starts a new one in its place, on the same thread_data, for
+ *   as long as the run lasts. Each slot thus sees a sequence of short
+ *   thread lives, which exercises per-thread state registration (ptst,
+ *   epochs, URCU slots) and its release at thread exit. Operation counts
+ *   accumulate in the slot across lives, so the usual throughput figures
+ *   include the cost of churn; the extra figures printed here split it
+ *   into the time the main thread spends joining and creating threads
+ *   and the time a slot stays without a running worker.
+ *
+ * churn.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CHURN_H
+#define CHURN_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_CHURN                   0
+#define CHURN_POLL_US                   100
+
+typedef struct churn {
+  unsigned long period;           /* operations per life, 0 = no churn */
+  void *arg;                      /* argument of every life */
+  volatile int done;              /* the current life has returned */
+  unsigned long lives;            /* lives that have returned */
+  unsigned long spawns;           /* replacement threads started */
+  unsigned long long exit_ns;     /* when the last life returned */
+  unsigned long long down_ns;     /* return-to-restart gaps */
+  unsigned long long spawn_ns;    /* join + create time in main */
+} churn_t;
+
+static inline unsigned long long churn_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void churn_init(churn_t *c, unsigned long period, void *arg)
+{
+  c->period = period;
+  c->arg = arg;
+  c->done = 0;
+  c->lives = c->spawns = 0;
+  c->exit_ns = c->down_ns = c->spawn_ns = 0;
+}
+
+/*
+ * Called by a worker before its first operation. Returns 1 for the
+ * first life of the slot, which is the one that crosses the start
+ * barrier.
+ */
+static inline int churn_enter(churn_t *c)
+{
+  if (c->lives == 0)
+    return 1;
+  c->down_ns += churn_now() - c->exit_ns;
+  return 0;
+}
+
+/* Returns 1 when the worker has done its share of @ops operations */
+static inline int churn_leave(churn_t *c, unsigned long ops)
+{
+  return c->period && ops >= c->period;
+}
+
+/* Called by a worker right before it returns */
+static inline void churn_exit(churn_t *c)
+{
+  if (!c->period)
+    return;
+  c->exit_ns = churn_now();
+  c->lives++;
+  __sync_synchronize();
+  c->done = 1;
+}
+
+/*
+ * Replaces returned workers until @duration ms have elapsed (forever if
+ * 0). Stands in for the harness's nanosleep(); the caller still stops
+ * and joins the @nb_threads current threads afterwards.
+ */
+static inline void churn_run(churn_t *c, pthread_t *threads, int nb_threads,
+			     void *(*fn)(void *), int duration)
+{
+  unsigned long long end = churn_now() + duration * 1000000ULL, t;
+  struct timespec poll = { 0, CHURN_POLL_US * 1000 };
+  int i;
+
+  while (duration == 0 || churn_now() < end) {
+    for (i = 0; i < nb_threads; i++) {
+      if (!c[i].done)
+	continue;
+      t = churn_now();
+      if (pthread_join(threads[i], NULL) != 0) {
+	fprintf(stderr, "Error waiting for thread completion\n");
+	exit(1);
+      }
+      c[i].done = 0;
+      if (pthread_create(&threads[i], NULL, fn, c[i].arg) != 0) {
+	fprintf(stderr, "Error creating thread\n");
+	exit(1);
+      }
+      c[i].spawn_ns += churn_now() - t;
+      c[i].spawns++;
+    }
+    nanosleep(&poll, NULL);
+  }
+}
+
+static inline void churn_print(const churn_t *c, int nb_threads, int duration)
+{
+  unsigned long spawns = 0, lives = 0;
+  unsigned long long spawn_ns = 0, down_ns = 0;
+  int i;
+
+  for (i = 0; i < nb_threads; i++) {
+    spawns += c[i].spawns;
+    lives += c[i].lives;
+    spawn_ns += c[i].spawn_ns;
+    down_ns += c[i].down_ns;
+  }
+  printf("Churn         : %lu ops per thread life\n", c[0].period);
+  printf("  #restarts   : %lu (%f / s)\n", spawns,
+	 duration ? spawns * 1000.0 / duration : 0.0);
+  printf("  #lives      : %lu\n", lives);
+  printf("  #spawn cost : %.3f us (avg join + create)\n",
+	 spawns ? spawn_ns / 1e3 / spawns : 0.0);
+  printf("  #downtime   : %.3f ms (%.2f%% of thread time)\n", down_ns / 1e6,
+	 duration ? 100.0 * down_ns / 1e6 / ((double)nb_threads * duration)
+	 : 0.0);
+}
+
+#endif /* CHURN_H */
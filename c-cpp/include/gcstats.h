@@ -0,0 +1,216 @@
+/*
+ * File:
+ *   gcstats.h
+ * Description:
+ *   Reclamation statistics shared by the epoch-based garbage collectors
+ *   (fraser gc.c, nohotspot and rotating garbagecoll.c).
+ *
+ *   Every collector embeds a gc_stats_t in its global state and feeds it
+ *   from gc_reclaim(), which runs in mutual exclusion, so apart from the
+ *   chunk counters no atomics are needed. Retirement is counted in the
+ *   per-thread gc state and summed by the reclaimer. A snapshot can be
+ *   taken at any time with the collector's gc_get_stats(); the harness
+ *   takes one when the workers start and one when they stop and prints
+ *   the difference.
+ *
+ *   The retire-to-reclaim time is estimated per epoch rather than per
+ *   block: blocks retired in epoch e are taken to have been retired in
+ *   the middle of e, and reclaimed when their garbage list moves back to
+ *   the allocation lists. An epoch stall is a reclaim attempt that finds
+ *   a thread still inside a critical region of an older epoch; the
+ *   longest stall and the thread that caused it are recorded, and stalls
+ *   longer than GC_STALL_MS are counted.
+ *
+ * gcstats.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef GCSTATS_H
+#define GCSTATS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define GC_STATS_EPOCHS                 4
+#define GC_MAX_SAMPLES                  16
+#define GC_SAMPLE_MS                    100
+#define GC_STALL_MS                     10
+
+typedef struct gc_sample {
+  unsigned long t_ms;
+  unsigned long unreclaimed;
+  unsigned long epochs;
+} gc_sample_t;
+
+typedef struct gc_stats {
+  unsigned long long now_ns;
+  unsigned long long start_ns;
+  unsigned long long last_advance_ns;
+  unsigned long long epoch_ns[GC_STATS_EPOCHS];
+  int disabled;                   /* built with MINIMAL_GC */
+
+  unsigned long epochs;           /* epoch advances */
+  unsigned long attempts;         /* reclaim attempts */
+  unsigned long retired;          /* blocks handed to gc_free() */
+  unsigned long retired_bytes;
+  unsigned long reclaimed;        /* blocks moved back to alloc lists */
+  unsigned long reclaimed_bytes;
+  unsigned long long latency_ns;  /* sum of retire-to-reclaim estimates */
+  unsigned long chunks;           /* node chunks allocated */
+  unsigned long chunk_bytes;
+
+  unsigned long stalls;           /* stalls longer than GC_STALL_MS */
+  unsigned long long max_stall_ns;
+  int max_stall_thread;
+  int stalled;
+
+  unsigned long sample_ms;
+  unsigned long nr_samples;
+  gc_sample_t samples[GC_MAX_SAMPLES];
+} gc_stats_t;
+
+static inline unsigned long long gc_stats_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void gc_stats_init(gc_stats_t *s)
+{
+  int i;
+
+  memset(s, 0, sizeof(*s));
+  s->start_ns = s->last_advance_ns = gc_stats_now();
+  for (i = 0; i < GC_STATS_EPOCHS; i++)
+    s->epoch_ns[i] = s->start_ns;
+  s->max_stall_thread = -1;
+  s->sample_ms = GC_SAMPLE_MS;
+}
+
+static inline void gc_stats_chunks(gc_stats_t *s, int n, unsigned long bytes)
+{
+  __sync_fetch_and_add(&s->chunks, n);
+  __sync_fetch_and_add(&s->chunk_bytes, bytes);
+}
+
+/* @thread was still in a critical region of an older epoch at @now */
+static inline void gc_stats_stall(gc_stats_t *s, unsigned long long now,
+				  int thread)
+{
+  unsigned long long stall = now - s->last_advance_ns;
+
+  if (stall > s->max_stall_ns) {
+    s->max_stall_ns = stall;
+    s->max_stall_thread = thread;
+  }
+  if (!s->stalled && stall > GC_STALL_MS * 1000000ULL) {
+    s->stalled = 1;
+    s->stalls++;
+  }
+}
+
+/*
+ * @n blocks of @bytes in total, retired during epoch @epoch, are about
+ * to be reused.
+ */
+static inline void gc_stats_reclaim(gc_stats_t *s, unsigned long long now,
+				    int epoch, int nr_epochs,
+				    unsigned long n, unsigned long bytes)
+{
+  unsigned long long from = s->epoch_ns[epoch];
+  unsigned long long to = s->epoch_ns[(epoch + 1) % nr_epochs];
+
+  if (to < from)
+    to = from;
+  s->reclaimed += n;
+  s->reclaimed_bytes += bytes;
+  s->latency_ns += n * (now - (from + (to - from) / 2));
+}
+
+static inline void gc_stats_advance(gc_stats_t *s, unsigned long long now,
+				    int epoch)
+{
+  s->epochs++;
+  s->epoch_ns[epoch] = s->last_advance_ns = now;
+  s->stalled = 0;
+}
+
+/*
+ * Records the retired-but-unreclaimed bytes every sample_ms. When the
+ * buffer fills up, every other sample is dropped and the period doubles,
+ * so the samples always span the whole run.
+ */
+static inline void gc_stats_sample(gc_stats_t *s, unsigned long long now,
+				   unsigned long retired_bytes)
+{
+  unsigned long t = (now - s->start_ns) / 1000000, i;
+  gc_sample_t *last;
+
+  if (s->nr_samples) {
+    last = &s->samples[s->nr_samples - 1];
+    if (t < last->t_ms + s->sample_ms)
+      return;
+  }
+  if (s->nr_samples == GC_MAX_SAMPLES) {
+    for (i = 0; i < GC_MAX_SAMPLES / 2; i++)
+      s->samples[i] = s->samples[2 * i + 1];
+    s->nr_samples = GC_MAX_SAMPLES / 2;
+    s->sample_ms *= 2;
+  }
+  s->samples[s->nr_samples].t_ms = t;
+  s->samples[s->nr_samples].unreclaimed = retired_bytes - s->reclaimed_bytes;
+  s->samples[s->nr_samples].epochs = s->epochs;
+  s->nr_samples++;
+}
+
+/* Prints what happened between snapshots @b and @e */
+static inline void gc_stats_print(const gc_stats_t *b, const gc_stats_t *e)
+{
+  double secs = (e->now_ns - b->now_ns) / 1e9;
+  unsigned long reclaimed = e->reclaimed - b->reclaimed, i;
+
+  if (secs <= 0)
+    secs = 1e-9;
+  if (e->disabled)
+    printf("GC epochs     : none (MINIMAL_GC, nothing is reclaimed)\n");
+  else
+    printf("GC epochs     : %lu (%f / s)\n", e->epochs - b->epochs,
+	   (e->epochs - b->epochs) / secs);
+  printf("  #attempts   : %lu (%lu advanced the epoch)\n",
+	 e->attempts - b->attempts, e->epochs - b->epochs);
+  printf("  #retired    : %lu (%lu KB)\n", e->retired - b->retired,
+	 (e->retired_bytes - b->retired_bytes) / 1024);
+  printf("  #reclaimed  : %lu (%lu KB)\n", reclaimed,
+	 (e->reclaimed_bytes - b->reclaimed_bytes) / 1024);
+  printf("  #reclaim lat: %.3f ms (avg, retire to reuse)\n",
+	 reclaimed ? (e->latency_ns - b->latency_ns) / 1e6 / reclaimed : 0.0);
+  printf("  #chunks     : %lu (%lu KB)\n", e->chunks - b->chunks,
+	 (e->chunk_bytes - b->chunk_bytes) / 1024);
+  printf("  #unreclaimed: %lu KB at start, %lu KB at end\n",
+	 (b->retired_bytes - b->reclaimed_bytes) / 1024,
+	 (e->retired_bytes - e->reclaimed_bytes) / 1024);
+  printf("  #stalls     : %lu (> %d ms)\n", e->stalls - b->stalls, GC_STALL_MS);
+  if (e->max_stall_thread >= 0)
+    printf("  #max stall  : %.3f ms (thread %d)\n", e->max_stall_ns / 1e6,
+	   e->max_stall_thread);
+  else
+    printf("  #max stall  : %.3f ms\n", e->max_stall_ns / 1e6);
+  for (i = 0; i < e->nr_samples; i++)
+    printf("    %6lu ms : %8lu KB unreclaimed, %lu epochs\n",
+	   e->samples[i].t_ms, e->samples[i].unreclaimed / 1024,
+	   e->samples[i].epochs);
+}
+
+#endif /* GCSTATS_H */
@@ -0,0 +1,181 @@
+/*
+ * File:
+ *   hashfn.h
+ * Description:
+ *   Hash functions mapping integer keys to the buckets of a power-of-two
+ *   hash table, and a bucket-length histogram to compare them.
+ *
+ *   - identity:  the low bits of the key, what "key % length" gives
+ *                without the division; strided keys use 1/stride of the
+ *                buckets when the stride is a power of two;
+ *   - fibonacci: the top bits of the key times 2^64 / phi (Knuth's
+ *                multiplicative hashing), one multiplication;
+ *   - murmur3:   the 64-bit finalizer of MurmurHash3, two multiplications
+ *                and full avalanche;
+ *   - wyhash:    wyhash (final version 4) of the 4 bytes of the key, the
+ *                path string keys of that length would take.
+ *
+ * hashfn.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef HASHFN_H
+#define HASHFN_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HASH_IDENTITY                   0
+#define HASH_FIBONACCI                  1
+#define HASH_MURMUR3                    2
+#define HASH_WYHASH                     3
+#define HASH_NB_FUNCTIONS               4
+
+#define DEFAULT_HASH                    HASH_IDENTITY
+
+/* Chains of this length or more share the last histogram entry */
+#define HASH_HIST_LEN                   16
+
+static const char *hash_names[HASH_NB_FUNCTIONS] = {
+  "identity", "fibonacci", "murmur3", "wyhash"
+};
+
+static inline uint64_t hash_murmur3(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+static inline uint64_t hash_wymix(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+  __uint128_t r = (__uint128_t)a * b;
+
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+  return hash_murmur3(a ^ hash_murmur3(b));
+#endif
+}
+
+/* wyhash of the len <= 16 bytes at p, len >= 4 */
+static inline uint64_t hash_wyhash_small(const uint8_t *p, size_t len)
+{
+  static const uint64_t s[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+    0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL
+  };
+  uint64_t seed = hash_wymix(s[0], s[1]), a, b;
+  uint32_t w[4];
+  size_t off = (len >> 3) << 2;
+
+  memcpy(&w[0], p, 4);
+  memcpy(&w[1], p + off, 4);
+  memcpy(&w[2], p + len - 4, 4);
+  memcpy(&w[3], p + len - 4 - off, 4);
+  a = ((uint64_t)w[0] << 32 | w[1]) ^ s[1];
+  b = ((uint64_t)w[2] << 32 | w[3]) ^ seed;
+#ifdef __SIZEOF_INT128__
+  {
+    __uint128_t r = (__uint128_t)a * b;
+
+    a = (uint64_t)r;
+    b = (uint64_t)(r >> 64);
+  }
+#endif
+  return hash_wymix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+/* Bucket of key in a table of 2^bits buckets */
+static inline unsigned long hash_index(int fn, long key, unsigned int bits)
+{
+  uint64_t k = (uint32_t)key, mask = (1ULL << bits) - 1;
+  uint32_t k32 = (uint32_t)key;
+
+  switch (fn) {
+  case HASH_FIBONACCI:
+    return bits ? (k * 0x9E3779B97F4A7C15ULL) >> (64 - bits) : 0;
+  case HASH_MURMUR3:
+    return hash_murmur3(k) & mask;
+  case HASH_WYHASH:
+    return hash_wyhash_small((const uint8_t *)&k32, sizeof(k32)) & mask;
+  default:
+    return k & mask;
+  }
+}
+
+/* Smallest power of two >= n, at least 1 and at most max */
+static inline unsigned int hash_pow2(unsigned int n, unsigned int max)
+{
+  unsigned int len = 1;
+
+  while (len < n && len < max)
+    len <<= 1;
+  return len;
+}
+
+static inline unsigned int hash_bits(unsigned int len)
+{
+  return (unsigned int)__builtin_ctz(len);
+}
+
+typedef struct hash_hist {
+  unsigned long count[HASH_HIST_LEN + 1];
+  unsigned long buckets;
+  unsigned long keys;
+  unsigned long sq;               /* sum of the squared lengths */
+  unsigned long max;
+} hash_hist_t;
+
+static inline void hash_hist_add(hash_hist_t *h, unsigned long len)
+{
+  h->count[len < HASH_HIST_LEN ? len : HASH_HIST_LEN]++;
+  h->buckets++;
+  h->keys += len;
+  h->sq += len * len;
+  if (len > h->max)
+    h->max = len;
+}
+
+/*
+ * Prints the chain lengths. The dispersion is their variance over their
+ * mean: about 1 when keys land in buckets independently and uniformly,
+ * above 1 when some buckets take more than their share.
+ */
+static inline void hash_print_hist(int fn, hash_hist_t *h)
+{
+  unsigned long i;
+  double mean, var;
+
+  if (h->buckets == 0)
+    return;
+  mean = (double)h->keys / h->buckets;
+  var = (double)h->sq / h->buckets - mean * mean;
+  printf("Buckets       : %lu (hash %s, mask 0x%lx)\n", h->buckets,
+	 hash_names[fn], h->buckets - 1);
+  printf("  #used       : %lu (%.1f%%)\n", h->buckets - h->count[0],
+	 100.0 * (h->buckets - h->count[0]) / h->buckets);
+  printf("  #chain len  : %.2f avg, %lu max, %.2f dispersion\n", mean, h->max,
+	 mean > 0 ? var / mean : 0.0);
+  for (i = 0; i <= HASH_HIST_LEN; i++) {
+    if (h->count[i] == 0)
+      continue;
+    printf("  #len %2lu%s    : %lu (%.1f%%)\n", i, i == HASH_HIST_LEN ? "+" : " ",
+	   h->count[i], 100.0 * h->count[i] / h->buckets);
+  }
+}
+
+#endif /* HASHFN_H */
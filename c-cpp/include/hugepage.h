@@ -0,0 +1,211 @@
+/*
+ * File:
+ *   hugepage.h
+ * Description:
+ *   Huge-page backed memory for node allocation.
+ *
+ *   Node memory is carved out of 2MB-aligned regions that are either
+ *   mapped with MAP_HUGETLB (HUGEPAGE=HUGETLB, falls back to THP when no
+ *   huge pages are reserved) or advised with MADV_HUGEPAGE (HUGEPAGE=THP).
+ *   The arena records every region it maps so that the fraction of node
+ *   memory actually backed by huge pages can be read back from
+ *   /proc/self/smaps at the end of a run.
+ *
+ * hugepage.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef HUGEPAGE_H
+#define HUGEPAGE_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGETLB
+#  define MAP_HUGETLB                   0x40000
+#endif
+#ifndef MADV_HUGEPAGE
+#  define MADV_HUGEPAGE                 14
+#endif
+
+#define HP_PAGE_SIZE                    (2UL << 20)
+#define HP_REGION_SIZE                  (16 * HP_PAGE_SIZE)
+#define HP_MAX_REGIONS                  4096
+#define HP_ALIGN                        64
+
+#ifdef HUGEPAGE_HUGETLB
+#  define HP_MODE                       "hugetlb"
+#else
+#  define HP_MODE                       "thp"
+#endif
+
+typedef struct hp_region {
+  char *addr;
+  size_t len;
+  int hugetlb;
+} hp_region_t;
+
+/*
+ * An arena hands out memory from huge-page regions. Requests are served
+ * under a mutex since callers either amortise them over whole chunks of
+ * nodes (gc allocators) or over a per-thread hp_bump_t.
+ */
+typedef struct hp_arena {
+  pthread_mutex_t lock;
+  char *cur;
+  char *end;
+  unsigned long used;
+  unsigned long nr_regions;
+  hp_region_t regions[HP_MAX_REGIONS];
+} hp_arena_t;
+
+#define HP_ARENA_INITIALIZER            { PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0, 0 }
+
+/*
+ * Per-thread bump pointer over arena memory, for nodes that are never
+ * handed back individually.
+ */
+typedef struct hp_bump {
+  char *cur;
+  char *end;
+} hp_bump_t;
+
+static inline char *hp_map(hp_arena_t *a, size_t len)
+{
+  char *p, *q;
+  int hugetlb = 0;
+
+#ifdef HUGEPAGE_HUGETLB
+  p = (char *)mmap(NULL, len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) {
+    hugetlb = 1;
+    goto out;
+  }
+#endif
+  /* Over-map so that the region can be trimmed to a 2MB boundary */
+  p = (char *)mmap(NULL, len + HP_PAGE_SIZE, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+  q = (char *)(((unsigned long)p + HP_PAGE_SIZE - 1) & ~(HP_PAGE_SIZE - 1));
+  if (q != p)
+    munmap(p, q - p);
+  munmap(q + len, HP_PAGE_SIZE - (q - p));
+  p = q;
+  madvise(p, len, MADV_HUGEPAGE);
+
+ out:
+  if (a->nr_regions < HP_MAX_REGIONS) {
+    a->regions[a->nr_regions].addr = p;
+    a->regions[a->nr_regions].len = len;
+    a->regions[a->nr_regions].hugetlb = hugetlb;
+    a->nr_regions++;
+  }
+  return p;
+}
+
+/* Returns @size bytes of cache-line aligned huge-page backed memory */
+static inline void *hp_alloc(hp_arena_t *a, size_t size)
+{
+  char *p;
+  size_t len;
+
+  size = (size + HP_ALIGN - 1) & ~(size_t)(HP_ALIGN - 1);
+  pthread_mutex_lock(&a->lock);
+  if (size > HP_REGION_SIZE / 2) {
+    /* Large requests get a region of their own */
+    len = (size + HP_PAGE_SIZE - 1) & ~(HP_PAGE_SIZE - 1);
+    p = hp_map(a, len);
+  } else {
+    if (a->cur == NULL || a->cur + size > a->end) {
+      a->cur = hp_map(a, HP_REGION_SIZE);
+      a->end = a->cur + HP_REGION_SIZE;
+    }
+    p = a->cur;
+    a->cur += size;
+  }
+  a->used += size;
+  pthread_mutex_unlock(&a->lock);
+  return p;
+}
+
+static inline void *hp_bump_alloc(hp_arena_t *a, hp_bump_t *b, size_t size)
+{
+  void *p;
+
+  if (b->cur == NULL || b->cur + size > b->end) {
+    b->cur = (char *)hp_alloc(a, HP_PAGE_SIZE);
+    b->end = b->cur + HP_PAGE_SIZE;
+  }
+  p = b->cur;
+  b->cur += size;
+  return p;
+}
+
+/*
+ * Prints how much of the arena is backed by huge pages, as reported by
+ * the kernel, and the process-wide huge-page usage, which also covers
+ * memory obtained through malloc (e.g. with TCMALLOC_MEMFS_MALLOC_PATH or
+ * GLIBC_TUNABLES=glibc.malloc.hugetlb=1).
+ */
+static inline void hp_print_stats(hp_arena_t *a, const char *name)
+{
+  FILE *f;
+  char line[256];
+  unsigned long start, end, kb, i;
+  unsigned long mapped = 0, huge = 0, proc_huge = 0;
+  int ours = 0;
+
+  for (i = 0; i < a->nr_regions; i++) {
+    mapped += a->regions[i].len;
+    if (a->regions[i].hugetlb)
+      huge += a->regions[i].len;
+  }
+
+  if ((f = fopen("/proc/self/smaps", "r")) != NULL) {
+    while (fgets(line, sizeof(line), f) != NULL) {
+      if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+	ours = 0;
+	for (i = 0; i < a->nr_regions; i++) {
+	  if (!a->regions[i].hugetlb &&
+	      (unsigned long)a->regions[i].addr < end &&
+	      (unsigned long)a->regions[i].addr + a->regions[i].len > start) {
+	    ours = 1;
+	    break;
+	  }
+	}
+      } else if (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+	proc_huge += kb * 1024;
+	if (ours)
+	  huge += kb * 1024;
+      } else if (sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1) {
+	proc_huge += kb * 1024;
+      }
+    }
+    fclose(f);
+  }
+  printf("Huge pages    : %s (%s)\n", HP_MODE, name);
+  printf("  #mapped     : %lu KB in %lu regions\n", mapped / 1024,
+	 a->nr_regions);
+  printf("  #used       : %lu KB\n", a->used / 1024);
+  printf("  #huge-backed: %lu KB (%.1f%% of used)\n", huge / 1024,
+	 a->used ? 100.0 * (huge < a->used ? huge : a->used) / a->used : 0.0);
+  printf("  #proc-huge  : %lu KB\n", proc_huge / 1024);
+}
+
+#endif /* HUGEPAGE_H */
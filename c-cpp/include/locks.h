@@ -0,0 +1,568 @@
+/*
+ * File:
+ *   locks.h
+ * Description:
+ *   Lock algorithms of the lock-based structures, selected at compile
+ *   time with LOCK=<name>:
+ *    - MUTEX:  pthread mutex;
+ *    - SPIN:   pthread spinlock;
+ *    - TTAS:   test-and-test-and-set with exponential backoff;
+ *    - TICKET: ticket lock, FIFO, all waiters spin on the owner word;
+ *    - MCS:    MCS queue lock, every waiter spins on its own queue node;
+ *    - CLH:    CLH queue lock, every waiter spins on the queue node of
+ *              its predecessor;
+ *    - COHORT: NUMA-aware cohort lock (C-TKT-TKT): one ticket lock per
+ *              NUMA node and a global ticket lock that the holder passes
+ *              to a waiter of its node, up to COHORT_MAX_PASSES times in
+ *              a row, instead of releasing it;
+ *    - FUTEX:  spins FUTEX_SPINS times, then parks the thread in the
+ *              kernel with futex_wait until the holder wakes it.
+ *
+ *   All of them provide ptlock_t, INIT_LOCK, DESTROY_LOCK, LOCK, TRYLOCK
+ *   and UNLOCK with the pthread conventions: 0 on success, EBUSY when
+ *   TRYLOCK finds the lock taken.
+ *
+ *   UNLOCK takes the lock only, so the queue locks record the queue node
+ *   of their holder in the lock. Threads take queue nodes from a
+ *   per-thread pool instantiated by LOCKS_DEFINE, in exactly one file per
+ *   benchmark; a node goes back to the pool of the thread that releases
+ *   it and the pools are not freed when threads exit.
+ *
+ * locks.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef LOCKS_H
+#define LOCKS_H
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef LOCK_FUTEX
+#include <linux/futex.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define LOCK_RELAX()                  __asm__ __volatile__("pause" ::: "memory")
+#else
+#  define LOCK_RELAX()                  __asm__ __volatile__("" ::: "memory")
+#endif
+
+#define LOCK_LOAD_ACQ(p)                __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define LOCK_STORE_REL(p, v)            __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/* Bounds of the TTAS backoff, in pause instructions */
+#define TTAS_BACKOFF_MIN                4
+#define TTAS_BACKOFF_MAX                1024
+
+/* NUMA nodes the cohort lock tells apart, higher nodes share a cohort */
+#define COHORT_NODES                    4
+
+/* Times in a row the global lock is passed within a cohort */
+#define COHORT_MAX_PASSES               64
+
+/* Attempts to take a futex lock before parking */
+#define FUTEX_SPINS                     128
+
+/* Queue nodes a thread keeps for reuse */
+#define LOCK_QNODES                     64
+
+/* ################################################################### *
+ * TEST-AND-TEST-AND-SET
+ * ################################################################### */
+
+typedef uint32_t ttas_lock_t;
+
+static inline int ttas_init(ttas_lock_t *l)
+{
+  *(volatile ttas_lock_t *)l = 0;
+  return 0;
+}
+
+static inline int ttas_lock(ttas_lock_t *l)
+{
+  volatile ttas_lock_t *v = l;
+  unsigned int backoff = TTAS_BACKOFF_MIN, i;
+
+  while (1) {
+    while (*v)
+      LOCK_RELAX();
+    if (!__sync_lock_test_and_set(v, 1))
+      return 0;
+    for (i = 0; i < backoff; i++)
+      LOCK_RELAX();
+    if (backoff < TTAS_BACKOFF_MAX)
+      backoff <<= 1;
+  }
+}
+
+static inline int ttas_trylock(ttas_lock_t *l)
+{
+  volatile ttas_lock_t *v = l;
+
+  return (*v == 0 && !__sync_lock_test_and_set(v, 1)) ? 0 : EBUSY;
+}
+
+static inline int ttas_unlock(ttas_lock_t *l)
+{
+  __sync_lock_release((volatile ttas_lock_t *)l);
+  return 0;
+}
+
+/* ################################################################### *
+ * TICKET
+ * ################################################################### */
+
+typedef struct ticket_lock {
+  volatile uint32_t next;
+  volatile uint32_t owner;
+} ticket_lock_t;
+
+static inline int ticket_init(ticket_lock_t *l)
+{
+  l->next = l->owner = 0;
+  return 0;
+}
+
+static inline int ticket_lock(ticket_lock_t *l)
+{
+  uint32_t t = __sync_fetch_and_add(&l->next, 1);
+
+  while (LOCK_LOAD_ACQ(&l->owner) != t)
+    LOCK_RELAX();
+  return 0;
+}
+
+static inline int ticket_trylock(ticket_lock_t *l)
+{
+  uint32_t o = l->owner;
+
+  if (l->next != o || !__sync_bool_compare_and_swap(&l->next, o, o + 1))
+    return EBUSY;
+  return 0;
+}
+
+static inline int ticket_unlock(ticket_lock_t *l)
+{
+  LOCK_STORE_REL(&l->owner, l->owner + 1);
+  return 0;
+}
+
+/* Whether threads wait behind the holder */
+static inline int ticket_waiters(ticket_lock_t *l)
+{
+  return l->next - l->owner > 1;
+}
+
+/* ################################################################### *
+ * QUEUE NODES
+ * ################################################################### */
+
+typedef struct lock_qnode {
+  struct lock_qnode *volatile next;
+  volatile uint32_t locked;
+} __attribute__((aligned(64))) lock_qnode_t;
+
+typedef struct lock_qpool {
+  int n;
+  lock_qnode_t *free[LOCK_QNODES];
+} lock_qpool_t;
+
+#if defined(LOCK_MCS) || defined(LOCK_CLH)
+extern __thread lock_qpool_t lock_qpool;
+
+/* Instantiates the queue node pools, in exactly one file per benchmark */
+#  define LOCKS_DEFINE                  __thread lock_qpool_t lock_qpool;
+#elif defined(LOCK_COHORT)
+extern __thread int lock_cohort;
+
+#  define LOCKS_DEFINE                  __thread int lock_cohort = -1;
+#else
+#  define LOCKS_DEFINE
+#endif
+
+#if defined(LOCK_MCS) || defined(LOCK_CLH)
+static inline lock_qnode_t *lock_qnode_get(void)
+{
+  lock_qnode_t *q;
+
+  if (lock_qpool.n > 0)
+    return lock_qpool.free[--lock_qpool.n];
+  if (posix_memalign((void **)&q, sizeof(lock_qnode_t), sizeof(lock_qnode_t)) != 0) {
+    perror("posix_memalign");
+    exit(1);
+  }
+  return q;
+}
+
+static inline void lock_qnode_put(lock_qnode_t *q)
+{
+  if (lock_qpool.n < LOCK_QNODES)
+    lock_qpool.free[lock_qpool.n++] = q;
+  else
+    free(q);
+}
+#endif
+
+/* ################################################################### *
+ * MCS
+ * ################################################################### */
+
+typedef struct mcs_lock {
+  lock_qnode_t *volatile tail;
+  lock_qnode_t *holder;
+} mcs_lock_t;
+
+#ifdef LOCK_MCS
+static inline int mcs_init(mcs_lock_t *l)
+{
+  l->tail = l->holder = NULL;
+  return 0;
+}
+
+static inline int mcs_lock(mcs_lock_t *l)
+{
+  lock_qnode_t *q = lock_qnode_get(), *pred;
+
+  q->next = NULL;
+  q->locked = 1;
+  pred = __atomic_exchange_n(&l->tail, q, __ATOMIC_ACQ_REL);
+  if (pred != NULL) {
+    LOCK_STORE_REL(&pred->next, q);
+    while (LOCK_LOAD_ACQ(&q->locked))
+      LOCK_RELAX();
+  }
+  l->holder = q;
+  return 0;
+}
+
+static inline int mcs_trylock(mcs_lock_t *l)
+{
+  lock_qnode_t *q;
+
+  if (l->tail != NULL)
+    return EBUSY;
+  q = lock_qnode_get();
+  q->next = NULL;
+  q->locked = 1;
+  if (!__sync_bool_compare_and_swap(&l->tail, NULL, q)) {
+    lock_qnode_put(q);
+    return EBUSY;
+  }
+  l->holder = q;
+  return 0;
+}
+
+static inline int mcs_unlock(mcs_lock_t *l)
+{
+  lock_qnode_t *q = l->holder, *succ;
+
+  succ = LOCK_LOAD_ACQ(&q->next);
+  if (succ == NULL) {
+    if (__sync_bool_compare_and_swap(&l->tail, q, NULL)) {
+      lock_qnode_put(q);
+      return 0;
+    }
+    /* a successor swapped the tail but did not link itself yet */
+    while ((succ = LOCK_LOAD_ACQ(&q->next)) == NULL)
+      LOCK_RELAX();
+  }
+  LOCK_STORE_REL(&succ->locked, 0);
+  lock_qnode_put(q);
+  return 0;
+}
+#endif
+
+/* ################################################################### *
+ * CLH
+ * ################################################################### */
+
+/*
+ * The tail always points to a queue node: a released lock points to the
+ * node of its last holder, which the lock owns from then on. A holder
+ * gives up its own node on release and takes the one of its
+ * predecessor instead.
+ */
+typedef struct clh_lock {
+  lock_qnode_t *volatile tail;
+  lock_qnode_t *holder;
+  lock_qnode_t *pred;             /* node the holder takes on release */
+} clh_lock_t;
+
+#ifdef LOCK_CLH
+static inline int clh_init(clh_lock_t *l)
+{
+  lock_qnode_t *q;
+
+  if (posix_memalign((void **)&q, sizeof(lock_qnode_t), sizeof(lock_qnode_t)) != 0)
+    return ENOMEM;
+  q->locked = 0;
+  l->tail = q;
+  l->holder = l->pred = NULL;
+  return 0;
+}
+
+static inline int clh_destroy(clh_lock_t *l)
+{
+  free(l->tail);
+  return 0;
+}
+
+static inline int clh_lock(clh_lock_t *l)
+{
+  lock_qnode_t *q = lock_qnode_get(), *pred;
+
+  q->locked = 1;
+  pred = __atomic_exchange_n(&l->tail, q, __ATOMIC_ACQ_REL);
+  while (LOCK_LOAD_ACQ(&pred->locked))
+    LOCK_RELAX();
+  l->holder = q;
+  l->pred = pred;
+  return 0;
+}
+
+static inline int clh_trylock(clh_lock_t *l)
+{
+  lock_qnode_t *q, *pred = l->tail;
+
+  if (LOCK_LOAD_ACQ(&pred->locked))
+    return EBUSY;
+  q = lock_qnode_get();
+  q->locked = 1;
+  if (!__sync_bool_compare_and_swap(&l->tail, pred, q)) {
+    lock_qnode_put(q);
+    return EBUSY;
+  }
+  l->holder = q;
+  l->pred = pred;
+  return 0;
+}
+
+static inline int clh_unlock(clh_lock_t *l)
+{
+  lock_qnode_t *pred = l->pred;
+
+  LOCK_STORE_REL(&l->holder->locked, 0);
+  lock_qnode_put(pred);
+  return 0;
+}
+#endif
+
+/* ################################################################### *
+ * COHORT
+ * ################################################################### */
+
+/*
+ * passes and global_held of a cohort are only accessed by the holder of
+ * its local lock. A thread whose predecessor in the cohort kept the
+ * global lock finds global_held set and does not take it again.
+ */
+typedef struct cohort_lock {
+  ticket_lock_t global;
+  struct {
+    ticket_lock_t local;
+    uint32_t passes;
+    uint32_t global_held;
+  } cohort[COHORT_NODES];
+} cohort_lock_t;
+
+#ifdef LOCK_COHORT
+/* NUMA node of the calling thread, looked up once */
+static inline int lock_cohort_id(void)
+{
+  unsigned int cpu, node;
+
+  if (lock_cohort < 0) {
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+      node = 0;
+    lock_cohort = node % COHORT_NODES;
+  }
+  return lock_cohort;
+}
+
+static inline int cohort_init(cohort_lock_t *l)
+{
+  int i;
+
+  ticket_init(&l->global);
+  for (i = 0; i < COHORT_NODES; i++) {
+    ticket_init(&l->cohort[i].local);
+    l->cohort[i].passes = 0;
+    l->cohort[i].global_held = 0;
+  }
+  return 0;
+}
+
+static inline int cohort_lock(cohort_lock_t *l)
+{
+  int c = lock_cohort_id();
+
+  ticket_lock(&l->cohort[c].local);
+  if (!l->cohort[c].global_held) {
+    ticket_lock(&l->global);
+    l->cohort[c].global_held = 1;
+  }
+  return 0;
+}
+
+static inline int cohort_trylock(cohort_lock_t *l)
+{
+  int c = lock_cohort_id();
+
+  if (ticket_trylock(&l->cohort[c].local) != 0)
+    return EBUSY;
+  if (!l->cohort[c].global_held) {
+    if (ticket_trylock(&l->global) != 0) {
+      ticket_unlock(&l->cohort[c].local);
+      return EBUSY;
+    }
+    l->cohort[c].global_held = 1;
+  }
+  return 0;
+}
+
+static inline int cohort_unlock(cohort_lock_t *l)
+{
+  int c = lock_cohort_id();
+
+  if (ticket_waiters(&l->cohort[c].local) &&
+      l->cohort[c].passes < COHORT_MAX_PASSES) {
+    l->cohort[c].passes++;
+  } else {
+    l->cohort[c].passes = 0;
+    l->cohort[c].global_held = 0;
+    ticket_unlock(&l->global);
+  }
+  ticket_unlock(&l->cohort[c].local);
+  return 0;
+}
+#endif
+
+/* ################################################################### *
+ * FUTEX
+ * ################################################################### */
+
+/* 0: free, 1: taken, 2: taken and threads may be parked */
+typedef uint32_t futex_lock_t;
+
+#ifdef LOCK_FUTEX
+static inline int futex_init(futex_lock_t *l)
+{
+  *(volatile futex_lock_t *)l = 0;
+  return 0;
+}
+
+static inline int futex_trylock(futex_lock_t *l)
+{
+  return __sync_bool_compare_and_swap(l, 0, 1) ? 0 : EBUSY;
+}
+
+static inline int futex_lock(futex_lock_t *l)
+{
+  volatile futex_lock_t *v = l;
+  int i;
+
+  for (i = 0; i < FUTEX_SPINS; i++) {
+    if (*v == 0 && __sync_bool_compare_and_swap(v, 0, 1))
+      return 0;
+    LOCK_RELAX();
+  }
+  while (__atomic_exchange_n(v, 2, __ATOMIC_ACQUIRE) != 0)
+    syscall(SYS_futex, v, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+  return 0;
+}
+
+static inline int futex_unlock(futex_lock_t *l)
+{
+  if (__sync_fetch_and_sub(l, 1) != 1) {
+    LOCK_STORE_REL(l, 0);
+    syscall(SYS_futex, l, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+  }
+  return 0;
+}
+#endif
+
+/* ################################################################### *
+ * SELECTION
+ * ################################################################### */
+
+#if defined(LOCK_TTAS)
+typedef ttas_lock_t ptlock_t;
+#  define LOCK_NAME                     "ttas"
+#  define INIT_LOCK(lock)               ttas_init((ptlock_t *) (lock))
+#  define DESTROY_LOCK(lock)            ((void) (lock), 0)
+#  define LOCK(lock)                    ttas_lock((ptlock_t *) (lock))
+#  define TRYLOCK(lock)                 ttas_trylock((ptlock_t *) (lock))
+#  define UNLOCK(lock)                  ttas_unlock((ptlock_t *) (lock))
+#elif defined(LOCK_TICKET)
+typedef ticket_lock_t ptlock_t;
+#  define LOCK_NAME                     "ticket"
+#  define INIT_LOCK(lock)               ticket_init((ptlock_t *) (lock))
+#  define DESTROY_LOCK(lock)            ((void) (lock), 0)
+#  define LOCK(lock)                    ticket_lock((ptlock_t *) (lock))
+#  define TRYLOCK(lock)                 ticket_trylock((ptlock_t *) (lock))
+#  define UNLOCK(lock)                  ticket_unlock((ptlock_t *) (lock))
+#elif defined(LOCK_MCS)
+typedef mcs_lock_t ptlock_t;
+#  define LOCK_NAME                     "mcs"
+#  define INIT_LOCK(lock)               mcs_init((ptlock_t *) (lock))
+#  define DESTROY_LOCK(lock)            ((void) (lock), 0)
+#  define LOCK(lock)                    mcs_lock((ptlock_t *) (lock))
+#  define TRYLOCK(lock)                 mcs_trylock((ptlock_t *) (lock))
+#  define UNLOCK(lock)                  mcs_unlock((ptlock_t *) (lock))
+#elif defined(LOCK_CLH)
+typedef clh_lock_t ptlock_t;
+#  define LOCK_NAME                     "clh"
+#  define INIT_LOCK(lock)               clh_init((ptlock_t *) (lock))
+#  define DESTROY_LOCK(lock)            clh_destroy((ptlock_t *) (lock))
+#  define LOCK(lock)                    clh_lock((ptlock_t *) (lock))
+#  define TRYLOCK(lock)                 clh_trylock((ptlock_t *) (lock))
+#  define UNLOCK(lock)                  clh_unlock((ptlock_t *) (lock))
+#elif defined(LOCK_COHORT)
+typedef cohort_lock_t ptlock_t;
+#  define LOCK_NAME                     "cohort"
+#  define INIT_LOCK(lock)               cohort_init((ptlock_t *) (lock))
+#  define DESTROY_LOCK(lock)            ((void) (lock), 0)
+#  define LOCK(lock)                    cohort_lock((ptlock_t *) (lock))
+#  define TRYLOCK(lock)                 cohort_trylock((ptlock_t *) (lock))
+#  define UNLOCK(lock)                  cohort_unlock((ptlock_t *) (lock))
+#elif defined(LOCK_FUTEX)
+typedef futex_lock_t ptlock_t;
+#  define LOCK_NAME                     "futex"
+#  define INIT_LOCK(lock)               futex_init((ptlock_t *) (lock))
+#  define DESTROY_LOCK(lock)            ((void) (lock), 0)
+#  define LOCK(lock)                    futex_lock((ptlock_t *) (lock))
+#  define TRYLOCK(lock)                 futex_trylock((ptlock_t *) (lock))
+#  define UNLOCK(lock)                  futex_unlock((ptlock_t *) (lock))
+#elif defined(MUTEX)
+typedef pthread_mutex_t ptlock_t;
+#  define LOCK_NAME                     "mutex"
+#  define INIT_LOCK(lock)               pthread_mutex_init((pthread_mutex_t *) (lock), NULL)
+#  define DESTROY_LOCK(lock)            pthread_mutex_destroy((pthread_mutex_t *) (lock))
+#  define LOCK(lock)                    pthread_mutex_lock((pthread_mutex_t *) (lock))
+#  define TRYLOCK(lock)                 pthread_mutex_trylock((pthread_mutex_t *) (lock))
+#  define UNLOCK(lock)                  pthread_mutex_unlock((pthread_mutex_t *) (lock))
+#else
+typedef pthread_spinlock_t ptlock_t;
+#  define LOCK_NAME                     "spin"
+#  define INIT_LOCK(lock)               pthread_spin_init((pthread_spinlock_t *) (lock), PTHREAD_PROCESS_PRIVATE)
+#  define DESTROY_LOCK(lock)            pthread_spin_destroy((pthread_spinlock_t *) (lock))
+#  define LOCK(lock)                    pthread_spin_lock((pthread_spinlock_t *) (lock))
+#  define TRYLOCK(lock)                 pthread_spin_trylock((pthread_spinlock_t *) (lock))
+#  define UNLOCK(lock)                  pthread_spin_unlock((pthread_spinlock_t *) (lock))
+#endif
+
+#endif /* LOCKS_H */
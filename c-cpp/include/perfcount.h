@@ -0,0 +1,141 @@
+/*
+ * File:
+ *   perfcount.h
+ * Description:
+ *   Hardware event counters around the measured part of a run.
+ *
+ *   Built with PERF=1, a harness opens the counters right before creating
+ *   its worker threads (perf_start), so that the workers inherit them, and
+ *   reads them once the workers are joined (perf_stop). Only user-space
+ *   events of the process are counted, which perf_event_paranoid <= 2
+ *   allows. Counters the CPU or the hypervisor do not expose are reported
+ *   as unavailable, and when the kernel multiplexes them the counts are
+ *   scaled by the fraction of time they were scheduled, like perf stat.
+ *
+ * perfcount.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+#ifdef PERF_COUNTERS
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define PERF_CACHE(c, op, res)          ((c) | ((op) << 8) | ((res) << 16))
+
+typedef struct perf_counter {
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+  int fd;
+  int opened;
+  double value;
+} perf_counter_t;
+
+static perf_counter_t perf_counters[] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1, 0, 0 },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1, 0, 0 },
+  { "L1d misses", PERF_TYPE_HW_CACHE,
+    PERF_CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+	       PERF_COUNT_HW_CACHE_RESULT_MISS), -1, 0, 0 },
+  { "LLC misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1, 0, 0 },
+  { "dTLB misses", PERF_TYPE_HW_CACHE,
+    PERF_CACHE(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+	       PERF_COUNT_HW_CACHE_RESULT_MISS), -1, 0, 0 },
+};
+
+#define PERF_NB_COUNTERS                (sizeof(perf_counters) / sizeof(perf_counters[0]))
+
+static int perf_errno;
+
+static inline void perf_start(void)
+{
+  struct perf_event_attr attr;
+  unsigned int i;
+
+  for (i = 0; i < PERF_NB_COUNTERS; i++) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perf_counters[i].type;
+    attr.config = perf_counters[i].config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    perf_counters[i].fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perf_counters[i].fd < 0) {
+      perf_errno = errno;
+      continue;
+    }
+    perf_counters[i].opened = 1;
+    ioctl(perf_counters[i].fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+/* Inherited counts are only added to the parent once the children exit */
+static inline void perf_stop(void)
+{
+  uint64_t buf[3];
+  unsigned int i;
+
+  for (i = 0; i < PERF_NB_COUNTERS; i++) {
+    if (perf_counters[i].fd < 0)
+      continue;
+    ioctl(perf_counters[i].fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(perf_counters[i].fd, buf, sizeof(buf)) == sizeof(buf) && buf[2] > 0)
+      perf_counters[i].value = (double)buf[0] * buf[1] / buf[2];
+    close(perf_counters[i].fd);
+    perf_counters[i].fd = -1;
+  }
+}
+
+/* Prints every counter in total and per operation */
+static inline void perf_print_stats(unsigned long ops)
+{
+  unsigned int i, opened = 0;
+
+  for (i = 0; i < PERF_NB_COUNTERS; i++)
+    opened += perf_counters[i].opened;
+  if (opened == 0) {
+    printf("Perf counters : unavailable (%s)\n", strerror(perf_errno));
+    return;
+  }
+  printf("Perf counters : user space, all threads\n");
+  for (i = 0; i < PERF_NB_COUNTERS; i++) {
+    if (!perf_counters[i].opened)
+      printf("  #%-11s: unavailable\n", perf_counters[i].name);
+    else
+      printf("  #%-11s: %.0f (%.3f / op)\n", perf_counters[i].name,
+	     perf_counters[i].value, ops ? perf_counters[i].value / ops : 0.0);
+  }
+}
+
+#  define PERF_START()                  perf_start()
+#  define PERF_STOP()                   perf_stop()
+#  define PERF_PRINT_STATS(ops)         perf_print_stats(ops)
+#else
+#  define PERF_START()
+#  define PERF_STOP()
+#  define PERF_PRINT_STATS(ops)
+#endif /* PERF_COUNTERS */
+
+#endif /* PERFCOUNT_H */
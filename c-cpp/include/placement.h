@@ -0,0 +1,228 @@
+/*
+ * File:
+ *   placement.h
+ * Description:
+ *   Cache-line aware node placement and false-sharing estimation.
+ *
+ *   Three placement policies are selected at compile time with
+ *   PLACEMENT=PACKED|ALIGNED|PADDED:
+ *    - packed:  nodes have their natural size and whatever alignment the
+ *               allocator gives (the default), so several small nodes
+ *               share a cache line and larger ones may straddle two;
+ *    - aligned: nodes are aligned to their size rounded up to a power of
+ *               two (at most a cache line), so a node never straddles two
+ *               lines, but small nodes still share one;
+ *    - padded:  nodes are rounded up to whole cache lines, so the hot
+ *               fields of a node (next pointers, marks, lock) never share
+ *               a line with another node.
+ *
+ *   Setting PLACEMENT also enables a simulated false-sharing check: every
+ *   write to a shared node word (CAS attempt, lock acquisition, pointer
+ *   store) is recorded in a small table indexed by cache line, and
+ *   sampled traversal reads look up the line they touch. A read of a line
+ *   last written by another thread at an address outside the node being
+ *   read is counted as a false-sharing hit; a write to the node itself is
+ *   counted as true sharing. Like perf c2c, this is an estimate: the
+ *   table is direct-mapped and updated without synchronisation.
+ *
+ * placement.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifndef CACHE_LINE_SIZE
+#  define CACHE_LINE_SIZE               64
+#endif
+
+#if defined(PLACEMENT_PADDED)
+#  define PLACEMENT_NAME                "padded"
+#elif defined(PLACEMENT_ALIGNED)
+#  define PLACEMENT_NAME                "aligned"
+#else
+#  define PLACEMENT_NAME                "packed"
+#endif
+
+/* Alignment a node of @size bytes gets under the current policy */
+static inline size_t placement_align(size_t size)
+{
+#if defined(PLACEMENT_PADDED)
+  return CACHE_LINE_SIZE;
+#elif defined(PLACEMENT_ALIGNED)
+  size_t a = sizeof(void *);
+
+  while (a < size && a < CACHE_LINE_SIZE)
+    a <<= 1;
+  return a;
+#else
+  return sizeof(void *);
+#endif
+}
+
+/*
+ * Bytes a node of @size bytes occupies under the current policy, also
+ * used as the block stride by allocators carving nodes out of chunks.
+ */
+static inline size_t placement_size(size_t size)
+{
+  size_t a = placement_align(size);
+
+  return (size + a - 1) & ~(a - 1);
+}
+
+static inline void *placement_alloc(size_t size)
+{
+#if defined(PLACEMENT_PADDED) || defined(PLACEMENT_ALIGNED)
+  void *p;
+
+  if (posix_memalign(&p, placement_align(size), placement_size(size)) != 0)
+    return NULL;
+  return p;
+#else
+  return malloc(size);
+#endif
+}
+
+#ifdef FS_STATS
+
+#define FS_TABLE_BITS                   12
+#define FS_TABLE_SIZE                   (1 << FS_TABLE_BITS)
+/* One traversal read out of FS_SAMPLE is checked against the table */
+#define FS_SAMPLE                       8
+
+typedef struct fs_line {
+  volatile uintptr_t line;
+  volatile uintptr_t addr;
+  volatile unsigned long seq;
+  volatile unsigned long tid;
+} fs_line_t;
+
+typedef struct fs_counters {
+  unsigned long tid;
+  unsigned long tick;
+  unsigned long writes;
+  unsigned long reads;
+  unsigned long false_hits;
+  unsigned long true_hits;
+} fs_counters_t;
+
+extern fs_line_t fs_table[FS_TABLE_SIZE];
+extern __thread unsigned long fs_seen[FS_TABLE_SIZE];
+extern __thread fs_counters_t fs_local;
+extern fs_counters_t fs_total;
+extern pthread_mutex_t fs_total_lock;
+extern volatile unsigned long fs_next_tid;
+
+/* Instantiates the table and totals, in exactly one file per benchmark */
+#define FS_STATS_DEFINE                                                 \
+  fs_line_t fs_table[FS_TABLE_SIZE];                                    \
+  __thread unsigned long fs_seen[FS_TABLE_SIZE];                        \
+  __thread fs_counters_t fs_local;                                      \
+  fs_counters_t fs_total;                                               \
+  pthread_mutex_t fs_total_lock = PTHREAD_MUTEX_INITIALIZER;           \
+  volatile unsigned long fs_next_tid;
+
+static inline unsigned long fs_tid(void)
+{
+  if (fs_local.tid == 0)
+    fs_local.tid = __sync_add_and_fetch(&fs_next_tid, 1);
+  return fs_local.tid;
+}
+
+static inline fs_line_t *fs_slot(uintptr_t line)
+{
+  return &fs_table[(line ^ (line >> FS_TABLE_BITS)) & (FS_TABLE_SIZE - 1)];
+}
+
+/* Records a write to the shared word at @addr */
+static inline void fs_write(const volatile void *addr)
+{
+  uintptr_t line = (uintptr_t)addr / CACHE_LINE_SIZE;
+  fs_line_t *e = fs_slot(line);
+
+  e->line = line;
+  e->addr = (uintptr_t)addr;
+  e->tid = fs_tid();
+  e->seq++;
+  fs_local.writes++;
+}
+
+/*
+ * Checks a traversal read of @addr, a word of the @len bytes node at
+ * @node, against the last write to the same line. Each write is charged
+ * at most once per reading thread.
+ */
+static inline void fs_read(const volatile void *addr,
+			   const volatile void *node, size_t len)
+{
+  uintptr_t line = (uintptr_t)addr / CACHE_LINE_SIZE;
+  fs_line_t *e;
+  unsigned long seq;
+
+  if (++fs_local.tick % FS_SAMPLE)
+    return;
+  fs_local.reads++;
+  e = fs_slot(line);
+  seq = e->seq;
+  if (e->line != line || seq == fs_seen[e - fs_table])
+    return;
+  fs_seen[e - fs_table] = seq;
+  if (e->tid == fs_tid())
+    return;
+  if (e->addr >= (uintptr_t)node && e->addr < (uintptr_t)node + len)
+    fs_local.true_hits++;
+  else
+    fs_local.false_hits++;
+}
+
+/* Folds the calling thread's counters into the totals */
+static inline void fs_thread_exit(void)
+{
+  pthread_mutex_lock(&fs_total_lock);
+  fs_total.writes += fs_local.writes;
+  fs_total.reads += fs_local.reads;
+  fs_total.false_hits += fs_local.false_hits;
+  fs_total.true_hits += fs_local.true_hits;
+  pthread_mutex_unlock(&fs_total_lock);
+}
+
+static inline void fs_print_stats(size_t node_size)
+{
+  printf("Placement     : %s (%lu B/node, %d B/line)\n", PLACEMENT_NAME,
+	 (unsigned long)placement_size(node_size), CACHE_LINE_SIZE);
+  printf("  #writes     : %lu\n", fs_total.writes);
+  printf("  #reads      : %lu (1/%d sampled)\n", fs_total.reads, FS_SAMPLE);
+  printf("  #false-share: %lu (%.3f%% of sampled reads)\n",
+	 fs_total.false_hits,
+	 fs_total.reads ? 100.0 * fs_total.false_hits / fs_total.reads : 0.0);
+  printf("  #true-share : %lu (%.3f%% of sampled reads)\n",
+	 fs_total.true_hits,
+	 fs_total.reads ? 100.0 * fs_total.true_hits / fs_total.reads : 0.0);
+}
+
+#  define FS_READ(addr, node, len)      fs_read((addr), (node), (len))
+#  define FS_WRITE(addr)                fs_write((addr))
+#  define FS_THREAD_EXIT()              fs_thread_exit()
+#else
+#  define FS_STATS_DEFINE
+#  define FS_READ(addr, node, len)
+#  define FS_WRITE(addr)
+#  define FS_THREAD_EXIT()
+#endif /* FS_STATS */
+
+#endif /* PLACEMENT_H */
@@ -0,0 +1,456 @@
+/*
+ * File:
+ *   cuckoo.c
+ * Description:
+ *   Concurrent bucketized cuckoo hash set after libcuckoo
+ *   "Algorithmic Improvements for Fast Concurrent Cuckoo Hashing"
+ *   X. Li, D. G. Andersen, M. Kaminsky, M. J. Freedman, EuroSys 2014.
+ *
+ *   A key lives in one of the CK_SLOTS slots of either of its two
+ *   buckets, so a lookup reads at most two buckets. Writers lock the
+ *   stripes of both buckets. When both are full, a breadth-first search
+ *   looks for a short path of keys that can each move to their other
+ *   bucket and end in a free slot; the path is then applied from its end,
+ *   one move at a time under the locks of the two buckets involved, and
+ *   the insertion starts over. When no path exists the table doubles,
+ *   with every stripe locked.
+ *
+ * cuckoo.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "cuckoo.h"
+
+LOCKS_DEFINE
+
+typedef struct ck_step {
+	unsigned long bucket;
+	int slot;
+	uint64_t word;
+} ck_step_t;
+
+typedef struct ck_entry {
+	unsigned long bucket;
+	unsigned int pathcode;          /* root bucket, then one slot per level */
+	int depth;
+} ck_entry_t;
+
+static inline uint64_t ck_hash(uint32_t key) {
+	return (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+}
+
+static inline unsigned long ck_index(ck_table_t *t, uint32_t key) {
+	return (unsigned long)(ck_hash(key) >> (64 - t->bits));
+}
+
+/* The other bucket of key, an involution as in libcuckoo */
+static inline unsigned long ck_alt(ck_table_t *t, unsigned long b, uint32_t key) {
+	uint64_t tag = ((ck_hash(key) >> 24) & 0xFF) + 1;
+
+	return (b ^ (tag * 0xC6A4A7935BD1E995ULL)) & (t->nb_buckets - 1);
+}
+
+static inline ck_stripe_t *ck_stripe(ht_intset_t *set, unsigned long b) {
+	return &set->stripes[b & (CK_STRIPES - 1)];
+}
+
+static inline int ck_find(ck_bucket_t *b, uint32_t key) {
+	int i;
+
+	for (i = 0; i < CK_SLOTS; i++)
+		if (b->slots[i] == (CK_FULL | key))
+			return i;
+	return -1;
+}
+
+static inline int ck_free_slot(ck_bucket_t *b) {
+	int i;
+
+	for (i = 0; i < CK_SLOTS; i++)
+		if (b->slots[i] == 0)
+			return i;
+	return -1;
+}
+
+static void ck_lock(ht_intset_t *set, ck_stripe_t *s) {
+	if (TRYLOCK(&s->lock) != 0) {
+		AO_fetch_and_add1(&set->nb_lock_waits);
+		LOCK(&s->lock);
+	}
+	AO_fetch_and_add1_full(&s->version);
+}
+
+static void ck_unlock(ck_stripe_t *s) {
+	AO_fetch_and_add1_full(&s->version);
+	UNLOCK(&s->lock);
+}
+
+/* Locks the stripes of buckets b1 and b2 in address order */
+static void ck_lock2(ht_intset_t *set, unsigned long b1, unsigned long b2) {
+	ck_stripe_t *s1 = ck_stripe(set, b1), *s2 = ck_stripe(set, b2), *tmp;
+
+	if (s1 > s2) {
+		tmp = s1; s1 = s2; s2 = tmp;
+	}
+	ck_lock(set, s1);
+	if (s2 != s1)
+		ck_lock(set, s2);
+}
+
+static void ck_unlock2(ht_intset_t *set, unsigned long b1, unsigned long b2) {
+	ck_stripe_t *s1 = ck_stripe(set, b1), *s2 = ck_stripe(set, b2);
+
+	if (s2 != s1)
+		ck_unlock(s2);
+	ck_unlock(s1);
+}
+
+/*
+ * Locks both buckets of key in the current table, which it returns;
+ * a resize in between makes it start over with the new table.
+ */
+static ck_table_t *ck_lock_key(ht_intset_t *set, uint32_t key,
+															 unsigned long *b1, unsigned long *b2) {
+	ck_table_t *t;
+
+	do {
+		t = set->table;
+		*b1 = ck_index(t, key);
+		*b2 = ck_alt(t, *b1, key);
+		ck_lock2(set, *b1, *b2);
+		if (set->table == t)
+			return t;
+		ck_unlock2(set, *b1, *b2);
+	} while (1);
+}
+
+static ck_table_t *ck_table_new(unsigned int bits) {
+	ck_table_t *t;
+
+	if ((t = (ck_table_t *)malloc(sizeof(ck_table_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	t->bits = bits;
+	t->nb_buckets = 1UL << bits;
+	t->old = NULL;
+	if ((t->buckets = (ck_bucket_t *)calloc(t->nb_buckets, sizeof(ck_bucket_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	return t;
+}
+
+/*
+ * Breadth-first search for a free slot reachable from b1 or b2 by
+ * moving at most CK_MAX_DEPTH - 1 keys. The buckets are read without
+ * locks, the moves check that the path still holds. Returns the index
+ * of the free slot in path, or -1.
+ */
+static int ck_search(ck_table_t *t, unsigned long b1, unsigned long b2,
+										 ck_step_t *path) {
+	ck_entry_t queue[CK_BFS_QUEUE], e;
+	int head = 0, tail = 0, i, s, depth = -1;
+	unsigned int code = 0;
+	uint64_t w;
+
+	queue[tail].bucket = b1; queue[tail].pathcode = 0; queue[tail++].depth = 0;
+	queue[tail].bucket = b2; queue[tail].pathcode = 1; queue[tail++].depth = 0;
+	while (head < tail && depth < 0) {
+		e = queue[head++];
+		for (s = 0; s < CK_SLOTS; s++) {
+			w = t->buckets[e.bucket].slots[s];
+			if (w == 0) {
+				code = e.pathcode * CK_SLOTS + s;
+				depth = e.depth;
+				break;
+			}
+			if (e.depth < CK_MAX_DEPTH - 1 && tail < CK_BFS_QUEUE) {
+				queue[tail].bucket = ck_alt(t, e.bucket, CK_KEY(w));
+				queue[tail].pathcode = e.pathcode * CK_SLOTS + s;
+				queue[tail++].depth = e.depth + 1;
+			}
+		}
+	}
+	if (depth < 0)
+		return -1;
+	/* Unwind the pathcode into the slots visited, root bucket last */
+	for (i = depth; i >= 0; i--) {
+		path[i].slot = code % CK_SLOTS;
+		code /= CK_SLOTS;
+	}
+	path[0].bucket = code ? b2 : b1;
+	for (i = 0; i < depth; i++) {
+		w = path[i].word = t->buckets[path[i].bucket].slots[path[i].slot];
+		if (w == 0)
+			return i;
+		path[i + 1].bucket = ck_alt(t, path[i].bucket, CK_KEY(w));
+	}
+	return depth;
+}
+
+/*
+ * Frees a slot in b1 or b2 by moving keys along a cuckoo path. Returns 0
+ * when there is no such path, 1 otherwise, even if the path went stale
+ * halfway: the caller retries either way.
+ */
+static int ck_cuckoo(ht_intset_t *set, ck_table_t *t, unsigned long b1, unsigned long b2) {
+	ck_step_t path[CK_MAX_DEPTH];
+	ck_bucket_t *from, *to;
+	int depth, i;
+	AO_t max;
+
+	if ((depth = ck_search(t, b1, b2, path)) < 0)
+		return 0;
+	for (i = depth; i > 0; i--) {
+		ck_lock2(set, path[i - 1].bucket, path[i].bucket);
+		from = &t->buckets[path[i - 1].bucket];
+		to = &t->buckets[path[i].bucket];
+		if (set->table != t || to->slots[path[i].slot] != 0 ||
+				from->slots[path[i - 1].slot] != path[i - 1].word) {
+			ck_unlock2(set, path[i - 1].bucket, path[i].bucket);
+			AO_fetch_and_add1(&set->nb_path_aborts);
+			return 1;
+		}
+		to->slots[path[i].slot] = path[i - 1].word;
+		from->slots[path[i - 1].slot] = 0;
+		ck_unlock2(set, path[i - 1].bucket, path[i].bucket);
+	}
+	if (depth > 0) {
+		AO_fetch_and_add1(&set->nb_paths);
+		AO_fetch_and_add(&set->path_length, depth);
+		while ((max = set->max_path) < (AO_t)depth &&
+					 !AO_compare_and_swap(&set->max_path, max, depth));
+	}
+	return 1;
+}
+
+/* Sequential insertion into a table under construction */
+static int ck_place(ck_table_t *t, uint64_t w) {
+	unsigned long b = ck_index(t, CK_KEY(w)), alt;
+	uint64_t victim;
+	int i, kick;
+
+	for (kick = 0; kick < CK_MAX_KICKS; kick++) {
+		if ((i = ck_free_slot(&t->buckets[b])) >= 0) {
+			t->buckets[b].slots[i] = w;
+			return 1;
+		}
+		alt = ck_alt(t, b, CK_KEY(w));
+		if ((i = ck_free_slot(&t->buckets[alt])) >= 0) {
+			t->buckets[alt].slots[i] = w;
+			return 1;
+		}
+		/* Evict a victim of alt and carry it to its other bucket */
+		i = kick % CK_SLOTS;
+		victim = t->buckets[alt].slots[i];
+		t->buckets[alt].slots[i] = w;
+		w = victim;
+		b = ck_alt(t, alt, CK_KEY(w));
+	}
+	return 0;
+}
+
+/* Doubles t unless another thread replaced it already */
+static void ck_resize(ht_intset_t *set, ck_table_t *t) {
+	ck_table_t *n = NULL;
+	unsigned long b, live = 0;
+	unsigned int bits;
+	int i, ok;
+
+	for (i = 0; i < CK_STRIPES; i++)
+		ck_lock(set, &set->stripes[i]);
+	if (set->table == t) {
+		for (b = 0; b < t->nb_buckets; b++)
+			for (i = 0; i < CK_SLOTS; i++)
+				if (t->buckets[b].slots[i] != 0)
+					live++;
+		for (bits = t->bits + 1, ok = 0; !ok; bits++) {
+			if (bits > CK_MAX_BITS) {
+				fprintf(stderr, "Cuckoo table full (%lu buckets), use a smaller range\n",
+								t->nb_buckets);
+				exit(1);
+			}
+			n = ck_table_new(bits);
+			ok = 1;
+			for (b = 0; b < t->nb_buckets && ok; b++)
+				for (i = 0; i < CK_SLOTS && ok; i++)
+					if (t->buckets[b].slots[i] != 0)
+						ok = ck_place(n, t->buckets[b].slots[i]);
+			if (!ok) {
+				free(n->buckets);
+				free(n);
+			}
+		}
+		n->old = t;
+		AO_store_full((volatile AO_t *)&set->table, (AO_t)n);
+		AO_fetch_and_add1(&set->nb_resizes);
+		AO_fetch_and_add(&set->resize_load, live * 1000 / (t->nb_buckets * CK_SLOTS));
+	}
+	for (i = CK_STRIPES - 1; i >= 0; i--)
+		ck_unlock(&set->stripes[i]);
+}
+
+/*
+ * The table starts with enough buckets for nb_keys keys, and at least
+ * two buckets.
+ */
+ht_intset_t *ht_new(unsigned long nb_keys) {
+	ht_intset_t *set;
+	unsigned int bits = 1;
+	int i;
+
+	if (posix_memalign((void **)&set, sizeof(ck_stripe_t), sizeof(ht_intset_t)) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+	memset(set, 0, sizeof(ht_intset_t));
+	while ((1UL << bits) * CK_SLOTS < nb_keys && bits < CK_MAX_BITS)
+		bits++;
+	set->table = ck_table_new(bits);
+	set->initial_buckets = set->table->nb_buckets;
+	for (i = 0; i < CK_STRIPES; i++)
+		INIT_LOCK(&set->stripes[i].lock);
+	return set;
+}
+
+void ht_delete(ht_intset_t *set) {
+	ck_table_t *t, *old;
+	int i;
+
+	for (t = set->table; t != NULL; t = old) {
+		old = t->old;
+		free(t->buckets);
+		free(t);
+	}
+	for (i = 0; i < CK_STRIPES; i++)
+		DESTROY_LOCK(&set->stripes[i].lock);
+	free(set);
+}
+
+int ht_size(ht_intset_t *set) {
+	ck_table_t *t = set->table;
+	unsigned long b;
+	int i, size = 0;
+
+	for (b = 0; b < t->nb_buckets; b++)
+		for (i = 0; i < CK_SLOTS; i++)
+			if (t->buckets[b].slots[i] != 0)
+				size++;
+	return size;
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	ck_table_t *t;
+	ck_stripe_t *s1, *s2;
+	unsigned long b1, b2;
+	AO_t v1, v2;
+	int found;
+
+	do {
+		t = set->table;
+		b1 = ck_index(t, val);
+		b2 = ck_alt(t, b1, val);
+		s1 = ck_stripe(set, b1);
+		s2 = ck_stripe(set, b2);
+		v1 = AO_load_full(&s1->version);
+		v2 = AO_load_full(&s2->version);
+		if (!((v1 | v2) & 1)) {
+			found = ck_find(&t->buckets[b1], val) >= 0 ||
+				ck_find(&t->buckets[b2], val) >= 0;
+			AO_nop_full();
+			if (s1->version == v1 && s2->version == v2 && set->table == t)
+				return found;
+		}
+		AO_fetch_and_add1(&set->nb_read_retries);
+	} while (1);
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	ck_table_t *t;
+	unsigned long b1, b2;
+	int i;
+
+	do {
+		t = ck_lock_key(set, val, &b1, &b2);
+		if (ck_find(&t->buckets[b1], val) >= 0 || ck_find(&t->buckets[b2], val) >= 0) {
+			ck_unlock2(set, b1, b2);
+			return 0;
+		}
+		if ((i = ck_free_slot(&t->buckets[b1])) >= 0) {
+			t->buckets[b1].slots[i] = CK_FULL | (uint32_t)val;
+			ck_unlock2(set, b1, b2);
+			return 1;
+		}
+		if ((i = ck_free_slot(&t->buckets[b2])) >= 0) {
+			t->buckets[b2].slots[i] = CK_FULL | (uint32_t)val;
+			ck_unlock2(set, b1, b2);
+			return 1;
+		}
+		ck_unlock2(set, b1, b2);
+		if (!ck_cuckoo(set, t, b1, b2))
+			ck_resize(set, t);
+	} while (1);
+}
+
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	ck_table_t *t;
+	unsigned long b1, b2;
+	int i, result = 1;
+
+	t = ck_lock_key(set, val, &b1, &b2);
+	if ((i = ck_find(&t->buckets[b1], val)) >= 0)
+		t->buckets[b1].slots[i] = 0;
+	else if ((i = ck_find(&t->buckets[b2], val)) >= 0)
+		t->buckets[b2].slots[i] = 0;
+	else
+		result = 0;
+	ck_unlock2(set, b1, b2);
+	return result;
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No cuckoo implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No cuckoo implementation is available\n");
+	exit(1);
+}
+
+void ht_print_stats(ht_intset_t *set) {
+	ck_table_t *t = set->table;
+
+	printf("Buckets       : %lu x %d slots (initial %lu, %lu resizes)\n",
+				 t->nb_buckets, CK_SLOTS, set->initial_buckets,
+				 (unsigned long)set->nb_resizes);
+	printf("  #load       : %.1f%% now, %.1f%% avg when resizing\n",
+				 100.0 * ht_size(set) / (t->nb_buckets * CK_SLOTS),
+				 set->nb_resizes ? set->resize_load / 10.0 / set->nb_resizes : 0.0);
+	printf("  #paths      : %lu (%.2f keys moved avg, %lu max, %lu aborted)\n",
+				 (unsigned long)set->nb_paths,
+				 set->nb_paths ? (double)set->path_length / set->nb_paths : 0.0,
+				 (unsigned long)set->max_path, (unsigned long)set->nb_path_aborts);
+	printf("  #lock waits : %lu\n", (unsigned long)set->nb_lock_waits);
+	printf("  #read retry : %lu\n", (unsigned long)set->nb_read_retries);
+}
@@ -0,0 +1,129 @@
+/*
+ * File:
+ *   cuckoo.h
+ * Description:
+ *   Concurrent bucketized cuckoo hash set after libcuckoo
+ *   "Algorithmic Improvements for Fast Concurrent Cuckoo Hashing"
+ *   X. Li, D. G. Andersen, M. Kaminsky, M. J. Freedman, EuroSys 2014.
+ *
+ * cuckoo.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <atomic_ops.h>
+
+#include "locks.h"
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_ELASTICITY              2
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+
+#define MAXHTLENGTH                     65536
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+
+/* ################################################################### *
+ * CUCKOO HASH TABLE
+ * ################################################################### */
+
+/*
+ * Every key has two candidate buckets of CK_SLOTS slots each. A slot
+ * word holds CK_FULL | key, or 0 when the slot is free.
+ */
+#define CK_SLOTS                        4
+#define CK_FULL                         (1ULL << 32)
+#define CK_KEY(w)                       ((uint32_t)(w))
+
+/* Writers lock the stripes of both buckets of a key, in index order */
+#define CK_STRIPES                      2048
+
+/* Longest displacement path and breadth of its search (libcuckoo's) */
+#define CK_MAX_DEPTH                    5
+#define CK_BFS_QUEUE                    512
+
+/* Evictions tried per key when rehashing into a larger table */
+#define CK_MAX_KICKS                    500
+#define CK_MAX_BITS                     26
+
+typedef struct ck_bucket {
+  volatile uint64_t slots[CK_SLOTS];
+} ck_bucket_t;
+
+typedef struct ck_table {
+  ck_bucket_t *buckets;
+  unsigned long nb_buckets;       /* a power of two */
+  unsigned int bits;
+  struct ck_table *old;           /* replaced tables, freed with the set */
+} ck_table_t;
+
+/*
+ * A lock with a version counter that is odd while the lock is held.
+ * Readers take no lock: they read the versions of both stripes, the two
+ * buckets, then the versions again, and retry if anything changed.
+ */
+typedef struct ck_stripe {
+  ptlock_t lock;
+  volatile AO_t version;
+} __attribute__((aligned(64))) ck_stripe_t;
+
+typedef struct ht_intset {
+  ck_table_t *volatile table;
+  ck_stripe_t stripes[CK_STRIPES];
+  unsigned long initial_buckets;
+  volatile AO_t nb_resizes;
+  volatile AO_t resize_load;      /* sum of per-mille loads at resizes */
+  volatile AO_t nb_paths;
+  volatile AO_t path_length;
+  volatile AO_t max_path;
+  volatile AO_t nb_path_aborts;
+  volatile AO_t nb_lock_waits;
+  volatile AO_t nb_read_retries;
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(unsigned long nb_keys);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
@@ -0,0 +1,401 @@
+/*
+ * File:
+ *   hopscotch.c
+ * Description:
+ *   Concurrent hopscotch hash set
+ *   "Hopscotch Hashing"
+ *   M. Herlihy, N. Shavit, M. Tzafrir, DISC 2008.
+ *
+ *   A key lives within HS_HOP buckets of its home bucket, so a lookup
+ *   reads the hop bitmap of the home bucket and only the buckets it
+ *   points to, one or two cache lines. An insertion probes linearly for
+ *   a free bucket; while it is too far, a key from an earlier bucket
+ *   whose neighbourhood covers it moves there, and the free bucket gets
+ *   closer. When no free bucket can be brought close enough, the table
+ *   doubles with every segment locked.
+ *
+ *   Writers lock the segments of the buckets they change, in increasing
+ *   order, from the one of the home bucket to the one of the free bucket.
+ *   Lookups take no lock but validate the timestamp of the segment of
+ *   the home bucket, which moves of keys of that segment increment.
+ *
+ * hopscotch.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "hopscotch.h"
+
+LOCKS_DEFINE
+
+static inline unsigned long hs_home(hs_table_t *t, uint32_t key) {
+	return hash_murmur3(key) & (t->len - 1);
+}
+
+static inline hs_segment_t *hs_segment(hs_table_t *t, unsigned long b) {
+	return &t->segments[b / HS_SEGMENT];
+}
+
+static void hs_lock(ht_intset_t *set, hs_segment_t *s) {
+	if (TRYLOCK(&s->lock) != 0) {
+		AO_fetch_and_add1(&set->nb_lock_waits);
+		LOCK(&s->lock);
+	}
+}
+
+/* Unlocks the segments of buckets first to last */
+static void hs_unlock_range(hs_table_t *t, unsigned long first, unsigned long last) {
+	unsigned long i;
+
+	for (i = first / HS_SEGMENT; i <= last / HS_SEGMENT; i++)
+		UNLOCK(&t->segments[i].lock);
+}
+
+static hs_table_t *hs_table_new(unsigned long len) {
+	hs_table_t *t;
+	unsigned long b;
+
+	if ((t = (hs_table_t *)malloc(sizeof(hs_table_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	t->len = len;
+	t->nb_buckets = len + HS_ADD_RANGE + HS_HOP;
+	t->nb_segments = (t->nb_buckets + HS_SEGMENT - 1) / HS_SEGMENT;
+	t->old = NULL;
+	if (posix_memalign((void **)&t->keys, 64, t->nb_buckets * sizeof(uint32_t)) != 0 ||
+			posix_memalign((void **)&t->hops, 64, t->nb_buckets * sizeof(uint64_t)) != 0 ||
+			posix_memalign((void **)&t->segments, sizeof(hs_segment_t),
+										 t->nb_segments * sizeof(hs_segment_t)) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+	for (b = 0; b < t->nb_buckets; b++) {
+		t->hops[b] = 0;
+		t->keys[b] = HS_EMPTY;
+	}
+	for (b = 0; b < t->nb_segments; b++) {
+		INIT_LOCK(&t->segments[b].lock);
+		t->segments[b].timestamp = 0;
+	}
+	return t;
+}
+
+static void hs_table_free(hs_table_t *t) {
+	unsigned long i;
+
+	for (i = 0; i < t->nb_segments; i++)
+		DESTROY_LOCK(&t->segments[i].lock);
+	free(t->segments);
+	free((void *)t->keys);
+	free((void *)t->hops);
+	free(t);
+}
+
+/* Bucket of key in the neighbourhood of home, or -1 */
+static inline long hs_find(hs_table_t *t, unsigned long home, uint32_t key) {
+	uint64_t hop = t->hops[home];
+	int i;
+
+	while (hop != 0) {
+		i = __builtin_ctzll(hop);
+		if (t->keys[home + i] == key)
+			return home + i;
+		hop &= hop - 1;
+	}
+	return -1;
+}
+
+/* First free bucket from home on, or -1 */
+static inline long hs_probe(hs_table_t *t, unsigned long home) {
+	unsigned long b;
+
+	for (b = home; b < home + HS_ADD_RANGE; b++)
+		if (t->keys[b] == HS_EMPTY)
+			return b;
+	return -1;
+}
+
+/*
+ * Brings the free bucket b into the neighbourhood of home by moving keys
+ * into it, each from the earliest bucket whose home neighbourhood also
+ * covers b. Returns the free bucket, or -1 when no key can move. The
+ * caller holds the segments from home to b: every home bucket involved
+ * is after home.
+ */
+static long hs_displace(ht_intset_t *set, hs_table_t *t, unsigned long home,
+												unsigned long b) {
+	unsigned long f, from;
+	uint64_t hop = 0;
+	hs_segment_t *s;
+
+	while (b - home >= HS_HOP) {
+		for (f = b - (HS_HOP - 1); f < b; f++) {
+			hop = t->hops[f];
+			if (hop & ((1ULL << (b - f)) - 1))
+				break;
+		}
+		if (f == b)
+			return -1;
+		from = f + __builtin_ctzll(hop);
+		s = hs_segment(t, f);
+		AO_fetch_and_add1_full(&s->timestamp);
+		t->keys[b] = t->keys[from];
+		t->hops[f] = (hop | (1ULL << (b - f))) & ~(1ULL << (from - f));
+		t->keys[from] = HS_EMPTY;
+		AO_fetch_and_add1_full(&s->timestamp);
+		AO_fetch_and_add1(&set->nb_moves);
+		b = from;
+	}
+	return b;
+}
+
+static inline void hs_insert(hs_table_t *t, unsigned long home, unsigned long b,
+														 uint32_t key) {
+	t->keys[b] = key;
+	AO_nop_write();
+	t->hops[home] |= 1ULL << (b - home);
+}
+
+/* Sequential insertion into a table under construction */
+static int hs_place(ht_intset_t *set, hs_table_t *t, uint32_t key) {
+	unsigned long home = hs_home(t, key);
+	long b;
+
+	if ((b = hs_probe(t, home)) < 0 || (b = hs_displace(set, t, home, b)) < 0)
+		return 0;
+	hs_insert(t, home, b, key);
+	return 1;
+}
+
+/* Doubles t unless another thread replaced it already */
+static void hs_resize(ht_intset_t *set, hs_table_t *t) {
+	hs_table_t *n = NULL;
+	unsigned long b, len, live = 0;
+	int ok;
+
+	if (pthread_mutex_trylock(&set->resize_lock) != 0)
+		return;
+	for (b = 0; b < t->nb_segments; b++)
+		LOCK(&t->segments[b].lock);
+	if (set->table == t) {
+		for (b = 0; b < t->nb_buckets; b++)
+			if (t->keys[b] != HS_EMPTY)
+				live++;
+		for (len = t->len << 1, ok = 0; !ok; len <<= 1) {
+			if (len > (1UL << HS_MAX_BITS)) {
+				fprintf(stderr, "Hopscotch table full (%lu buckets), use a smaller range\n",
+								t->len);
+				exit(1);
+			}
+			n = hs_table_new(len);
+			ok = 1;
+			for (b = 0; b < t->nb_buckets && ok; b++)
+				if (t->keys[b] != HS_EMPTY)
+					ok = hs_place(set, n, t->keys[b]);
+			if (!ok)
+				hs_table_free(n);
+		}
+		n->old = t;
+		AO_store_full((volatile AO_t *)&set->table, (AO_t)n);
+		AO_fetch_and_add1(&set->nb_resizes);
+		AO_fetch_and_add(&set->resize_load, live * 1000 / t->nb_buckets);
+	}
+	hs_unlock_range(t, 0, t->nb_buckets - 1);
+	pthread_mutex_unlock(&set->resize_lock);
+}
+
+/*
+ * Locks the segment of the home bucket of key in the current table,
+ * which it returns; a resize in between makes it start over.
+ */
+static hs_table_t *hs_lock_home(ht_intset_t *set, uint32_t key, unsigned long *home) {
+	hs_table_t *t;
+
+	do {
+		t = set->table;
+		*home = hs_home(t, key);
+		hs_lock(set, hs_segment(t, *home));
+		if (set->table == t)
+			return t;
+		UNLOCK(&hs_segment(t, *home)->lock);
+	} while (1);
+}
+
+/*
+ * The table starts with at least nb_keys home buckets, and at least a
+ * segment of them.
+ */
+ht_intset_t *ht_new(unsigned long nb_keys) {
+	ht_intset_t *set;
+	unsigned long len = HS_SEGMENT;
+
+	if ((set = (ht_intset_t *)calloc(1, sizeof(ht_intset_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	while (len < nb_keys && len < (1UL << HS_MAX_BITS))
+		len <<= 1;
+	set->table = hs_table_new(len);
+	set->initial_len = len;
+	pthread_mutex_init(&set->resize_lock, NULL);
+	return set;
+}
+
+void ht_delete(ht_intset_t *set) {
+	hs_table_t *t, *old;
+
+	for (t = set->table; t != NULL; t = old) {
+		old = t->old;
+		hs_table_free(t);
+	}
+	pthread_mutex_destroy(&set->resize_lock);
+	free(set);
+}
+
+int ht_size(ht_intset_t *set) {
+	hs_table_t *t = set->table;
+	unsigned long b;
+	int size = 0;
+
+	for (b = 0; b < t->nb_buckets; b++)
+		if (t->keys[b] != HS_EMPTY)
+			size++;
+	return size;
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	hs_table_t *t;
+	hs_segment_t *s;
+	unsigned long home;
+	AO_t ts;
+	int found;
+
+	do {
+		t = set->table;
+		home = hs_home(t, val);
+		s = hs_segment(t, home);
+		ts = AO_load_full(&s->timestamp);
+		if (!(ts & 1)) {
+			found = hs_find(t, home, val) >= 0;
+			AO_nop_full();
+			if (s->timestamp == ts && set->table == t)
+				return found;
+		}
+		AO_fetch_and_add1(&set->nb_read_retries);
+	} while (1);
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	hs_table_t *t;
+	unsigned long home, i;
+	long b, last;
+	AO_t max;
+
+	do {
+		t = hs_lock_home(set, val, &home);
+		if (hs_find(t, home, val) >= 0) {
+			UNLOCK(&hs_segment(t, home)->lock);
+			return 0;
+		}
+		if ((last = b = hs_probe(t, home)) < 0) {
+			UNLOCK(&hs_segment(t, home)->lock);
+			hs_resize(set, t);
+			continue;
+		}
+		for (i = home / HS_SEGMENT + 1; i <= b / HS_SEGMENT; i++)
+			hs_lock(set, &t->segments[i]);
+		/* The free bucket was found without its segment lock */
+		if (t->keys[b] != HS_EMPTY) {
+			hs_unlock_range(t, home, b);
+			continue;
+		}
+		if ((unsigned long)b - home > (max = set->max_probe))
+			AO_compare_and_swap(&set->max_probe, max, b - home);
+		if ((b = hs_displace(set, t, home, b)) >= 0) {
+			hs_insert(t, home, b, val);
+			hs_unlock_range(t, home, last);
+			return 1;
+		}
+		hs_unlock_range(t, home, last);
+		hs_resize(set, t);
+	} while (1);
+}
+
+/* Only the writers of home move or remove its keys */
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	hs_table_t *t;
+	unsigned long home;
+	long b;
+	int result = 0;
+
+	t = hs_lock_home(set, val, &home);
+	if ((b = hs_find(t, home, val)) >= 0) {
+		t->hops[home] &= ~(1ULL << (b - home));
+		t->keys[b] = HS_EMPTY;
+		result = 1;
+	}
+	UNLOCK(&hs_segment(t, home)->lock);
+	return result;
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No hopscotch implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No hopscotch implementation is available\n");
+	exit(1);
+}
+
+void ht_print_stats(ht_intset_t *set) {
+	hs_table_t *t = set->table;
+	unsigned long home, keys = 0, dist = 0, max = 0, same_line = 0, overflow = 0;
+	uint64_t hop;
+	int i;
+
+	for (home = 0; home < t->len; home++) {
+		for (hop = t->hops[home]; hop != 0; hop &= hop - 1) {
+			i = __builtin_ctzll(hop);
+			keys++;
+			dist += i;
+			if ((unsigned long)i > max)
+				max = i;
+			if ((home + i) * sizeof(uint32_t) / 64 == home * sizeof(uint32_t) / 64)
+				same_line++;
+			if (home + i >= t->len)
+				overflow++;
+		}
+	}
+	printf("Buckets       : %lu + %d overflow, hop %d (initial %lu, %lu resizes)\n",
+				 t->len, HS_ADD_RANGE + HS_HOP, HS_HOP, set->initial_len,
+				 (unsigned long)set->nb_resizes);
+	printf("  #load       : %.1f%% now (%lu keys in the overflow), %.1f%% avg when resizing\n",
+				 100.0 * keys / t->nb_buckets, overflow,
+				 set->nb_resizes ? set->resize_load / 10.0 / set->nb_resizes : 0.0);
+	printf("  #distance   : %.2f avg, %lu max, %.1f%% in the home cache line\n",
+				 keys ? (double)dist / keys : 0.0, max, keys ? 100.0 * same_line / keys : 0.0);
+	printf("  #moves      : %lu (probes up to %lu buckets)\n",
+				 (unsigned long)set->nb_moves, (unsigned long)set->max_probe);
+	printf("  #lock waits : %lu\n", (unsigned long)set->nb_lock_waits);
+	printf("  #read retry : %lu\n", (unsigned long)set->nb_read_retries);
+}
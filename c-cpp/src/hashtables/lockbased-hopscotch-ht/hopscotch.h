@@ -0,0 +1,132 @@
+/*
+ * File:
+ *   hopscotch.h
+ * Description:
+ *   Concurrent hopscotch hash set
+ *   "Hopscotch Hashing"
+ *   M. Herlihy, N. Shavit, M. Tzafrir, DISC 2008.
+ *
+ * hopscotch.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <atomic_ops.h>
+
+#include "locks.h"
+#include "hashfn.h"
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_ELASTICITY              2
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+
+#define MAXHTLENGTH                     65536
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+
+/* ################################################################### *
+ * HOPSCOTCH HASH TABLE
+ * ################################################################### */
+
+/*
+ * A key lives in one of the HS_HOP buckets that follow its home bucket,
+ * whose hop bitmap tells which. Buckets hold one key, HS_EMPTY when free.
+ * With 32-bucket neighbourhoods, keys can no longer be moved close enough
+ * at about 88% load; with 64, at about 95%.
+ */
+#define HS_HOP                          64
+#define HS_EMPTY                        0xFFFFFFFFU
+
+/* How far an insertion looks for a free bucket before resizing */
+#define HS_ADD_RANGE                    4096
+
+/* Buckets per segment, a lock and a timestamp each; at least HS_HOP */
+#define HS_SEGMENT                      64
+
+#define HS_MAX_BITS                     28
+
+/*
+ * The timestamp of a segment is odd while a key whose home bucket is in
+ * the segment is being moved. Lookups take no lock: they read it before
+ * and after scanning the neighbourhood and retry if it changed.
+ */
+typedef struct hs_segment {
+  ptlock_t lock;
+  volatile AO_t timestamp;
+} __attribute__((aligned(64))) hs_segment_t;
+
+/*
+ * The HS_ADD_RANGE + HS_HOP buckets after the last home bucket only take
+ * the overflow of the last neighbourhoods, so that probes never wrap.
+ * Keys and hop bitmaps are kept in separate arrays, so that a cache line
+ * holds the keys of 16 neighbouring buckets: a lookup reads the bitmap
+ * of the home bucket, then keys within one or two lines of it.
+ */
+typedef struct hs_table {
+  volatile uint32_t *keys;
+  volatile uint64_t *hops;        /* bit i: key of this home in bucket + i */
+  hs_segment_t *segments;
+  unsigned long len;              /* home buckets, a power of two */
+  unsigned long nb_buckets;       /* len plus the overflow */
+  unsigned long nb_segments;
+  struct hs_table *old;           /* replaced tables, freed with the set */
+} hs_table_t;
+
+typedef struct ht_intset {
+  hs_table_t *volatile table;
+  pthread_mutex_t resize_lock;
+  unsigned long initial_len;
+  volatile AO_t nb_resizes;
+  volatile AO_t resize_load;      /* sum of per-mille loads at resizes */
+  volatile AO_t nb_moves;         /* keys moved closer to their home */
+  volatile AO_t max_probe;
+  volatile AO_t nb_lock_waits;
+  volatile AO_t nb_read_retries;
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(unsigned long nb_keys);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
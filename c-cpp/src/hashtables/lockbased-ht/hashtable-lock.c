@@ -24,6 +24,8 @@
  * GNU General Public License for more details.
  */
 
+#include <string.h>
+
 #include "hashtable-lock.h"
 
 unsigned int maxhtlength;
@@ -33,14 +35,28 @@ void ht_delete(ht_intset_t *set) {
 	int i;
 	
 	for (i=0; i < maxhtlength; i++) {
-		node = set->buckets[i]->head;
+#ifdef HT_FLAT_BUCKETS
+		/* Only the nodes between the inline sentinels */
+		node = set->buckets[i].head.next;
+		while (node != &set->buckets[i].tail) {
+			next = node->next;
+			free(node);
+			node = next;
+		}
+#else
+		node = HT_BUCKET(set, i)->head;
 		while (node != NULL) {
 			next = node->next;
       free(node);
 			node = next;
 		}
 		free(set->buckets[i]);
+#endif
 	}
+#ifdef HT_FLAT_BUCKETS
+	free(set->buckets);
+#endif
+	free(set->versions);
 	free(set);
 }
 
@@ -50,7 +66,7 @@ int ht_size(ht_intset_t *set) {
 	int i;
 	
 	for (i=0; i < maxhtlength; i++) {
-		node = set->buckets[i]->head->next;
+		node = HT_BUCKET(set, i)->head->next;
 		while (node->next) {
 			size++;
 			node = node->next;
@@ -75,30 +91,84 @@ ht_intset_t *ht_new() {
 	ht_intset_t *set;
 	int i;
 	
-	if ((set = (ht_intset_t *)malloc(sizeof(ht_intset_t))) == NULL) {
-		perror("malloc");
+	if ((set = (ht_intset_t *)calloc(1, sizeof(ht_intset_t))) == NULL) {
+		perror("calloc");
 		exit(1);
 	}   
+	set->hash = DEFAULT_HASH;
+	set->bits = hash_bits(maxhtlength);
+	if (posix_memalign((void **)&set->versions, sizeof(ht_version_t),
+										 maxhtlength * sizeof(ht_version_t)) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+	memset(set->versions, 0, maxhtlength * sizeof(ht_version_t));
+#ifdef HT_FLAT_BUCKETS
+	if (posix_memalign((void **)&set->buckets, 64, maxhtlength * sizeof(ht_bucket_t)) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+	for (i=0; i < maxhtlength; i++) {
+		set->buckets[i].tail.val = VAL_MAX;
+		set->buckets[i].tail.next = NULL;
+		INIT_LOCK(&set->buckets[i].tail.lock);
+		set->buckets[i].head.val = VAL_MIN;
+		set->buckets[i].head.next = &set->buckets[i].tail;
+		INIT_LOCK(&set->buckets[i].head.lock);
+		set->buckets[i].set.head = &set->buckets[i].head;
+	}
+#else
 	for (i=0; i < maxhtlength; i++) {
 		set->buckets[i] = set_new_l();
 	}
+#endif
 	return set;
 }
 
+void ht_print_hist(ht_intset_t *set) {
+	hash_hist_t hist;
+	node_l_t *node;
+	unsigned long len;
+	int i;
+	
+	memset(&hist, 0, sizeof(hist));
+	for (i=0; i < maxhtlength; i++) {
+		len = 0;
+		for (node = HT_BUCKET(set, i)->head->next; node->next; node = node->next)
+			len++;
+		hash_hist_add(&hist, len);
+	}
+	hash_print_hist(set->hash, &hist);
+}
+
+static inline void ht_write_begin(ht_intset_t *set, int addr) {
+	if (set->snapshot_alg == HT_SNAPSHOT_VERSIONED)
+		AO_fetch_and_add_full(&set->versions[addr].v, HT_VER_WRITER);
+}
+
+static inline void ht_write_end(ht_intset_t *set, int addr) {
+	if (set->snapshot_alg == HT_SNAPSHOT_VERSIONED)
+		AO_fetch_and_add_full(&set->versions[addr].v, HT_VER_DONE);
+	if (set->snap_active)
+		AO_fetch_and_add1(&set->snap_upd);
+}
+
 int ht_contains(ht_intset_t *set, int val, int transactional) {
 	int addr;
 	
 	/* Get key */
-	addr = val % maxhtlength;
-	return set_contains_l(set->buckets[addr], val, transactional);
+	addr = ht_index(set, val);
+	return set_contains_l(HT_BUCKET(set, addr), val, transactional);
 }
 
 int ht_add(ht_intset_t *set, int val, int transactional) {
 	int addr, result;
 	
 	/* Get key */
-	addr = val % maxhtlength;
-	result = set_add_l(set->buckets[addr], val, transactional);
+	addr = ht_index(set, val);
+	ht_write_begin(set, addr);
+	result = set_add_l(HT_BUCKET(set, addr), val, transactional);
+	ht_write_end(set, addr);
 	return result;
 }
 
@@ -106,8 +176,10 @@ int ht_remove(ht_intset_t *set, int val, int transactional) {
 	int addr, result;
 	
 	/* Get key */
-	addr = val % maxhtlength;
-	result = set_remove_l(set->buckets[addr], val, transactional);
+	addr = ht_index(set, val);
+	ht_write_begin(set, addr);
+	result = set_remove_l(HT_BUCKET(set, addr), val, transactional);
+	ht_write_end(set, addr);
 	
 	return result;
 }
@@ -127,16 +199,16 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 	if (val1 == val2) return 0;
 	
 	// records pred and succ of val1
-	addr1 = val1 % maxhtlength;
-	pred1 = set->buckets[addr1]->head;
+	addr1 = ht_index(set, val1);
+	pred1 = HT_BUCKET(set, addr1)->head;
 	curr1 = pred1->next;
 	while (curr1->val < val1) {
 		pred1 = curr1;
 		curr1 = curr1->next;
 	}
 	// records pred and succ of val2 
-	addr2 = val2 % maxhtlength;
-	pred2 = set->buckets[addr2]->head;
+	addr2 = ht_index(set, val2);
+	pred2 = HT_BUCKET(set, addr2)->head;
 	curr2 = pred2->next;
 	while (curr2->val < val2) {
 		pred2 = curr2;
@@ -146,6 +218,9 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 	if (pred1->val == pred2->val || curr1->val == pred2->val || 
 		curr2->val == pred1->val || curr1->val == curr2->val) 
 		return 0;
+	ht_write_begin(set, addr1);
+	if (addr2 != addr1)
+		ht_write_begin(set, addr2);
 	// acquire locks in order
 	if (addr1 < addr2 || (addr1 == addr2 && val1 < val2)) {
 		LOCK(&pred1->lock);
@@ -172,6 +247,9 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 	UNLOCK(&pred1->lock);
 	UNLOCK(&curr2->lock);
 	UNLOCK(&curr1->lock);
+	if (addr2 != addr1)
+		ht_write_end(set, addr2);
+	ht_write_end(set, addr1);
 		
 	return result;
 }
@@ -186,8 +264,8 @@ int ht_snapshot_unmovable(ht_intset_t *set, int transactional) {
 	int sum = 0;
 	
 	for (i=0; i < maxhtlength; i++) {
-		curr = set->buckets[i]->head;
-		next = set->buckets[i]->head->next;
+		curr = HT_BUCKET(set, i)->head;
+		next = HT_BUCKET(set, i)->head->next;
 		
   		//pthread_mutex_lock((pthread_mutex_t *) &next->lock);
 		LOCK(&next->lock);
@@ -209,7 +287,7 @@ int ht_snapshot_unmovable(ht_intset_t *set, int transactional) {
 /* 
  * Read all elements of the hashtable (parses all linked-lists)
  */
-int ht_snapshot(ht_intset_t *set, int transactional) {
+int ht_snapshot_strict(ht_intset_t *set) {
 	node_l_t *next, *curr;
 	int i;
 	int sum = 0;
@@ -218,10 +296,10 @@ int ht_snapshot(ht_intset_t *set, int transactional) {
 	
 	for (i=0; i < m; i++) {
 	  do {
-	    LOCK(&set->buckets[i]->head->lock);
-	    LOCK(&set->buckets[i]->head->next->lock);
-	    curr = set->buckets[i]->head;
-	    next = set->buckets[i]->head->next;
+	    LOCK(&HT_BUCKET(set, i)->head->lock);
+	    LOCK(&HT_BUCKET(set, i)->head->next->lock);
+	    curr = HT_BUCKET(set, i)->head;
+	    next = HT_BUCKET(set, i)->head->next;
 	  } while (!parse_validate(curr, next));
 
 	  while (next->next) {
@@ -239,18 +317,162 @@ int ht_snapshot(ht_intset_t *set, int transactional) {
 	  }
 	}
 	
+	/* Read each next pointer before its node is released */
 	for (i=0; i < m; i++) {
-	  curr = set->buckets[i]->head;
-	  next = set->buckets[i]->head->next;
-	  
-	  UNLOCK(&curr->lock);
-	  UNLOCK(&next->lock);
-	  while (next->next) {
-	    curr = next;
+	  curr = HT_BUCKET(set, i)->head;
+	  while (curr) {
 	    next = curr->next;
-	    UNLOCK(&next->lock);
+	    UNLOCK(&curr->lock);
+	    curr = next;
 	  }
 	}
 	
 	return 1;
 }
+
+/*
+ * Reads bucket i once no writer is inside, and returns the version it
+ * was read at.
+ */
+static AO_t ht_bucket_read(ht_intset_t *set, int i, int *sum) {
+	node_l_t *curr;
+	AO_t v;
+	int s;
+	
+	while (1) {
+		v = AO_load_full(&set->versions[i].v);
+		if (HT_VER_ACTIVE(v) == 0) {
+			s = 0;
+			curr = get_unmarked_ref(HT_BUCKET(set, i)->head->next);
+			while (curr->next) {
+				s += curr->val;
+				curr = get_unmarked_ref(curr->next);
+			}
+			AO_nop_full();
+			if (set->versions[i].v == v) {
+				*sum = s;
+				return v;
+			}
+		}
+		AO_fetch_and_add1(&set->snap_rereads);
+	}
+}
+
+/* 
+ * Versions and per-bucket sums a thread read in its last versioned
+ * snapshot, kept from one snapshot to the next.
+ */
+static __thread AO_t *snap_seen;
+static __thread int *snap_sums;
+static __thread int snap_len;
+
+/* 
+ * Read all elements of the hashtable without locks (double collect).
+ * Buckets whose version changed since they were read are read again
+ * until a whole validation pass finds none, the snapshot then holds at
+ * the start of that pass. Returns 0 if HT_SNAP_MAX_ROUNDS passes were not
+ * enough, in which case every bucket is consistent but not all at once.
+ */
+int ht_snapshot_versioned(ht_intset_t *set) {
+	AO_t *seen;
+	int *sums;
+	int i, round, changed, result = 1;
+	int m = maxhtlength;
+	
+	if (snap_len < m) {
+		free(snap_seen);
+		free(snap_sums);
+		snap_seen = (AO_t *)malloc(m * sizeof(AO_t));
+		snap_sums = (int *)malloc(m * sizeof(int));
+		if (snap_seen == NULL || snap_sums == NULL) {
+			perror("malloc");
+			exit(1);
+		}
+		snap_len = m;
+	}
+	seen = snap_seen;
+	sums = snap_sums;
+	for (i = 0; i < m; i++)
+		seen[i] = ht_bucket_read(set, i, &sums[i]);
+	for (round = 0; ; round++) {
+		AO_nop_full();
+		changed = 0;
+		for (i = 0; i < m; i++) {
+			if (set->versions[i].v != seen[i]) {
+				seen[i] = ht_bucket_read(set, i, &sums[i]);
+				changed++;
+			}
+		}
+		if (changed == 0)
+			break;
+		AO_fetch_and_add(&set->snap_rereads, changed);
+		if (round == HT_SNAP_MAX_ROUNDS) {
+			AO_fetch_and_add1(&set->snap_unvalidated);
+			result = 0;
+			break;
+		}
+	}
+	
+	return result;
+}
+
+static inline AO_t ht_now(void) {
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (AO_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	AO_t start, ns, max;
+	int result;
+	
+	start = ht_now();
+	if (AO_fetch_and_add1_full(&set->snap_active) == 0)
+		set->snap_busy_start = start;
+	if (set->snapshot_alg == HT_SNAPSHOT_VERSIONED)
+		result = ht_snapshot_versioned(set);
+	else
+		result = ht_snapshot_strict(set);
+	ns = ht_now() - start;
+	if (AO_fetch_and_sub1_full(&set->snap_active) == 1)
+		AO_fetch_and_add(&set->snap_busy_ns, ht_now() - set->snap_busy_start);
+	AO_fetch_and_add1(&set->snap_count);
+	AO_fetch_and_add(&set->snap_ns, ns);
+	while ((max = set->snap_max_ns) < ns &&
+				 !AO_compare_and_swap(&set->snap_max_ns, max, ns));
+	
+	return result;
+}
+
+/*
+ * Compares the update rate while at least one snapshot was running with
+ * the rate the rest of the time, given all the updates of the run.
+ */
+void ht_print_snapshot_stats(ht_intset_t *set, unsigned long updates, int duration) {
+	double busy_s = set->snap_busy_ns / 1e9;
+	double idle_s, during, outside;
+	
+	if (set->snap_count == 0)
+		return;
+	/* Snapshots may still run a little after the measured interval */
+	if (busy_s > duration / 1000.0)
+		busy_s = duration / 1000.0;
+	idle_s = duration / 1000.0 - busy_s;
+	during = busy_s > 0 ? set->snap_upd / busy_s : 0.0;
+	outside = idle_s > 0 ? (updates - set->snap_upd) / idle_s : 0.0;
+	printf("Snapshot alg  : %s\n",
+				 set->snapshot_alg == HT_SNAPSHOT_VERSIONED ? "versioned" : "strict");
+	printf("  #latency    : %.3f us avg, %.3f us max\n",
+				 set->snap_ns / 1e3 / set->snap_count, set->snap_max_ns / 1e3);
+	printf("  #busy time  : %.1f%% of the run\n", 100.0 * busy_s * 1000.0 / duration);
+	if (set->snapshot_alg == HT_SNAPSHOT_VERSIONED) {
+		printf("  #rereads    : %lu buckets\n", (unsigned long)set->snap_rereads);
+		printf("  #unvalidated: %lu\n", (unsigned long)set->snap_unvalidated);
+	}
+	if (idle_s * 100.0 < duration / 1000.0)
+		printf("  #upd rate   : %.0f / s during snapshots, always running\n", during);
+	else
+		printf("  #upd rate   : %.0f / s during snapshots, %.0f / s otherwise (%.1f%% lost)\n",
+					 during, outside, 100.0 * (1.0 - during / outside));
+}
@@ -25,6 +25,8 @@
  */
 
 #include "../linkedlists/lazy-list/intset.h"
+#include "perfcount.h"
+#include "hashfn.h"
 
 #define DEFAULT_MOVE                    0
 #define DEFAULT_SNAPSHOT                0
@@ -32,6 +34,8 @@
 #define DEFAULT_ELASTICITY              2
 #define DEFAULT_ALTERNATE               0
 #define DEFAULT_EFFECTIVE               1
+#define DEFAULT_SNAPSHOT_ALG            HT_SNAPSHOT_STRICT
+#define DEFAULT_KEY_STRIDE              1
 
 #define MAXHTLENGTH                     65536
 
@@ -42,14 +46,84 @@ extern unsigned int maxhtlength;
  * HASH TABLE
  * ################################################################### */
 
+/*
+ * Snapshot algorithms: STRICT locks every node of every bucket before
+ * reading, VERSIONED reads the buckets without locks and validates them
+ * against per-bucket versions, so that writers never wait for it.
+ */
+#define HT_SNAPSHOT_STRICT              0
+#define HT_SNAPSHOT_VERSIONED           1
+
+/*
+ * A bucket version counts the writers inside the bucket in its low half
+ * and the updates they completed in its high half: a writer adds
+ * HT_VER_WRITER on entry and HT_VER_DONE on exit. A bucket read is valid
+ * if no writer was inside and the version did not change meanwhile.
+ */
+#define HT_VER_WRITER                   1UL
+#define HT_VER_DONE                     ((1UL << 32) - 1)
+#define HT_VER_ACTIVE(v)                ((v) & 0xFFFFFFFFUL)
+
+/* Each version gets its own cache line, writers of neighbour buckets would share it otherwise */
+typedef struct ht_version {
+	volatile AO_t v;
+} __attribute__((aligned(64))) ht_version_t;
+
+/* Validation passes before a versioned snapshot gives up being atomic */
+#define HT_SNAP_MAX_ROUNDS              16
+
+#ifdef HT_FLAT_BUCKETS
+/*
+ * A flat bucket holds the list head and both sentinels in the bucket
+ * array, so that reaching the first key of a bucket takes one cache miss
+ * for the bucket and one for the key. Unlike in the lock-free table, the
+ * tail sentinel is not shared: lazy list updates lock it when they insert
+ * or remove the last key of a bucket.
+ */
+typedef struct ht_bucket {
+	intset_l_t set;               /* set.head points to head below */
+	node_l_t head;
+	node_l_t tail;
+} __attribute__((aligned(64))) ht_bucket_t;
+
+#  define HT_BUCKET(s, i)               (&(s)->buckets[i].set)
+#else
+#  define HT_BUCKET(s, i)               ((s)->buckets[i])
+#endif
+
 typedef struct ht_intset {
+#ifdef HT_FLAT_BUCKETS
+	ht_bucket_t *buckets;
+#else
 	intset_l_t *buckets[MAXHTLENGTH];
+#endif
+	int hash;                       /* HASH_IDENTITY, ... */
+	unsigned int bits;              /* maxhtlength is 2^bits */
+	int snapshot_alg;
+	ht_version_t *versions;         /* maxhtlength of them */
+	/* snapshot statistics */
+	volatile AO_t snap_active;      /* snapshots in progress */
+	volatile AO_t snap_count;
+	volatile AO_t snap_ns;
+	volatile AO_t snap_max_ns;
+	volatile AO_t snap_busy_ns;     /* time with a snapshot in progress */
+	volatile AO_t snap_busy_start;
+	volatile AO_t snap_upd;         /* updates finished meanwhile */
+	volatile AO_t snap_rereads;
+	volatile AO_t snap_unvalidated;
 } ht_intset_t;
 
 void ht_delete(ht_intset_t *set);
 int ht_size(ht_intset_t *set);
 int floor_log_2(unsigned int n);
 ht_intset_t *ht_new();
+void ht_print_hist(ht_intset_t *set);
+
+/* Bucket of val */
+static inline int ht_index(ht_intset_t *set, val_t val) {
+	return (int)hash_index(set->hash, val, set->bits);
+}
+
 int ht_contains(ht_intset_t *set, int val, int transactional);
 int ht_add(ht_intset_t *set, int val, int transactional);
 int ht_remove(ht_intset_t *set, int val, int transactional);
@@ -64,4 +138,7 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
  * TODO: make a coarse-grain version of the snapshot.
  */
 int ht_snapshot(ht_intset_t *set, int transactional);
+int ht_snapshot_strict(ht_intset_t *set);
+int ht_snapshot_versioned(ht_intset_t *set);
+void ht_print_snapshot_stats(ht_intset_t *set, unsigned long updates, int duration);
 
@@ -23,8 +23,6 @@
 
 #include "hashtable-lock.h"
 
-unsigned int maxhtlength;
-
 typedef struct barrier {
 	pthread_cond_t complete;
 	pthread_mutex_t mutex;
@@ -92,6 +90,7 @@ inline long rand_range_re(unsigned int *seed, long r) {
 typedef struct thread_data {
 	val_t first;
 	long range;
+	long stride;
 	int update;
 	int move;
 	int snapshot;
@@ -124,6 +123,11 @@ typedef struct thread_data {
 	barrier_t *barrier;
 } thread_data_t;
 
+/* Keys of the workers: multiples of the key stride in [1, range] */
+static inline long rand_key_re(thread_data_t *d) {
+	return d->stride * rand_range_re(&d->seed, d->range / d->stride);
+}
+
 
 void *test(void *data) {
 	val_t val = 0;
@@ -161,8 +165,8 @@ void *test(void *data) {
 			
 			if (mnext) { // move
 				
-				if (last == -1) val = rand_range_re(&d->seed, d->range);
-				val2 = rand_range_re(&d->seed, d->range);
+				if (last == -1) val = rand_key_re(d);
+				val2 = rand_key_re(d);
 				if (ht_move(d->set, val, val2, TRANSACTIONAL)) {
 					d->nb_moved++;
 					last = -1;
@@ -171,7 +175,7 @@ void *test(void *data) {
 				
 			} else if (last < 0) { // add
 				
-				val = rand_range_re(&d->seed, d->range);
+				val = rand_key_re(d);
 				if (ht_add(d->set, val, TRANSACTIONAL)) {
 					d->nb_added++;
 					last = val;
@@ -187,7 +191,7 @@ void *test(void *data) {
 					}
 				} else {
 					/* Random computation only in non-alternated cases */
-					val = rand_range_re(&d->seed, d->range);
+					val = rand_key_re(d);
 					/* Remove one random value */
 					if (ht_remove(d->set, val, TRANSACTIONAL)) {
 						d->nb_removed++;
@@ -208,18 +212,18 @@ void *test(void *data) {
 							val = d->first;
 							last = val;
 						} else { // last >= 0
-							val = rand_range_re(&d->seed, d->range);
+							val = rand_key_re(d);
 							last = -1;
 						}
 					} else { // update != 0
 						if (last < 0) {
-							val = rand_range_re(&d->seed, d->range);
+							val = rand_key_re(d);
 							//last = val;
 						} else {
 							val = last;
 						}
 					}
-				}	else val = rand_range_re(&d->seed, d->range);
+				}	else val = rand_key_re(d);
 				
 				if (ht_contains(d->set, val, TRANSACTIONAL)) 
 					d->nb_found++;
@@ -272,6 +276,9 @@ int main(int argc, char **argv)
 		{"move-rate",                 required_argument, NULL, 'a'},
 		{"snapshot-rate",             required_argument, NULL, 's'},
 		{"lock-alg",                  required_argument, NULL, 'x'},
+		{"snapshot-alg",              required_argument, NULL, 'k'},
+		{"hash",                      required_argument, NULL, 'H'},
+		{"key-stride",                required_argument, NULL, 'K'},
 		{NULL, 0, NULL, 0}
 	};
 	
@@ -301,11 +308,14 @@ int main(int argc, char **argv)
 	int unit_tx = DEFAULT_ELASTICITY;
 	int alternate = DEFAULT_ALTERNATE;
 	int effective = DEFAULT_EFFECTIVE;
+	int snapshot_alg = DEFAULT_SNAPSHOT_ALG;
+	int hash = DEFAULT_HASH;
+	long stride = DEFAULT_KEY_STRIDE;
 	sigset_t block_set;
 	
 	while(1) {
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:a:s:l:x:", long_options, &i);
+		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:a:s:l:x:k:H:K:", long_options, &i);
 		
 		if(c == -1)
 			break;
@@ -347,6 +357,14 @@ int main(int argc, char **argv)
 								 "        Percentage of move transactions (default=" XSTR(DEFAULT_MOVE) ")\n"
 								 "  -s , --snapshot-rate <int>\n"
 								 "        Percentage of snapshot transactions (default=" XSTR(DEFAULT_SNAPSHOT) ")\n"
+								 "  -k , --snapshot-alg <int>\n"
+								 "        Snapshot algorithm (default=" XSTR(DEFAULT_SNAPSHOT_ALG) ")\n"
+								 "        0 = strict, locks every node,\n"
+								 "        1 = versioned, validates lock-free bucket reads\n"
+								 "  -H, --hash <int>\n"
+								 "        Hash function (0=identity, 1=fibonacci, 2=murmur3, 3=wyhash, default=" XSTR(DEFAULT_HASH) ")\n"
+								 "  -K, --key-stride <int>\n"
+								 "        Keys are multiples of this stride (default=" XSTR(DEFAULT_KEY_STRIDE) ")\n"
 								 "  -l , --load-factor <int>\n"
 								 "        Ratio of keys over buckets (default=" XSTR(DEFAULT_LOAD) ")\n"
 								 "  -x, --unit-tx (default=1)\n"
@@ -396,6 +414,15 @@ int main(int argc, char **argv)
 				case 'x':
 					unit_tx = atoi(optarg);
 					break;
+				case 'k':
+					snapshot_alg = atoi(optarg);
+					break;
+				case 'H':
+					hash = atoi(optarg);
+					break;
+				case 'K':
+					stride = atol(optarg);
+					break;
 				case '?':
 					printf("Use -h or --help for help\n");
 					exit(0);
@@ -412,6 +439,9 @@ int main(int argc, char **argv)
 	assert(move >= 0 && move <= update);
 	assert(snapshot >= 0 && snapshot <= (100-update));
 	assert(load_factor >= 1);
+	assert(snapshot_alg == HT_SNAPSHOT_STRICT || snapshot_alg == HT_SNAPSHOT_VERSIONED);
+	assert(hash >= 0 && hash < HASH_NB_FUNCTIONS);
+	assert(stride >= 1 && range / stride >= initial);
 	
 	printf("Set type     : hash table\n");
 	printf("Duration     : %d\n", duration);
@@ -424,6 +454,10 @@ int main(int argc, char **argv)
 	printf("Move rate    : %d\n", move);
 	printf("Update rate  : %d\n", update);
 	printf("Lock alg.    : %d\n", unit_tx);
+	printf("Lock type    : %s\n", NODELOCK_NAME);
+	printf("Snapshot alg.: %d\n", snapshot_alg);
+	printf("Hash function: %s\n", hash_names[hash]);
+	printf("Key stride   : %ld\n", stride);
 	printf("Alternate    : %d\n", alternate);
 	printf("effective    : %d\n", effective);
 	printf("Type sizes   : int=%d/long=%d/ptr=%d/word=%d\n",
@@ -449,8 +483,10 @@ int main(int argc, char **argv)
 	else
 		srand(seed);
 	
-	maxhtlength = (unsigned int) initial / load_factor;
+	maxhtlength = hash_pow2(initial / load_factor, MAXHTLENGTH);
 	set = ht_new();
+	set->hash = hash;
+	set->snapshot_alg = snapshot_alg;
 	
 	stop = 0;
 	
@@ -459,7 +495,7 @@ int main(int argc, char **argv)
 	i = 0;
 	//maxhtlength = (int) (initial / load_factor);
 	while (i < initial) {
-		val = (rand() % range) + 1;
+		val = stride * ((rand() % (range / stride)) + 1);
 		if (ht_add(set, val, 0)) {
 		  last = val;
 			i++;
@@ -469,8 +505,12 @@ int main(int argc, char **argv)
 	printf("Set size     : %d\n", size);
 	printf("Bucket amount: %d\n", maxhtlength);
 	printf("Load         : %d\n", load_factor);
+#ifdef HT_FLAT_BUCKETS
+	printf("Buckets      : flat, %d B each\n", (int)sizeof(ht_bucket_t));
+#endif
 	
 	/* Access set from all threads */
+	PERF_START();
 	barrier_init(&barrier, nb_threads + 1);
 	pthread_attr_init(&attr);
 	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
@@ -478,6 +518,7 @@ int main(int argc, char **argv)
 		printf("Creating thread %d\n", i);
 		data[i].first = last;
 		data[i].range = range;
+		data[i].stride = stride;
 		data[i].update = update;
 		data[i].load_factor = load_factor;
 		data[i].move = move;
@@ -535,6 +576,7 @@ int main(int argc, char **argv)
 			exit(1);
 		}
 	}
+	PERF_STOP();
 	
 	duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 	aborts = 0;
@@ -627,6 +669,9 @@ int main(int argc, char **argv)
 	printf("  #val-c      : %lu (%f / s)\n", aborts_validate_commit, aborts_validate_commit * 1000.0 / duration);
 	printf("  #inv-mem    : %lu (%f / s)\n", aborts_invalid_memory, aborts_invalid_memory * 1000.0 / duration);
 	printf("Max retries   : %lu\n", max_retries);
+	ht_print_snapshot_stats(set, updates + moves, duration);
+	PERF_PRINT_STATS(reads + updates + moves + snapshots);
+	ht_print_hist(set);
 	
 	/* Delete set */
 	ht_delete(set);
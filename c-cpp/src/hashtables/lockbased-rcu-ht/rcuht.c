@@ -0,0 +1,384 @@
+/*
+ * File:
+ *   rcuht.c
+ * Description:
+ *   Relativistic hash set
+ *   "Resizable, Scalable, Concurrent Hash Tables via Relativistic
+ *   Programming", J. Triplett, P. E. McKenney, J. Walpole, USENIX ATC 2011.
+ *
+ *   Lookups run inside an RCU read-side critical section (new_urcu.c of
+ *   the Citrus tree) and only load pointers: they take no lock, write no
+ *   shared memory and never retry. Updates lock the stripe of their key
+ *   and publish a node with a single pointer store. Removed nodes are
+ *   not freed, as in Citrus, since a lookup may still be reading them.
+ *
+ *   A resize takes all the stripes, so it runs alone with the lookups:
+ *   - growing publishes a twice larger table whose buckets point into the
+ *     old chains, at the first node that belongs to each of them, then
+ *     unzips the chains: each pass makes every chain skip one run of
+ *     nodes of its sibling bucket, and a grace period separates passes
+ *     so that no lookup is left inside a run that now skips its nodes;
+ *   - shrinking appends each chain of the upper half of the table to its
+ *     sibling and publishes the half as large table.
+ *   Lookups compare keys, so the nodes of another bucket they go through
+ *   meanwhile are only a longer chain to them.
+ *
+ * rcuht.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "rcuht.h"
+
+LOCKS_DEFINE
+
+/* The bucket of a key is taken from the low bits of its hash */
+static inline uint64_t rl_hash(val_t val) {
+	return hash_murmur3((uint32_t)val);
+}
+
+static inline unsigned long rl_index(val_t val, unsigned long len) {
+	return rl_hash(val) & (len - 1);
+}
+
+static inline uint64_t rl_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static rl_node_t *rl_node_new(val_t val, rl_node_t *next) {
+	rl_node_t *node;
+
+	if ((node = (rl_node_t *)malloc(sizeof(rl_node_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	node->val = val;
+	node->next = next;
+	return node;
+}
+
+static rl_table_t *rl_table_new(unsigned long len) {
+	rl_table_t *t;
+
+	if ((t = (rl_table_t *)calloc(1, sizeof(rl_table_t) + len * sizeof(rl_node_t *))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	t->len = len;
+	return t;
+}
+
+static void rl_synchronize(ht_intset_t *set) {
+	urcu_synchronize();
+	set->nb_grace++;
+}
+
+/* Publishes a table, and waits until no lookup reads the previous one */
+static void rl_publish(ht_intset_t *set, rl_table_t *nt) {
+	rl_table_t *t = set->table;
+
+	AO_store_full((volatile AO_t *)&set->table, (AO_t)nt);
+	rl_synchronize(set);
+	free(t);
+}
+
+/* Doubles t, all the stripes locked */
+static void rl_expand(ht_intset_t *set, rl_table_t *t) {
+	rl_table_t *nt = rl_table_new(t->len << 1);
+	rl_node_t **runs, *n, *p, *q, *other;
+	unsigned long b, i, len = t->len, unzipped;
+
+	if ((runs = (rl_node_t **)malloc(len * sizeof(rl_node_t *))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	/* New buckets start at their first node in the old chain */
+	for (b = 0; b < len; b++) {
+		runs[b] = t->buckets[b];
+		for (n = t->buckets[b]; n != NULL; n = n->next) {
+			i = rl_index(n->val, nt->len);
+			if (nt->buckets[i] == NULL)
+				nt->buckets[i] = n;
+			if (nt->buckets[b] != NULL && nt->buckets[b + len] != NULL)
+				break;
+		}
+	}
+	rl_publish(set, nt);
+	/* runs[b] is the first node of the run of old bucket b left to unzip */
+	do {
+		unzipped = 0;
+		for (b = 0; b < len; b++) {
+			if ((p = runs[b]) == NULL)
+				continue;
+			i = rl_index(p->val, nt->len);
+			while (p->next != NULL && rl_index(p->next->val, nt->len) == i)
+				p = p->next;
+			if ((other = p->next) == NULL) {
+				runs[b] = NULL;
+				continue;
+			}
+			for (q = other; q != NULL && rl_index(q->val, nt->len) != i; q = q->next)
+				;
+			p->next = q;
+			runs[b] = other;
+			unzipped++;
+		}
+		if (unzipped > 0)
+			rl_synchronize(set);
+	} while (unzipped > 0);
+	free(runs);
+}
+
+/* Halves t, all the stripes locked */
+static void rl_shrink(ht_intset_t *set, rl_table_t *t) {
+	unsigned long b, len = t->len >> 1;
+	rl_table_t *nt = rl_table_new(len);
+	rl_node_t *n;
+
+	for (b = 0; b < len; b++) {
+		if ((n = t->buckets[b]) == NULL) {
+			nt->buckets[b] = t->buckets[b + len];
+			continue;
+		}
+		while (n->next != NULL)
+			n = n->next;
+		n->next = t->buckets[b + len];
+		nt->buckets[b] = t->buckets[b];
+	}
+	rl_publish(set, nt);
+}
+
+static unsigned long rl_count(ht_intset_t *set) {
+	unsigned long size = 0;
+	int i;
+
+	for (i = 0; i < RL_STRIPES; i++)
+		size += set->stripes[i].count;
+	return size;
+}
+
+static int rl_too_large(ht_intset_t *set, rl_table_t *t) {
+	return rl_count(set) > set->load * t->len && t->len < (1UL << RL_MAX_BITS);
+}
+
+static int rl_too_small(ht_intset_t *set, rl_table_t *t) {
+	return rl_count(set) < set->load * t->len / RL_SHRINK && t->len > set->initial_len;
+}
+
+/*
+ * Resizes t, unless another resize is going on or the stripes count no
+ * longer justifies it. Updates wait for the whole resize, lookups never.
+ */
+static void rl_resize(ht_intset_t *set, rl_table_t *t, int grow) {
+	uint64_t start, pause;
+	int i;
+
+	if (grow ? !rl_too_large(set, t) : !rl_too_small(set, t))
+		return;
+	if (pthread_mutex_trylock(&set->resize_lock) != 0)
+		return;
+	start = rl_now();
+	for (i = 0; i < RL_STRIPES; i++)
+		LOCK(&set->stripes[i].lock);
+	if (set->table == t) {
+		if (grow && rl_too_large(set, t)) {
+			rl_expand(set, t);
+			set->nb_grows++;
+		} else if (!grow && rl_too_small(set, t)) {
+			rl_shrink(set, t);
+			set->nb_shrinks++;
+		}
+	}
+	for (i = 0; i < RL_STRIPES; i++)
+		UNLOCK(&set->stripes[i].lock);
+	if ((pause = rl_now() - start) > set->max_resize_ns)
+		set->max_resize_ns = pause;
+	pthread_mutex_unlock(&set->resize_lock);
+}
+
+/* Locks the stripe of val and returns its bucket, no resize can run */
+static rl_node_t *volatile *rl_lock_bucket(ht_intset_t *set, val_t val,
+																					 rl_stripe_t **stripe, rl_table_t **table) {
+	uint64_t h = rl_hash(val);
+	rl_stripe_t *s = &set->stripes[h & (RL_STRIPES - 1)];
+	rl_table_t *t;
+
+	LOCK(&s->lock);
+	t = set->table;
+	*stripe = s;
+	*table = t;
+	return &t->buckets[h & (t->len - 1)];
+}
+
+ht_intset_t *ht_new(unsigned long nb_keys, unsigned int load) {
+	ht_intset_t *set;
+	unsigned long len = RL_STRIPES;
+	int i;
+
+	if (posix_memalign((void **)&set, sizeof(rl_stripe_t), sizeof(ht_intset_t)) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+	memset(set, 0, sizeof(ht_intset_t));
+	while (len * load < nb_keys && len < (1UL << RL_MAX_BITS))
+		len <<= 1;
+	set->table = rl_table_new(len);
+	set->load = load;
+	set->initial_len = len;
+	pthread_mutex_init(&set->resize_lock, NULL);
+	for (i = 0; i < RL_STRIPES; i++)
+		INIT_LOCK(&set->stripes[i].lock);
+	return set;
+}
+
+void ht_delete(ht_intset_t *set) {
+	rl_table_t *t = set->table;
+	rl_node_t *n, *next;
+	unsigned long b;
+	int i;
+
+	for (b = 0; b < t->len; b++) {
+		for (n = t->buckets[b]; n != NULL; n = next) {
+			next = n->next;
+			free(n);
+		}
+	}
+	free(t);
+	for (i = 0; i < RL_STRIPES; i++)
+		DESTROY_LOCK(&set->stripes[i].lock);
+	pthread_mutex_destroy(&set->resize_lock);
+	free(set);
+}
+
+static unsigned long rl_chain_length(rl_node_t *n) {
+	unsigned long len = 0;
+
+	for (; n != NULL; n = n->next)
+		len++;
+	return len;
+}
+
+int ht_size(ht_intset_t *set) {
+	rl_table_t *t = set->table;
+	unsigned long b;
+	int size = 0;
+
+	for (b = 0; b < t->len; b++)
+		size += rl_chain_length(t->buckets[b]);
+	return size;
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	uint64_t h = rl_hash(val);
+	rl_table_t *t;
+	rl_node_t *n;
+	int result = 0;
+
+	urcu_read_lock();
+	t = set->table;
+	for (n = t->buckets[h & (t->len - 1)]; n != NULL; n = n->next) {
+		if (n->val == val) {
+			result = 1;
+			break;
+		}
+	}
+	urcu_read_unlock();
+	return result;
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	rl_node_t *volatile *bucket, *n;
+	rl_stripe_t *s;
+	rl_table_t *t;
+	unsigned long share;
+	int grow;
+
+	bucket = rl_lock_bucket(set, val, &s, &t);
+	for (n = *bucket; n != NULL; n = n->next) {
+		if (n->val == val) {
+			UNLOCK(&s->lock);
+			return 0;
+		}
+	}
+	AO_store_release((volatile AO_t *)bucket, (AO_t)rl_node_new(val, *bucket));
+	/*
+	 * Only count the whole set when the stripe gets above its share, and
+	 * again every RL_RECHECK keys while it stays above, in case a resize
+	 * was going on the first time.
+	 */
+	share = set->load * (t->len / RL_STRIPES);
+	grow = ++s->count > share && (s->count - share) % RL_RECHECK == 1;
+	UNLOCK(&s->lock);
+	if (grow)
+		rl_resize(set, t, 1);
+	return 1;
+}
+
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	rl_node_t *volatile *bucket, *volatile *prev, *n;
+	rl_stripe_t *s;
+	rl_table_t *t;
+	unsigned long low;
+	int shrink = 0, result = 0;
+
+	bucket = rl_lock_bucket(set, val, &s, &t);
+	for (prev = bucket; (n = *prev) != NULL; prev = &n->next) {
+		if (n->val == val) {
+			*prev = n->next;
+			low = set->load * (t->len / RL_STRIPES) / RL_SHRINK;
+			shrink = --s->count <= low && (low - s->count) % RL_RECHECK == 0;
+			result = 1;
+			break;
+		}
+	}
+	UNLOCK(&s->lock);
+	if (shrink)
+		rl_resize(set, t, 0);
+	return result;
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No relativistic implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No relativistic implementation is available\n");
+	exit(1);
+}
+
+void ht_print_stats(ht_intset_t *set) {
+	rl_table_t *t = set->table;
+	unsigned long b, n, longest = 0;
+
+	for (b = 0; b < t->len; b++)
+		if ((n = rl_chain_length(t->buckets[b])) > longest)
+			longest = n;
+	printf("Buckets       : %lu (initial %lu, %lu grows, %lu shrinks, %d stripes)\n",
+				 t->len, set->initial_len, set->nb_grows, set->nb_shrinks, RL_STRIPES);
+	printf("  #grace      : %lu grace periods waited by resizes\n", set->nb_grace);
+	printf("  #max pause  : %.3f ms of updates blocked by a resize\n",
+				 set->max_resize_ns / 1e6);
+	printf("  #longest    : %lu nodes\n", longest);
+}
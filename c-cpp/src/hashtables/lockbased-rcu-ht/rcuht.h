@@ -0,0 +1,125 @@
+/*
+ * File:
+ *   rcuht.h
+ * Description:
+ *   Relativistic hash set: RCU readers that never wait and resizes that
+ *   unzip or zip the bucket chains in place, under grace periods.
+ *
+ * rcuht.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <atomic_ops.h>
+
+#include "locks.h"
+#include "hashfn.h"
+#include "urcu.h"
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_LOAD                    1
+#define DEFAULT_ELASTICITY              2
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+#define DEFAULT_GROW                    0
+
+#define MAXHTLENGTH                     65536
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+
+/* Hashtable length (# of buckets) */
+extern unsigned int maxhtlength;
+
+/* ################################################################### *
+ * RELATIVISTIC HASH TABLE
+ * ################################################################### */
+
+/*
+ * Updates of bucket b lock stripe b % RL_STRIPES. Tables have at least
+ * RL_STRIPES buckets and their length is a power of two, so the stripe
+ * of a key is the same in every table and a resize, which takes all the
+ * stripes, is the only writer of the chains while it runs.
+ */
+#define RL_STRIPES                      1024
+
+/* A table stops growing at 2^RL_MAX_BITS buckets */
+#define RL_MAX_BITS                     28
+
+/* Keys a stripe gains above its share between two counts of the set */
+#define RL_RECHECK                      16
+
+/* A table shrinks by half when it holds less than load / RL_SHRINK keys per bucket */
+#define RL_SHRINK                       4
+
+typedef struct rl_node {
+  val_t val;
+  struct rl_node *volatile next;
+} rl_node_t;
+
+typedef struct rl_table {
+  unsigned long len;              /* a power of two >= RL_STRIPES */
+  rl_node_t *volatile buckets[];
+} rl_table_t;
+
+typedef struct rl_stripe {
+  ptlock_t lock;
+  unsigned long count;            /* keys in the buckets of the stripe */
+} __attribute__((aligned(64))) rl_stripe_t;
+
+typedef struct ht_intset {
+  rl_table_t *volatile table;
+  pthread_mutex_t resize_lock;
+  unsigned int load;
+  rl_stripe_t stripes[RL_STRIPES];
+  unsigned long initial_len;
+  unsigned long nb_grows;
+  unsigned long nb_shrinks;
+  unsigned long nb_grace;         /* grace periods waited by resizes */
+  unsigned long max_resize_ns;    /* longest time updates were blocked */
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(unsigned long nb_keys, unsigned int load);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
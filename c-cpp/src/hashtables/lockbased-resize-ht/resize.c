@@ -0,0 +1,382 @@
+/*
+ * File:
+ *   resize.c
+ * Description:
+ *   Lock-striped chained hash set with incremental resizing.
+ *
+ *   Updates lock the stripe of their key's bucket. When a stripe holds
+ *   more than load keys per bucket, the table doubles: a twice larger
+ *   table is published as the next table and the buckets of the current
+ *   one are then migrated into it one at a time, under their stripe lock.
+ *   Every update migrates the next RS_MIGRATE_STEP buckets after its own
+ *   work, and an update whose bucket is not migrated yet migrates it
+ *   first, so no operation ever waits for the whole table. The update
+ *   counting the last bucket makes the next table the current one.
+ *
+ *   Lookups take no lock. During a migration they read the old bucket
+ *   until it is marked moved and the new one afterwards. A migrated
+ *   bucket keeps its chain, and removed nodes are not freed before the
+ *   set is, so a lookup that raced with a migration or a removal still
+ *   traverses a valid chain.
+ *
+ * resize.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "resize.h"
+
+LOCKS_DEFINE
+
+/* The bucket of a key is taken from the low bits of its hash */
+static inline uint64_t rs_hash(val_t val) {
+	return hash_murmur3((uint32_t)val);
+}
+
+static inline uint64_t rs_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void rs_max(volatile AO_t *max, AO_t v) {
+	AO_t m;
+
+	while ((m = *max) < v && !AO_compare_and_swap(max, m, v))
+		;
+}
+
+static rs_node_t *rs_node_new(val_t val, rs_node_t *next) {
+	rs_node_t *node;
+
+	if ((node = (rs_node_t *)malloc(sizeof(rs_node_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	node->val = val;
+	node->next = next;
+	return node;
+}
+
+static rs_table_t *rs_table_new(unsigned int bits) {
+	rs_table_t *t;
+
+	if ((t = (rs_table_t *)calloc(1, sizeof(rs_table_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	t->bits = bits;
+	t->len = 1UL << bits;
+	t->buckets = (rs_node_t *volatile *)calloc(t->len, sizeof(rs_node_t *));
+	t->moved = (volatile unsigned char *)calloc(t->len, 1);
+	if (t->buckets == NULL || t->moved == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	return t;
+}
+
+/*
+ * Copies bucket b of t into the two buckets of nt it splits into. The
+ * caller holds the stripe lock of b, which also guards both of them.
+ */
+static void rs_migrate_bucket(ht_intset_t *set, rs_table_t *t, rs_table_t *nt,
+															unsigned long b) {
+	rs_node_t *n;
+	unsigned long i, copied = 0;
+
+	for (n = t->buckets[b]; n != NULL; n = n->next) {
+		i = rs_hash(n->val) & (nt->len - 1);
+		AO_store_release((volatile AO_t *)&nt->buckets[i],
+										 (AO_t)rs_node_new(n->val, nt->buckets[i]));
+		copied++;
+	}
+	AO_nop_write();
+	t->moved[b] = 1;
+	if (copied > 0)
+		AO_fetch_and_add(&set->nb_copied, copied);
+}
+
+/* nt replaces t once all the buckets of t are migrated */
+static void rs_finish(ht_intset_t *set, rs_table_t *t, rs_table_t *nt) {
+	nt->old = t;
+	AO_store_full((volatile AO_t *)&set->table, (AO_t)nt);
+	AO_store_full((volatile AO_t *)&set->next, (AO_t)NULL);
+	rs_max(&set->max_migration_ns, rs_now() - set->migration_start);
+}
+
+/* Migrates the next RS_MIGRATE_STEP buckets, if a migration is going on */
+static void rs_help(ht_intset_t *set) {
+	rs_table_t *nt = (rs_table_t *)AO_load_full((volatile AO_t *)&set->next);
+	rs_table_t *t = set->table;
+	rs_stripe_t *s;
+	unsigned long b;
+	uint64_t start;
+	int k, done = 0;
+
+	/* t is newer than nt if migrations completed in between */
+	if (nt == NULL || nt->bits != t->bits + 1)
+		return;
+	start = rs_now();
+	for (k = 0; k < RS_MIGRATE_STEP; k++) {
+		/* Indices are per table, so a late helper never counts for the next one */
+		if ((b = AO_fetch_and_add1(&t->migrate_index)) >= t->len)
+			break;
+		s = &set->stripes[b & (RS_STRIPES - 1)];
+		LOCK(&s->lock);
+		if (!t->moved[b]) {
+			rs_migrate_bucket(set, t, nt, b);
+			done++;
+		}
+		UNLOCK(&s->lock);
+		if (AO_fetch_and_add1(&t->migrated) + 1 == t->len)
+			rs_finish(set, t, nt);
+	}
+	if (done > 0)
+		AO_fetch_and_add(&set->nb_steps, done);
+	if (k > 0)
+		rs_max(&set->max_step_ns, rs_now() - start);
+}
+
+/*
+ * Starts migrating t into a twice larger table, unless one already is,
+ * if the set holds more than load keys per bucket. The stripe counts are
+ * only summed when one stripe gets above its share, which a few of them
+ * always are when a table has few buckets per stripe.
+ */
+static void rs_grow(ht_intset_t *set, rs_table_t *t) {
+	rs_table_t *nt;
+	unsigned long size = 0;
+	int i;
+
+	for (i = 0; i < RS_STRIPES; i++)
+		size += set->stripes[i].count;
+	if (size <= set->load * t->len)
+		return;
+	if (pthread_mutex_trylock(&set->resize_lock) != 0)
+		return;
+	if (set->next == NULL && set->table == t && t->bits < RS_MAX_BITS) {
+		nt = rs_table_new(t->bits + 1);
+		set->migration_start = rs_now();
+		AO_store_full((volatile AO_t *)&set->next, (AO_t)nt);
+		AO_fetch_and_add1(&set->nb_resizes);
+	}
+	pthread_mutex_unlock(&set->resize_lock);
+}
+
+/*
+ * Locks the stripe of hash h and returns the bucket updates of h must
+ * use, after migrating it if a migration is going on. The next table is
+ * read before the current one, so that a migration that completes in
+ * between is seen as complete.
+ */
+static rs_node_t *volatile *rs_lock_bucket(ht_intset_t *set, uint64_t h,
+																					 rs_stripe_t **stripe, rs_table_t **table) {
+	rs_stripe_t *s = &set->stripes[h & (RS_STRIPES - 1)];
+	rs_table_t *nt, *t;
+	unsigned long b;
+
+	LOCK(&s->lock);
+	nt = (rs_table_t *)AO_load_full((volatile AO_t *)&set->next);
+	t = (rs_table_t *)AO_load_full((volatile AO_t *)&set->table);
+	if (nt != NULL && nt != t) {
+		b = h & (t->len - 1);
+		if (!t->moved[b]) {
+			rs_migrate_bucket(set, t, nt, b);
+			AO_fetch_and_add1(&set->nb_demand);
+		}
+		t = nt;
+	}
+	*stripe = s;
+	*table = t;
+	return &t->buckets[h & (t->len - 1)];
+}
+
+ht_intset_t *ht_new(unsigned long nb_keys, unsigned int load) {
+	ht_intset_t *set;
+	unsigned int bits = floor_log_2(RS_STRIPES);
+	int i;
+
+	if (posix_memalign((void **)&set, sizeof(rs_stripe_t), sizeof(ht_intset_t)) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+	memset(set, 0, sizeof(ht_intset_t));
+	while ((1UL << bits) * load < nb_keys && bits < RS_MAX_BITS)
+		bits++;
+	set->table = rs_table_new(bits);
+	set->next = NULL;
+	set->load = load;
+	set->initial_len = set->table->len;
+	pthread_mutex_init(&set->resize_lock, NULL);
+	for (i = 0; i < RS_STRIPES; i++)
+		INIT_LOCK(&set->stripes[i].lock);
+	return set;
+}
+
+/* Frees every table: each node is in the chains of exactly one of them */
+void ht_delete(ht_intset_t *set) {
+	rs_table_t *t, *old;
+	rs_node_t *n, *next;
+	unsigned long b;
+	int i;
+
+	if (set->next != NULL) {
+		set->next->old = set->table;
+		set->table = set->next;
+	}
+	for (t = set->table; t != NULL; t = old) {
+		old = t->old;
+		for (b = 0; b < t->len; b++) {
+			for (n = t->buckets[b]; n != NULL; n = next) {
+				next = n->next;
+				free(n);
+			}
+		}
+		free((void *)t->buckets);
+		free((void *)t->moved);
+		free(t);
+	}
+	for (i = 0; i < RS_STRIPES; i++)
+		DESTROY_LOCK(&set->stripes[i].lock);
+	pthread_mutex_destroy(&set->resize_lock);
+	free(set);
+}
+
+static unsigned long rs_chain_length(rs_node_t *n) {
+	unsigned long len = 0;
+
+	for (; n != NULL; n = n->next)
+		len++;
+	return len;
+}
+
+int ht_size(ht_intset_t *set) {
+	rs_table_t *t = set->table, *nt = set->next;
+	unsigned long b;
+	int size = 0;
+
+	for (b = 0; b < t->len; b++) {
+		if (nt != NULL && t->moved[b])
+			size += rs_chain_length(nt->buckets[b]) +
+				rs_chain_length(nt->buckets[b + t->len]);
+		else
+			size += rs_chain_length(t->buckets[b]);
+	}
+	return size;
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	uint64_t h = rs_hash(val);
+	rs_table_t *nt = (rs_table_t *)AO_load_full((volatile AO_t *)&set->next);
+	rs_table_t *t = (rs_table_t *)AO_load_full((volatile AO_t *)&set->table);
+	rs_node_t *n;
+
+	if (nt != NULL && nt->bits == t->bits + 1 && t->moved[h & (t->len - 1)]) {
+		/* The copies are read after the flag that publishes them */
+		AO_nop_read();
+		t = nt;
+	}
+	for (n = t->buckets[h & (t->len - 1)]; n != NULL; n = n->next)
+		if (n->val == val)
+			return 1;
+	return 0;
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	uint64_t h = rs_hash(val);
+	rs_node_t *volatile *bucket, *n;
+	rs_stripe_t *s;
+	rs_table_t *t;
+	unsigned long share;
+	int grow;
+
+	bucket = rs_lock_bucket(set, h, &s, &t);
+	for (n = *bucket; n != NULL; n = n->next) {
+		if (n->val == val) {
+			UNLOCK(&s->lock);
+			rs_help(set);
+			return 0;
+		}
+	}
+	AO_store_release((volatile AO_t *)bucket, (AO_t)rs_node_new(val, *bucket));
+	/* Counted again every RS_RECHECK keys, in case a migration was going on */
+	share = set->load * (t->len / RS_STRIPES);
+	grow = ++s->count > share && (s->count - share) % RS_RECHECK == 1;
+	UNLOCK(&s->lock);
+	rs_help(set);
+	if (grow)
+		rs_grow(set, t);
+	return 1;
+}
+
+/* Removed nodes are unlinked but not freed, lookups may be reading them */
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	uint64_t h = rs_hash(val);
+	rs_node_t *volatile *bucket, *volatile *prev, *n;
+	rs_stripe_t *s;
+	rs_table_t *t;
+	int result = 0;
+
+	bucket = rs_lock_bucket(set, h, &s, &t);
+	for (prev = bucket; (n = *prev) != NULL; prev = &n->next) {
+		if (n->val == val) {
+			*prev = n->next;
+			s->count--;
+			result = 1;
+			break;
+		}
+	}
+	UNLOCK(&s->lock);
+	rs_help(set);
+	return result;
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No resizable implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No resizable implementation is available\n");
+	exit(1);
+}
+
+void ht_print_stats(ht_intset_t *set) {
+	rs_table_t *t = set->table, *nt = set->next;
+	unsigned long b, n, longest = 0;
+
+	for (b = 0; b < t->len; b++)
+		if ((n = rs_chain_length(t->buckets[b])) > longest)
+			longest = n;
+	printf("Buckets       : %lu (initial %lu, %lu resizes, %d stripes)\n",
+				 t->len, set->initial_len, (unsigned long)set->nb_resizes, RS_STRIPES);
+	if (nt != NULL)
+		printf("  #migrating  : to %lu, %.1f%% done\n", nt->len,
+					 100.0 * t->migrated / t->len);
+	printf("  #migrated   : %lu buckets by update steps, %lu on first access\n",
+				 (unsigned long)set->nb_steps, (unsigned long)set->nb_demand);
+	printf("  #copied     : %lu nodes\n", (unsigned long)set->nb_copied);
+	printf("  #max pause  : %.3f us per update step, migrations took %.3f ms max\n",
+				 set->max_step_ns / 1000.0, set->max_migration_ns / 1e6);
+	printf("  #longest    : %lu nodes\n", longest);
+}
@@ -0,0 +1,139 @@
+/*
+ * File:
+ *   resize.h
+ * Description:
+ *   Lock-striped chained hash set that grows by migrating its buckets
+ *   incrementally, a few per update, instead of rehashing all at once.
+ *
+ * resize.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <atomic_ops.h>
+
+#include "locks.h"
+#include "hashfn.h"
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_LOAD                    1
+#define DEFAULT_ELASTICITY              2
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+#define DEFAULT_GROW                    0
+
+#define MAXHTLENGTH                     65536
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+
+/* Hashtable length (# of buckets) */
+extern unsigned int maxhtlength;
+
+/* ################################################################### *
+ * RESIZABLE HASH TABLE
+ * ################################################################### */
+
+/*
+ * Bucket b of a table is guarded by stripe b % RS_STRIPES. Tables have
+ * at least RS_STRIPES buckets and double when they grow, so bucket b of
+ * a table and the buckets b and b + len it splits into are guarded by
+ * the same stripe.
+ */
+#define RS_STRIPES                      1024
+
+/* Buckets an update migrates when a migration is in progress */
+#define RS_MIGRATE_STEP                 8
+
+/* Keys a stripe gains above its share between two counts of the set */
+#define RS_RECHECK                      16
+
+/* A table stops growing at 2^RS_MAX_BITS buckets */
+#define RS_MAX_BITS                     28
+
+typedef struct rs_node {
+  val_t val;
+  struct rs_node *volatile next;
+} rs_node_t;
+
+/*
+ * Buckets of a migrated table keep their chains, only their moved flag
+ * is set: the nodes are copied into the next table. A reader that went
+ * into the old table thus still finds the content the bucket had when
+ * it was migrated.
+ */
+typedef struct rs_table {
+  rs_node_t *volatile *buckets;
+  volatile unsigned char *moved;
+  unsigned long len;              /* a power of two >= RS_STRIPES */
+  unsigned int bits;
+  volatile AO_t migrate_index;    /* next bucket to migrate */
+  volatile AO_t migrated;         /* buckets whose migration is counted */
+  struct rs_table *old;           /* replaced tables, freed with the set */
+} rs_table_t;
+
+typedef struct rs_stripe {
+  ptlock_t lock;
+  unsigned long count;            /* keys in the buckets of the stripe */
+} __attribute__((aligned(64))) rs_stripe_t;
+
+typedef struct ht_intset {
+  rs_table_t *volatile table;
+  rs_table_t *volatile next;      /* table migrated into, or NULL */
+  pthread_mutex_t resize_lock;
+  unsigned int load;
+  rs_stripe_t stripes[RS_STRIPES];
+  unsigned long initial_len;
+  volatile AO_t nb_resizes;
+  volatile AO_t nb_steps;         /* buckets migrated by updates */
+  volatile AO_t nb_demand;        /* buckets migrated on first access */
+  volatile AO_t nb_copied;
+  volatile AO_t max_step_ns;
+  volatile AO_t max_migration_ns; /* from growth to the last bucket */
+  volatile AO_t migration_start;
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(unsigned long nb_keys, unsigned int load);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
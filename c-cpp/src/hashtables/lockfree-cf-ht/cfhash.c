@@ -0,0 +1,323 @@
+/*
+ * File:
+ *   cfhash.c
+ * Description:
+ *   C port of the contention-friendly hash map
+ *   "A Contention-Friendly Methodology for Search Structures"
+ *   T. Crain, V. Gramoli, M. Raynal, TR #hal-00668010, INRIA, 2012.
+ *
+ *   Operations only ever CAS a bucket head. Resizing is deferred to a
+ *   maintenance thread that builds the next table bucket by bucket: it
+ *   fills the two buckets a chain splits into, reusing the trailing run
+ *   of nodes that go to the same one and copying the others, then CASes
+ *   the old bucket to the dummy node of the old table. Operations that
+ *   find the dummy go on in the next table. The code follows
+ *   NonBlockingFriendlyHashMap.java.
+ *
+ * cfhash.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <unistd.h>
+
+#include "cfhash.h"
+
+static cf_node_t *cf_node_new(val_t val, cf_node_t *next) {
+	cf_node_t *node;
+
+	if ((node = (cf_node_t *)malloc(sizeof(cf_node_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	node->val = val;
+	node->next = next;
+	return node;
+}
+
+static cf_table_t *cf_table_new(unsigned long len) {
+	cf_table_t *t;
+
+	if ((t = (cf_table_t *)malloc(sizeof(cf_table_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	if ((t->buckets = (cf_node_t *volatile *)calloc(len, sizeof(cf_node_t *))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	t->len = len;
+	t->older = NULL;
+	return t;
+}
+
+/* The table to look into after finding the dummy of t */
+static inline cf_table_t *cf_next_table(ht_intset_t *set, cf_table_t *t) {
+	cf_table_t *t2 = set->table2;
+
+	if (t == set->table1)
+		return t2;
+	return set->table1;
+}
+
+/* Head of the chain of val, and where it was found */
+static inline cf_node_t *cf_first(ht_intset_t *set, int val, cf_table_t **table,
+																	unsigned long *index) {
+	cf_table_t *t = set->table1;
+	unsigned long i = (unsigned long)val & (t->len - 1);
+	cf_node_t *first = t->buckets[i];
+
+	while (first == &t->dummy) {
+		t = cf_next_table(set, t);
+		i = (unsigned long)val & (t->len - 1);
+		first = t->buckets[i];
+	}
+	*table = t;
+	*index = i;
+	return first;
+}
+
+static unsigned long cf_chain_length(cf_node_t *node) {
+	unsigned long n = 0;
+
+	for (; node != NULL; node = node->next)
+		n++;
+	return n;
+}
+
+/*
+ * Moves bucket i of table1 into buckets i and i + len of table2. Only the
+ * maintenance thread writes these two buckets until the old one points
+ * to the dummy, so they are simply rebuilt when the CAS fails.
+ */
+static void cf_rehash_bucket(ht_intset_t *set, unsigned long i) {
+	cf_table_t *t1 = set->table1, *t2 = set->table2;
+	unsigned long mask = t2->len - 1, idx, last_idx, k;
+	cf_node_t *e, *next, *last_run, *p;
+
+	do {
+		t2->buckets[i] = NULL;
+		t2->buckets[i + t1->len] = NULL;
+		e = t1->buckets[i];
+		if (e != NULL) {
+			next = e->next;
+			idx = (unsigned long)e->val & mask;
+			if (next == NULL) {
+				t2->buckets[idx] = e;
+			} else {
+				/* Reuse the trailing run of nodes going to the same bucket */
+				last_run = e;
+				last_idx = idx;
+				for (p = next; p != NULL; p = p->next) {
+					k = (unsigned long)p->val & mask;
+					if (k != last_idx) {
+						last_idx = k;
+						last_run = p;
+					}
+				}
+				t2->buckets[last_idx] = last_run;
+				for (p = e; p != last_run; p = p->next) {
+					k = (unsigned long)p->val & mask;
+					t2->buckets[k] = cf_node_new(p->val, t2->buckets[k]);
+					set->nb_cloned++;
+				}
+			}
+		}
+	} while (!ATOMIC_CAS_MB(&t1->buckets[i], e, &t1->dummy));
+}
+
+static void cf_rehash(ht_intset_t *set) {
+	cf_table_t *t1 = set->table1;
+	unsigned long i;
+
+	set->table2 = cf_table_new(t1->len << 1);
+	set->threshold = set->table2->len * set->load;
+	AO_nop_full();
+	for (i = 0; i < t1->len; i++)
+		cf_rehash_bucket(set, i);
+	set->table2->older = t1;
+	AO_store_full((volatile AO_t *)&set->table1, (AO_t)set->table2);
+	set->nb_resizes++;
+}
+
+static void *cf_maintenance(void *arg) {
+	ht_intset_t *set = (ht_intset_t *)arg;
+
+	while (!set->maint_stop) {
+		if ((unsigned long)ht_size(set) > set->threshold)
+			cf_rehash(set);
+		else
+			usleep(CF_MAINT_SLEEP);
+	}
+	return NULL;
+}
+
+ht_intset_t *ht_new(unsigned long nb_buckets, unsigned int load) {
+	ht_intset_t *set;
+	unsigned long len = 1;
+
+	if ((set = (ht_intset_t *)calloc(1, sizeof(ht_intset_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	while (len < nb_buckets)
+		len <<= 1;
+	set->table1 = cf_table_new(len);
+	set->initial_len = len;
+	set->load = load;
+	set->threshold = len * load;
+	set->maint_stop = 0;
+	if (pthread_create(&set->maint_thread, NULL, cf_maintenance, set) != 0) {
+		fprintf(stderr, "Error creating maintenance thread\n");
+		exit(1);
+	}
+	set->maint_running = 1;
+	return set;
+}
+
+void ht_stop_maintenance(ht_intset_t *set) {
+	if (set->maint_running) {
+		set->maint_stop = 1;
+		pthread_join(set->maint_thread, NULL);
+		set->maint_running = 0;
+	}
+}
+
+void ht_delete(ht_intset_t *set) {
+	cf_table_t *t, *older;
+	cf_node_t *node, *next;
+	unsigned long i;
+
+	ht_stop_maintenance(set);
+	/* Chains of the older tables are shared or leaked, as removed nodes */
+	for (i = 0; i < set->table1->len; i++) {
+		for (node = set->table1->buckets[i]; node != NULL; node = next) {
+			next = node->next;
+			free(node);
+		}
+	}
+	for (t = set->table1; t != NULL; t = older) {
+		older = t->older;
+		free((void *)t->buckets);
+		free(t);
+	}
+	free(set);
+}
+
+int ht_size(ht_intset_t *set) {
+	cf_table_t *t1 = set->table1, *t2;
+	unsigned long i;
+	int size = 0;
+
+	for (i = 0; i < t1->len; i++) {
+		if (t1->buckets[i] == &t1->dummy) {
+			t2 = cf_next_table(set, t1);
+			size += cf_chain_length(t2->buckets[i]);
+			size += cf_chain_length(t2->buckets[i + t1->len]);
+		} else {
+			size += cf_chain_length(t1->buckets[i]);
+		}
+	}
+	return size;
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	cf_table_t *t;
+	unsigned long i;
+	cf_node_t *e = cf_first(set, val, &t, &i);
+
+	while (e != NULL && e->val != val)
+		e = e->next;
+	return e != NULL;
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	cf_table_t *t;
+	unsigned long i;
+	cf_node_t *first, *e, *n;
+
+	while (1) {
+		first = cf_first(set, val, &t, &i);
+		for (e = first; e != NULL && e->val != val; e = e->next)
+			;
+		if (e != NULL)
+			return 0;
+		n = cf_node_new(val, first);
+		if (ATOMIC_CAS_MB(&t->buckets[i], first, n))
+			return 1;
+		free(n);
+	}
+}
+
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	cf_table_t *t;
+	unsigned long i;
+	cf_node_t *first, *e, *p, *new_first, *q;
+	unsigned long copies;
+
+	while (1) {
+		first = cf_first(set, val, &t, &i);
+		for (e = first; e != NULL && e->val != val; e = e->next)
+			;
+		if (e == NULL)
+			return 0;
+		/* Nodes after e stay, the ones before are copied */
+		new_first = e->next;
+		for (p = first, copies = 0; p != e; p = p->next, copies++)
+			new_first = cf_node_new(p->val, new_first);
+		if (ATOMIC_CAS_MB(&t->buckets[i], first, new_first)) {
+			if (copies > 0)
+				AO_fetch_and_add(&set->nb_remove_clones, copies);
+			return 1;
+		}
+		for (p = new_first; p != e->next; p = q) {
+			q = p->next;
+			free(p);
+		}
+	}
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No CAS-based implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No other implementation of atomic snapshot is available\n");
+	exit(1);
+}
+
+void ht_print_stats(ht_intset_t *set) {
+	cf_table_t *t = set->table1;
+	unsigned long i, used = 0, longest = 0, n;
+
+	for (i = 0; i < t->len; i++) {
+		if ((n = cf_chain_length(t->buckets[i])) > 0)
+			used++;
+		if (n > longest)
+			longest = n;
+	}
+	printf("Buckets       : %lu (initial %lu, %lu resizes by maintenance)\n",
+				 t->len, set->initial_len, set->nb_resizes);
+	printf("  #used       : %lu (longest chain %lu)\n", used, longest);
+	printf("  #cloned     : %lu by resizes, %lu by removals\n", set->nb_cloned,
+				 (unsigned long)set->nb_remove_clones);
+}
@@ -0,0 +1,127 @@
+/*
+ * File:
+ *   cfhash.h
+ * Description:
+ *   C port of the contention-friendly hash map
+ *   (java/src/hashtables/lockfree/NonBlockingFriendlyHashMap.java)
+ *   "A Contention-Friendly Methodology for Search Structures"
+ *   T. Crain, V. Gramoli, M. Raynal, TR #hal-00668010, INRIA, 2012.
+ *
+ * cfhash.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <atomic_ops.h>
+
+#include "tm.h"
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_LOAD                    1
+#define DEFAULT_ELASTICITY              4
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+#define DEFAULT_GROW                    0
+
+#define MAXHTLENGTH                     65536
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+#define ATOMIC_CAS_MB(a, e, v)          (AO_compare_and_swap_full((volatile AO_t *)(a), (AO_t)(e), (AO_t)(v)))
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+
+/* Sleep of the maintenance thread between two size checks (us) */
+#define CF_MAINT_SLEEP                  1000
+
+/* Hashtable length (# of buckets) */
+extern unsigned int maxhtlength;
+
+/* Hashtable seed */
+#ifdef TLS
+extern __thread unsigned int *rng_seed;
+#else /* ! TLS */
+extern pthread_key_t rng_seed_key;
+#endif /* ! TLS */
+
+/*
+ * Buckets hold immutable chains: an insertion CASes a new node in front
+ * of the chain, a removal CASes in a copy of the nodes that preceded the
+ * removed one. Unlinked nodes are not reclaimed, as in lockfree-list.
+ */
+typedef struct cf_node {
+  val_t val;
+  struct cf_node *next;
+} cf_node_t;
+
+/* A bucket pointing to dummy has moved to the next table */
+typedef struct cf_table {
+  cf_node_t *volatile *buckets;
+  unsigned long len;              /* a power of two */
+  cf_node_t dummy;
+  struct cf_table *older;         /* replaced tables, freed with the set */
+} cf_table_t;
+
+/*
+ * Updates never restructure the table: a maintenance thread doubles it
+ * when the keys outnumber load times the buckets, moving one bucket at
+ * a time while updates go on.
+ */
+typedef struct ht_intset {
+  cf_table_t *volatile table1;    /* the current table */
+  cf_table_t *volatile table2;    /* the one being filled, if any */
+  unsigned int load;
+  unsigned long threshold;
+  unsigned long initial_len;
+  unsigned long nb_resizes;
+  unsigned long nb_cloned;        /* nodes copied by resizes */
+  volatile AO_t nb_remove_clones; /* nodes copied by removals */
+  pthread_t maint_thread;
+  volatile int maint_stop;
+  int maint_running;
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(unsigned long nb_buckets, unsigned int load);
+void ht_stop_maintenance(ht_intset_t *set);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
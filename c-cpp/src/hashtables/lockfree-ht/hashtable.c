@@ -26,11 +26,25 @@
 
 #include "hashtable.h"
 
+#ifdef HT_FLAT_BUCKETS
+/* Tail sentinel shared by all the flat buckets */
+static node_t ht_tail = { VAL_MAX, NULL };
+#endif
+
 void ht_delete(ht_intset_t *set) {
   node_t *node, *next;
   int i;
   
   for (i=0; i < maxhtlength; i++) {
+#ifdef HT_FLAT_BUCKETS
+    /* Only the nodes between the inline head and the shared tail */
+    node = set->buckets[i].head.next;
+    while (node != &ht_tail) {
+      next = node->next;
+      free(node);
+      node = next;
+    }
+#else
     node = set->buckets[i]->head;
     while (node != NULL) {
       next = node->next;
@@ -38,6 +52,7 @@ void ht_delete(ht_intset_t *set) {
       node = next;
     }
     free(set->buckets[i]);
+#endif
   }
   free(set->buckets);
   free(set);
@@ -49,7 +64,7 @@ int ht_size(ht_intset_t *set) {
 	int i;
 	
 	for (i=0; i < maxhtlength; i++) {
-		node = set->buckets[i]->head->next;
+		node = HT_BUCKET(set, i)->head->next;
 		while (node->next) {
 			size++;
 			node = node->next;
@@ -79,6 +94,20 @@ ht_intset_t *ht_new() {
 		perror("malloc");
 		exit(1);
 	}  
+	set->hash = DEFAULT_HASH;
+	set->bits = hash_bits(maxhtlength);
+#ifdef HT_FLAT_BUCKETS
+	if (posix_memalign((void **)&set->buckets, 64, maxhtlength * sizeof(ht_bucket_t)) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+
+	for (i=0; i < maxhtlength; i++) {
+		set->buckets[i].head.val = VAL_MIN;
+		set->buckets[i].head.next = &ht_tail;
+		set->buckets[i].set.head = &set->buckets[i].head;
+	}
+#else
         if ((set->buckets = (void *)malloc((maxhtlength + 1)* sizeof(intset_t *))) == NULL) {
 	perror("malloc");
 	exit(1);
@@ -87,5 +116,22 @@ ht_intset_t *ht_new() {
 	for (i=0; i < maxhtlength; i++) {
 		set->buckets[i] = set_new();
 	}
+#endif
 	return set;
 }
+
+void ht_print_hist(ht_intset_t *set) {
+	hash_hist_t hist;
+	node_t *node;
+	unsigned long len;
+	int i;
+	
+	memset(&hist, 0, sizeof(hist));
+	for (i=0; i < maxhtlength; i++) {
+		len = 0;
+		for (node = HT_BUCKET(set, i)->head->next; node->next; node = node->next)
+			len++;
+		hash_hist_add(&hist, len);
+	}
+	hash_print_hist(set->hash, &hist);
+}
@@ -22,6 +22,8 @@
  */
 
 #include "../../linkedlists/lockfree-list/intset.h"
+#include "perfcount.h"
+#include "hashfn.h"
 
 #define DEFAULT_MOVE                    0
 #define DEFAULT_SNAPSHOT                0
@@ -29,6 +31,8 @@
 #define DEFAULT_ELASTICITY              4
 #define DEFAULT_ALTERNATE               0
 #define DEFAULT_EFFECTIVE               1
+#define DEFAULT_GROW                    0
+#define DEFAULT_KEY_STRIDE              1
 
 #define MAXHTLENGTH                     65536
 
@@ -42,11 +46,41 @@ extern __thread unsigned int *rng_seed;
 extern pthread_key_t rng_seed_key;
 #endif /* ! TLS */
 
+#ifdef HT_FLAT_BUCKETS
+/*
+ * A flat bucket holds the list head and its head sentinel in the bucket
+ * array, so that reaching the first key of a bucket takes one cache miss
+ * for the bucket and one for the key, instead of also going through the
+ * bucket pointer, the intset and a separately allocated sentinel. All
+ * buckets end with the same tail sentinel, which is never written.
+ */
+typedef struct ht_bucket {
+  intset_t set;                 /* set.head points to head below */
+  node_t head;
+} __attribute__((aligned(32))) ht_bucket_t;
+
+#  define HT_BUCKET(s, i)               (&(s)->buckets[i].set)
+#else
+#  define HT_BUCKET(s, i)               ((s)->buckets[i])
+#endif
+
 typedef struct ht_intset {
+#ifdef HT_FLAT_BUCKETS
+  ht_bucket_t *buckets;
+#else
   intset_t **buckets;
+#endif
+  int hash;                     /* HASH_IDENTITY, ... */
+  unsigned int bits;            /* maxhtlength is 2^bits */
 } ht_intset_t;
 
+/* Bucket of val */
+static inline int ht_index(ht_intset_t *set, val_t val) {
+  return (int)hash_index(set->hash, val, set->bits);
+}
+
 void ht_delete(ht_intset_t *set);
 int ht_size(ht_intset_t *set);
 int floor_log_2(unsigned int n);
 ht_intset_t *ht_new();
+void ht_print_hist(ht_intset_t *set);
@@ -26,31 +26,31 @@
 int ht_contains(ht_intset_t *set, int val, int transactional) {
 	int addr;
 	
-	addr = val % maxhtlength;
+	addr = ht_index(set, val);
 	if (transactional == 5)
-	  return set_contains(set->buckets[addr], val, 4);
+	  return set_contains(HT_BUCKET(set, addr), val, 4);
 	else
-	  return set_contains(set->buckets[addr], val, transactional);
+	  return set_contains(HT_BUCKET(set, addr), val, transactional);
 }
 
 int ht_add(ht_intset_t *set, int val, int transactional) {
 	int addr;
 	
-	addr = val % maxhtlength;
+	addr = ht_index(set, val);
 	if (transactional == 5)
-		return set_add(set->buckets[addr], val, 4);
+		return set_add(HT_BUCKET(set, addr), val, 4);
 	else 
-		return set_add(set->buckets[addr], val, transactional);
+		return set_add(HT_BUCKET(set, addr), val, transactional);
 }
 
 int ht_remove(ht_intset_t *set, int val, int transactional) {
 	int addr;
     
-	addr = val % maxhtlength;
+	addr = ht_index(set, val);
 	if (transactional == 5)
-		return set_remove(set->buckets[addr], val, 4);
+		return set_remove(HT_BUCKET(set, addr), val, 4);
 	else
-		return set_remove(set->buckets[addr], val, transactional);
+		return set_remove(HT_BUCKET(set, addr), val, transactional);
 }
 
 /* 
@@ -68,10 +68,10 @@ int ht_move_naive(ht_intset_t *set, int val1, int val2, int transactional) {
 	
 	int addr1, addr2;
 		
-	addr1 = val1 % maxhtlength;
-	addr2 = val2 % maxhtlength;
-	result =  (set_remove(set->buckets[addr1], val1, transactional) && 
-			   set_add(set->buckets[addr2], val2, transactional));
+	addr1 = ht_index(set, val1);
+	addr2 = ht_index(set, val2);
+	result =  (set_remove(HT_BUCKET(set, addr1), val1, transactional) && 
+			   set_add(HT_BUCKET(set, addr2), val2, transactional));
 	
 #elif defined STM
 	
@@ -81,8 +81,8 @@ int ht_move_naive(ht_intset_t *set, int val1, int val2, int transactional) {
 	if (transactional > 1) {
 	  
 	  TX_START(EL);
-	  addr1 = val1 % maxhtlength;
-	  prev = (node_t *)TX_LOAD(&set->buckets[addr1]->head);
+	  addr1 = ht_index(set, val1);
+	  prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr1)->head);
 	  next = (node_t *)TX_LOAD(&prev->next);
 	  while(1) {
 	    v = TX_LOAD(&next->val);
@@ -96,8 +96,8 @@ int ht_move_naive(ht_intset_t *set, int val1, int val2, int transactional) {
 	    TX_STORE(&prev->next, n);
 	    FREE(next, sizeof(node_t));
 	    /* Inserting */
-	    addr2 = val2 % maxhtlength;
-	    prev = (node_t *)TX_LOAD(&set->buckets[addr2]->head);
+	    addr2 = ht_index(set, val2);
+	    prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr2)->head);
 	    next = (node_t *)TX_LOAD(&prev->next);
 	    while(1) {
 	      v = TX_LOAD(&next->val);
@@ -116,8 +116,8 @@ int ht_move_naive(ht_intset_t *set, int val1, int val2, int transactional) {
 	} else { 
 
 	  TX_START(NL);
-	  addr1 = val1 % maxhtlength;
-	  prev = (node_t *)TX_LOAD(&set->buckets[addr1]->head);
+	  addr1 = ht_index(set, val1);
+	  prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr1)->head);
 	  next = (node_t *)TX_LOAD(&prev->next);
 	  while(1) {
 	    v = TX_LOAD(&next->val);
@@ -131,8 +131,8 @@ int ht_move_naive(ht_intset_t *set, int val1, int val2, int transactional) {
 	    TX_STORE(&prev->next, n);
 	    FREE(next, sizeof(node_t));
 	    /* Inserting */
-	    addr2 = val2 % maxhtlength;
-	    prev = (node_t *)TX_LOAD(&set->buckets[addr2]->head);
+	    addr2 = ht_index(set, val2);
+	    prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr2)->head);
 	    next = (node_t *)TX_LOAD(&prev->next);
 	    while(1) {
 	      v = TX_LOAD(&next->val);
@@ -172,12 +172,12 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 
 	int addr1, addr2;
 		
-	addr1 = val1 % maxhtlength;
-	addr2 = val2 % maxhtlength;
+	addr1 = ht_index(set, val1);
+	addr2 = ht_index(set, val2);
 
-	if (set_remove(set->buckets[addr1], val1, 0)) 
+	if (set_remove(HT_BUCKET(set, addr1), val1, 0)) 
 	  result = 1;
-	set_seq_add(set->buckets[addr2], val2, 0);
+	set_seq_add(HT_BUCKET(set, addr2), val2, 0);
 	return result;
 
 #elif defined STM
@@ -189,8 +189,8 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 	
 	  TX_START(EL);
 	  result = 0;
-	  addr1 = val1 % maxhtlength;
-	  prev = (node_t *)TX_LOAD(&set->buckets[addr1]->head);
+	  addr1 = ht_index(set, val1);
+	  prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr1)->head);
 	  next = (node_t *)TX_LOAD(&prev->next);
 	  while(1) {
 	    v = TX_LOAD(&next->val);
@@ -202,8 +202,8 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 	  next1 = next;
 	  if (v == val1) {
 	    /* Inserting */
-	    addr2 = val2 % maxhtlength;
-	    prev = (node_t *)TX_LOAD(&set->buckets[addr2]->head);
+	    addr2 = ht_index(set, val2);
+	    prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr2)->head);
 	    next = (node_t *)TX_LOAD(&prev->next);
 	    while(1) {
 	      v = TX_LOAD(&next->val);
@@ -228,8 +228,8 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 
 	  TX_START(NL);
 	  result = 0;
-	  addr1 = val1 % maxhtlength;
-	  prev = (node_t *)TX_LOAD(&set->buckets[addr1]->head);
+	  addr1 = ht_index(set, val1);
+	  prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr1)->head);
 	  next = (node_t *)TX_LOAD(&prev->next);
 	  while(1) {
 	    v = TX_LOAD(&next->val);
@@ -241,8 +241,8 @@ int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
 	  next1 = next;
 	  if (v == val1) {
 	    /* Inserting */
-	    addr2 = val2 % maxhtlength;
-	    prev = (node_t *)TX_LOAD(&set->buckets[addr2]->head);
+	    addr2 = ht_index(set, val2);
+	    prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr2)->head);
 	    next = (node_t *)TX_LOAD(&prev->next);
 	    while(1) {
 	      v = TX_LOAD(&next->val);
@@ -286,10 +286,10 @@ int ht_move_orrollback(ht_intset_t *set, int val1, int val2, int transactional)
 #ifdef SEQUENTIAL
 
 	int addr1, addr2;		
-	addr1 = val1 % maxhtlength;
-	addr2 = val2 % maxhtlength;
-	result =  (set_remove(set->buckets[addr1], val1, transactional) &&
-			   set_add(set->buckets[addr2], val2, transactional));
+	addr1 = ht_index(set, val1);
+	addr2 = ht_index(set, val2);
+	result =  (set_remove(HT_BUCKET(set, addr1), val1, transactional) &&
+			   set_add(HT_BUCKET(set, addr2), val2, transactional));
 	
 #elif defined STM
 
@@ -300,8 +300,8 @@ int ht_move_orrollback(ht_intset_t *set, int val1, int val2, int transactional)
 
 	  TX_START(EL);
 	  result = 0;
-	  addr1 = val1 % maxhtlength;
-	  prev = (node_t *)TX_LOAD(&set->buckets[addr1]->head);
+	  addr1 = ht_index(set, val1);
+	  prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr1)->head);
 	  next = (node_t *)TX_LOAD(&prev->next);
 	  while(1) {
 	    v = TX_LOAD(&next->val);
@@ -316,8 +316,8 @@ int ht_move_orrollback(ht_intset_t *set, int val1, int val2, int transactional)
 	    n = (node_t *)TX_LOAD(&next->next);
 	    TX_STORE(&prev->next, n);
 	    /* Inserting */
-	    addr2 = val2 % maxhtlength;
-	    prev = (node_t *)TX_LOAD(&set->buckets[addr2]->head);
+	    addr2 = ht_index(set, val2);
+	    prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr2)->head);
 	    next = (node_t *)TX_LOAD(&prev->next);
 	    while(1) {
 	      v = TX_LOAD(&next->val);
@@ -341,8 +341,8 @@ int ht_move_orrollback(ht_intset_t *set, int val1, int val2, int transactional)
 	  
 	  TX_START(NL);
 	  result = 0;
-	  addr1 = val1 % maxhtlength;
-	  prev = (node_t *)TX_LOAD(&set->buckets[addr1]->head);
+	  addr1 = ht_index(set, val1);
+	  prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr1)->head);
 	  next = (node_t *)TX_LOAD(&prev->next);
 	  while(1) {
 	    v = TX_LOAD(&next->val);
@@ -357,8 +357,8 @@ int ht_move_orrollback(ht_intset_t *set, int val1, int val2, int transactional)
 	    n = (node_t *)TX_LOAD(&next->next);
 	    TX_STORE(&prev->next, n);
 	    /* Inserting */
-	    addr2 = val2 % maxhtlength;
-	    prev = (node_t *)TX_LOAD(&set->buckets[addr2]->head);
+	    addr2 = ht_index(set, val2);
+	    prev = (node_t *)TX_LOAD(&HT_BUCKET(set, addr2)->head);
 	    next = (node_t *)TX_LOAD(&prev->next);
 	    while(1) {
 	      v = TX_LOAD(&next->val);
@@ -407,7 +407,7 @@ int ht_snapshot(ht_intset_t *set, int transactional) {
 	node_t *next;
 	
 	for (i=0; i < maxhtlength; i++) {
-		next = set->buckets[i]->head->next;
+		next = HT_BUCKET(set, i)->head->next;
 		while(next->next) {
 			sum += next->val;
 			next = next->next;
@@ -424,7 +424,7 @@ int ht_snapshot(ht_intset_t *set, int transactional) {
 	TX_START(NL);
 	result = 0;
 	for (i=0; i < maxhtlength; i++) {
-		next = (node_t *)TX_LOAD(&set->buckets[i]->head->next);
+		next = (node_t *)TX_LOAD(&HT_BUCKET(set, i)->head->next);
 		while(next->next) {
 			sum += TX_LOAD(&next->val);
 			next = (node_t *)TX_LOAD(&next->next);
@@ -99,12 +99,14 @@ inline long rand_range_re(unsigned int *seed, long r) {
 typedef struct thread_data {
   val_t first;
 	long range;
+	long stride;
 	int update;
 	int move;
 	int snapshot;
 	int unit_tx;
 	int alternate;
 	int effective;
+	int grow;
 	unsigned long nb_add;
 	unsigned long nb_added;
 	unsigned long nb_remove;
@@ -133,6 +135,11 @@ typedef struct thread_data {
 	unsigned long failures_because_contention;
 } thread_data_t;
 
+/* Keys of the workers: multiples of the key stride in [1, range] */
+static inline long rand_key_re(thread_data_t *d) {
+	return d->stride * rand_range_re(&d->seed, d->range / d->stride);
+}
+
 
 void *test(void *data) {
 	int val2, numtx, r, last = -1;
@@ -162,9 +169,9 @@ void *test(void *data) {
 	    
 	    if (mnext) { // move
 	      
-	      if (last == -1) val = rand_range_re(&d->seed, d->range);
+	      if (last == -1) val = rand_key_re(d);
 	      else val = last;
-	      val2 = rand_range_re(&d->seed, d->range);
+	      val2 = rand_key_re(d);
 	      if (ht_move(d->set, val, val2, TRANSACTIONAL)) {
 					d->nb_moved++;
 					last = -1;
@@ -173,10 +180,12 @@ void *test(void *data) {
 	      
 	    } else if (last < 0) { // add
 	      
-	      val = rand_range_re(&d->seed, d->range);
+	      val = rand_key_re(d);
 	      if (ht_add(d->set, val, TRANSACTIONAL)) {
 					d->nb_added++;
-					last = val;
+					/* When growing, some adds are not followed by a remove */
+					if (d->grow == 0 || rand_range_re(&d->seed, 100) > d->grow)
+						last = val;
 	      } 				
 	      d->nb_add++;
 	      
@@ -189,7 +198,7 @@ void *test(void *data) {
 					}
 	      } else {
 					/* Random computation only in non-alternated cases */
-					val = rand_range_re(&d->seed, d->range);
+					val = rand_key_re(d);
 					/* Remove one random value */
 					if (ht_remove(d->set, val, TRANSACTIONAL)) {
 						d->nb_removed++;
@@ -210,18 +219,18 @@ void *test(void *data) {
 							val = d->first;
 							last = val;
 						} else { // last >= 0
-							val = rand_range_re(&d->seed, d->range);
+							val = rand_key_re(d);
 							last = -1;
 						}
 					} else { // update != 0
 						if (last < 0) {
-							val = rand_range_re(&d->seed, d->range);
+							val = rand_key_re(d);
 							//last = val;
 						} else {
 							val = last;
 						}
 					}
-	      }	else val = rand_range_re(&d->seed, d->range);
+	      }	else val = rand_key_re(d);
 				
 	      if (ht_contains(d->set, val, TRANSACTIONAL)) 
 					d->nb_found++;
@@ -297,7 +306,7 @@ void *test2(void *data)
 						flag = 1;
 					} else {
 						/* Random computation only in non-alternated cases */
-						newval = rand_range_re(&d->seed, d->range);
+						newval = rand_key_re(d);
 						if (ht_remove(d->set, newval, TRANSACTIONAL)) {  
 							d->nb_removed++;
 							/* Repeat until successful, to avoid size variations */
@@ -307,7 +316,7 @@ void *test2(void *data)
 					}
 	      } 
 	    } else { /* move */
-	      val = rand_range_re(&d->seed, d->range);
+	      val = rand_key_re(d);
 	      if (ht_move(d->set, last, val, TRANSACTIONAL)) {
 					d->nb_moved++;
 					last = val;
@@ -317,7 +326,7 @@ void *test2(void *data)
 	  } else {
 	    if (val >= d->update + d->snapshot) { /* read-only without snapshot */
 	      /* Look for random value */
-	      val = rand_range_re(&d->seed, d->range);
+	      val = rand_key_re(d);
 	      if (ht_contains(d->set, val, TRANSACTIONAL))
 					d->nb_found++;
 				d->nb_contains++;
@@ -351,7 +360,7 @@ void print_set(intset_t *set) {
 void print_ht(ht_intset_t *set) {
 	int i;
 	for (i=0; i < maxhtlength; i++) {
-		print_set(set->buckets[i]);
+		print_set(HT_BUCKET(set, i));
 	}
 }
 
@@ -369,6 +378,9 @@ int main(int argc, char **argv)
 		{"move-rate",                 required_argument, NULL, 'a'},
 		{"snapshot-rate",             required_argument, NULL, 's'},
 		{"elasticity",                required_argument, NULL, 'x'},
+		{"grow",                      required_argument, NULL, 'g'},
+		{"hash",                      required_argument, NULL, 'H'},
+		{"key-stride",                required_argument, NULL, 'K'},
 		{NULL, 0, NULL, 0}
 	};
 	
@@ -399,11 +411,14 @@ int main(int argc, char **argv)
 	int unit_tx = DEFAULT_ELASTICITY;
 	int alternate = DEFAULT_ALTERNATE;
 	int effective = DEFAULT_EFFECTIVE;
+	int grow = DEFAULT_GROW;
+	int hash = DEFAULT_HASH;
+	long stride = DEFAULT_KEY_STRIDE;
 	sigset_t block_set;
 	
 	while(1) {
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:a:s:l:x:", long_options, &i);
+		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:a:s:l:x:g:H:K:", long_options, &i);
 		
 		if(c == -1)
 			break;
@@ -447,6 +462,12 @@ int main(int argc, char **argv)
 								 "        Percentage of snapshot transactions (default=" XSTR(DEFAULT_SNAPSHOT) ")\n"
 								 "  -l , --load-factor <int>\n"
 								 "        Ratio of keys over buckets (default=" XSTR(DEFAULT_LOAD) ")\n"
+								 "  -g, --grow <int>\n"
+								 "        Percentage of successful adds never removed, the set grows (default=" XSTR(DEFAULT_GROW) ")\n"
+								 "  -H, --hash <int>\n"
+								 "        Hash function (0=identity, 1=fibonacci, 2=murmur3, 3=wyhash, default=" XSTR(DEFAULT_HASH) ")\n"
+								 "  -K, --key-stride <int>\n"
+								 "        Keys are multiples of this stride (default=" XSTR(DEFAULT_KEY_STRIDE) ")\n"
 								 "  -x, --elasticity (default=4)\n"
 								 "        Use elastic transactions\n"
 								 "        0 = non-protected,\n"
@@ -493,6 +514,15 @@ int main(int argc, char **argv)
 				case 'x':
 					unit_tx = atoi(optarg);
 					break;
+				case 'g':
+					grow = atoi(optarg);
+					break;
+				case 'H':
+					hash = atoi(optarg);
+					break;
+				case 'K':
+					stride = atol(optarg);
+					break;
 				case '?':
 					printf("Use -h or --help for help\n");
 					exit(0);
@@ -510,6 +540,9 @@ int main(int argc, char **argv)
 	assert(snapshot >= 0 && snapshot <= (100-update));
 	assert(initial < MAXHTLENGTH);
 	assert(initial >= load_factor);
+	assert(grow >= 0 && grow <= 100);
+	assert(hash >= 0 && hash < HASH_NB_FUNCTIONS);
+	assert(stride >= 1 && range / stride >= initial);
 	
 	printf("Set type     : lock-free hash table\n");
 	printf("Duration     : %d\n", duration);
@@ -524,6 +557,9 @@ int main(int argc, char **argv)
 	printf("Elasticity   : %d\n", unit_tx);
 	printf("Alternate    : %d\n", alternate);	
 	printf("Effective    : %d\n", effective);
+	printf("Grow         : %d\n", grow);
+	printf("Hash function: %s\n", hash_names[hash]);
+	printf("Key stride   : %ld\n", stride);
 	printf("Type sizes   : int=%d/long=%d/ptr=%d/word=%d\n",
 				 (int)sizeof(int),
 				 (int)sizeof(long),
@@ -547,8 +583,9 @@ int main(int argc, char **argv)
 	else
 		srand(seed);
 	
-	maxhtlength = (unsigned int) initial / load_factor;
+	maxhtlength = hash_pow2(initial / load_factor, MAXHTLENGTH);
 	set = ht_new();
+	set->hash = hash;
 	
 	stop = 0;
 	
@@ -560,9 +597,8 @@ int main(int argc, char **argv)
 	// Populate set 
 	printf("Adding %d entries to set\n", initial);
 	i = 0;
-	maxhtlength = (int) (initial / load_factor);
 	while (i < initial) {
-		val = rand_range(range);
+		val = stride * rand_range(range / stride);
 		if (ht_add(set, val, 0)) {
 		  last = val;
 		  i++;			
@@ -572,8 +608,12 @@ int main(int argc, char **argv)
 	printf("Set size     : %d\n", size);
 	printf("Bucket amount: %d\n", maxhtlength);
 	printf("Load         : %d\n", load_factor);
+#ifdef HT_FLAT_BUCKETS
+	printf("Buckets      : flat, %d B each\n", (int)sizeof(ht_bucket_t));
+#endif
 	
 	// Access set from all threads 
+	PERF_START();
 	barrier_init(&barrier, nb_threads + 1);
 	pthread_attr_init(&attr);
 	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
@@ -581,6 +621,7 @@ int main(int argc, char **argv)
 		printf("Creating thread %d\n", i);
 		data[i].first = last;
 		data[i].range = range;
+		data[i].stride = stride;
 		data[i].update = update;
 		data[i].load_factor = load_factor;
 		data[i].move = move;
@@ -588,6 +629,7 @@ int main(int argc, char **argv)
 		data[i].unit_tx = unit_tx;
 		data[i].alternate = alternate;
 		data[i].effective = effective;
+		data[i].grow = grow;
 		data[i].nb_add = 0;
 		data[i].nb_added = 0;
 		data[i].nb_remove = 0;
@@ -642,6 +684,7 @@ int main(int argc, char **argv)
 			exit(1);
 		}
 	}
+	PERF_STOP();
 	duration = (end.tv_sec * 1000 + end.tv_usec / 1000) - (start.tv_sec * 1000 + start.tv_usec / 1000);
 	aborts = 0;
 	aborts_locked_read = 0;
@@ -741,6 +784,8 @@ int main(int argc, char **argv)
 	printf("  #dup-w      : %lu (%f / s)\n", aborts_double_write, aborts_double_write * 1000.0 / duration);
 	printf("  #failures   : %lu\n",  failures_because_contention);
 	printf("Max retries   : %lu\n", max_retries);
+	PERF_PRINT_STATS(reads + updates + snapshots);
+	ht_print_hist(set);
 	
 	// Delete set 
 	ht_delete(set);
@@ -0,0 +1,425 @@
+/*
+ * File:
+ *   nbhm.c
+ * Description:
+ *   C port of Cliff Click's non-blocking hash map
+ *   "A Lock-Free Wait-Free Hash Table", C. Click, Stanford EE380, 2007.
+ *
+ *   Keys and values live in two arrays probed linearly. A key slot is
+ *   claimed once with a CAS and never reused within a table; the value
+ *   slot then moves through the states of nbhm.h, again with CAS only.
+ *   When probes get too long, a new table is hung off the old one and
+ *   every thread that runs into the old table copies a chunk of it,
+ *   boxing each value (NB_PRIME) so that no update can slip in behind the
+ *   copy. The table that finishes being copied is promoted to the top.
+ *   The code follows NonBlockingCliffHashMap.java function by function.
+ *
+ * nbhm.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "nbhm.h"
+
+static nb_kvs_t *nb_copy_slot_and_check(ht_intset_t *set, nb_kvs_t *oldkvs,
+																				unsigned long idx, AO_t expval);
+static AO_t nb_put_if_match(ht_intset_t *set, nb_kvs_t *kvs, uint32_t key,
+														AO_t putval, AO_t expval);
+
+/* Single-word Wang/Jenkins hash, as in the Java map */
+static inline uint32_t nb_hash(uint32_t h) {
+	h += (h << 15) ^ 0xffffcd7d;
+	h ^= (h >> 10);
+	h += (h << 3);
+	h ^= (h >> 6);
+	h += (h << 2) + (h << 14);
+	return h ^ (h >> 16);
+}
+
+/* Stripe of the calling thread, handed out round robin */
+static __thread int nb_stripe = -1;
+static volatile AO_t nb_stripes;
+
+static inline void nb_counter_add(nb_counter_t *c, AO_t n) {
+	if (nb_stripe < 0)
+		nb_stripe = AO_fetch_and_add1(&nb_stripes) % NB_COUNTER_STRIPES;
+	AO_fetch_and_add(&c->cell[nb_stripe].n, n);
+}
+
+static inline long nb_counter_sum(nb_counter_t *c) {
+	AO_t sum = 0;
+	int i;
+
+	for (i = 0; i < NB_COUNTER_STRIPES; i++)
+		sum += c->cell[i].n;
+	return (long)sum;
+}
+
+static inline unsigned long nb_reprobe_limit(unsigned long len) {
+	return NB_REPROBE_LIMIT + (len >> 2);
+}
+
+static inline int nb_table_full(nb_kvs_t *kvs, unsigned long reprobes) {
+	return reprobes >= NB_REPROBE_LIMIT &&
+		nb_counter_sum(&kvs->slots) >= (long)nb_reprobe_limit(kvs->len);
+}
+
+static nb_kvs_t *nb_kvs_new(unsigned int log2) {
+	nb_kvs_t *kvs;
+
+	if ((kvs = (nb_kvs_t *)calloc(1, sizeof(nb_kvs_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	kvs->len = 1UL << log2;
+	kvs->keys = (volatile AO_t *)calloc(kvs->len, sizeof(AO_t));
+	kvs->vals = (volatile AO_t *)calloc(kvs->len, sizeof(AO_t));
+	if (kvs->keys == NULL || kvs->vals == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	return kvs;
+}
+
+static void nb_kvs_free(nb_kvs_t *kvs) {
+	free((void *)kvs->keys);
+	free((void *)kvs->vals);
+	free(kvs);
+}
+
+static inline int nb_match(AO_t v, AO_t expval) {
+	switch (expval) {
+	case NB_MATCH_ANY:
+		return v == NB_V_PRESENT;
+	case NB_V_TOMB:
+		return v == NB_V_NULL || v == NB_V_TOMB;
+	default:
+		return v == expval;
+	}
+}
+
+/*
+ * Starts a resize of kvs unless one is under way, and returns the new
+ * table. The new size follows the Java heuristics: double if a quarter
+ * of the slots hold live keys, quadruple if half do, otherwise keep the
+ * size and just drop the dead keys, unless the last resize was recent
+ * and most claimed slots are dead anyway.
+ */
+static nb_kvs_t *nb_resize(ht_intset_t *set, nb_kvs_t *kvs) {
+	nb_kvs_t *newkvs = kvs->newkvs;
+	unsigned long oldlen = kvs->len, sz, newsz;
+	unsigned int log2;
+	struct timeval now;
+
+	if (newkvs != NULL)
+		return newkvs;
+	sz = nb_counter_sum(&set->size);
+	newsz = sz;
+	if (sz >= (oldlen >> 2)) {
+		newsz = oldlen << 1;
+		if (sz >= (oldlen >> 1))
+			newsz = oldlen << 2;
+	}
+	gettimeofday(&now, NULL);
+	if (newsz <= oldlen && now.tv_sec <= set->last_resize.tv_sec + 10 &&
+			nb_counter_sum(&kvs->slots) >= (long)(sz << 1))
+		newsz = oldlen << 1;
+	if (newsz < oldlen)
+		newsz = oldlen;
+	for (log2 = NB_MIN_SIZE_LOG; (1UL << log2) < newsz; log2++)
+		;
+	/* Someone else may have won while we were sizing */
+	if ((newkvs = kvs->newkvs) != NULL)
+		return newkvs;
+	newkvs = nb_kvs_new(log2);
+	if (ATOMIC_CAS_MB(&kvs->newkvs, NULL, newkvs)) {
+		set->last_resize = now;
+		AO_fetch_and_add1(&set->nb_resizes);
+	} else {
+		nb_kvs_free(newkvs);
+		newkvs = kvs->newkvs;
+	}
+	return newkvs;
+}
+
+/* Counts workdone more copied slots and promotes the new table once done */
+static void nb_copy_check_and_promote(ht_intset_t *set, nb_kvs_t *oldkvs,
+																			unsigned long workdone) {
+	unsigned long oldlen = oldkvs->len;
+	AO_t done = oldkvs->copy_done;
+
+	if (workdone > 0)
+		done = AO_fetch_and_add_full(&oldkvs->copy_done, workdone);
+	if (done + workdone == oldlen && set->kvs == oldkvs &&
+			ATOMIC_CAS_MB(&set->kvs, oldkvs, oldkvs->newkvs))
+		/* Readers may still be in the old table, keep it around */
+		oldkvs->newkvs->older = oldkvs;
+}
+
+/*
+ * Copies slot idx of oldkvs into newkvs. Returns 1 if this call did the
+ * copy, 0 if another thread did (or is doing) it.
+ */
+static int nb_copy_slot(ht_intset_t *set, unsigned long idx, nb_kvs_t *oldkvs,
+												nb_kvs_t *newkvs) {
+	AO_t key, oldval, box;
+	int copied;
+
+	/* Kill empty key slots so that nothing new lands in the old table */
+	while ((key = oldkvs->keys[idx]) == NB_K_EMPTY)
+		ATOMIC_CAS_MB(&oldkvs->keys[idx], NB_K_EMPTY, NB_K_TOMB);
+	oldval = oldkvs->vals[idx];
+	while (!NB_IS_PRIME(oldval)) {
+		box = (oldval == NB_V_NULL || oldval == NB_V_TOMB) ? NB_V_TOMBPRIME : oldval | NB_PRIME;
+		if (ATOMIC_CAS_MB(&oldkvs->vals[idx], oldval, box)) {
+			if (box == NB_V_TOMBPRIME)
+				return 1;
+			oldval = box;
+			break;
+		}
+		oldval = oldkvs->vals[idx];
+	}
+	if (oldval == NB_V_TOMBPRIME)
+		return 0;
+	copied = nb_put_if_match(set, newkvs, (uint32_t)key, NB_UNPRIME(oldval), NB_V_NULL) == NB_V_NULL;
+	if (copied)
+		AO_fetch_and_add1(&set->nb_copied);
+	while (oldval != NB_V_TOMBPRIME &&
+				 !ATOMIC_CAS_MB(&oldkvs->vals[idx], oldval, NB_V_TOMBPRIME))
+		oldval = oldkvs->vals[idx];
+	return copied;
+}
+
+/*
+ * Copies a chunk of oldkvs, or all of it when copy_all is set or when
+ * every chunk has been claimed and the copy still is not done.
+ */
+static void nb_help_copy_impl(ht_intset_t *set, nb_kvs_t *oldkvs, int copy_all) {
+	nb_kvs_t *newkvs = oldkvs->newkvs;
+	unsigned long oldlen = oldkvs->len, i, workdone;
+	unsigned long min_copy_work = oldlen < NB_MIN_COPY_WORK ? oldlen : NB_MIN_COPY_WORK;
+	long panic_start = -1;
+	AO_t copyidx = 0;
+
+	while (oldkvs->copy_done < oldlen) {
+		if (panic_start == -1) {
+			copyidx = oldkvs->copy_idx;
+			while (copyidx < (oldlen << 1) &&
+						 !ATOMIC_CAS_MB(&oldkvs->copy_idx, copyidx, copyidx + min_copy_work))
+				copyidx = oldkvs->copy_idx;
+			if (!(copyidx < (oldlen << 1)))
+				panic_start = copyidx;
+		}
+		workdone = 0;
+		for (i = 0; i < min_copy_work; i++)
+			if (nb_copy_slot(set, (copyidx + i) & (oldlen - 1), oldkvs, newkvs))
+				workdone++;
+		if (workdone > 0)
+			nb_copy_check_and_promote(set, oldkvs, workdone);
+		copyidx += min_copy_work;
+		if (!copy_all && panic_start == -1)
+			return;
+	}
+	nb_copy_check_and_promote(set, oldkvs, 0);
+}
+
+/* Helps the copy of the top table, if any, then returns helper */
+static nb_kvs_t *nb_help_copy(ht_intset_t *set, nb_kvs_t *helper) {
+	nb_kvs_t *top = set->kvs;
+
+	if (top->newkvs == NULL)
+		return helper;
+	nb_help_copy_impl(set, top, 0);
+	return helper;
+}
+
+static nb_kvs_t *nb_copy_slot_and_check(ht_intset_t *set, nb_kvs_t *oldkvs,
+																				unsigned long idx, AO_t expval) {
+	nb_kvs_t *newkvs = oldkvs->newkvs;
+
+	if (nb_copy_slot(set, idx, oldkvs, newkvs))
+		nb_copy_check_and_promote(set, oldkvs, 1);
+	return expval == NB_V_NULL ? newkvs : nb_help_copy(set, newkvs);
+}
+
+static int nb_get(ht_intset_t *set, nb_kvs_t *kvs, uint32_t key) {
+	unsigned long mask = kvs->len - 1, idx = nb_hash(key) & mask, reprobes = 0;
+	AO_t k, v;
+	nb_kvs_t *newkvs;
+
+	while (1) {
+		k = kvs->keys[idx];
+		v = kvs->vals[idx];
+		if (k == NB_K_EMPTY)
+			return 0;
+		newkvs = kvs->newkvs;
+		if (k == NB_K_KEY(key)) {
+			if (!NB_IS_PRIME(v))
+				return v == NB_V_PRESENT;
+			return nb_get(set, nb_copy_slot_and_check(set, kvs, idx, NB_V_NULL), key);
+		}
+		if (++reprobes >= nb_reprobe_limit(kvs->len) || k == NB_K_TOMB)
+			return newkvs == NULL ? 0 : nb_get(set, nb_help_copy(set, newkvs), key);
+		idx = (idx + 1) & mask;
+	}
+}
+
+/*
+ * Sets the value of key to putval if its current value matches expval
+ * (NB_MATCH_ANY: present, NB_V_TOMB: absent, NB_V_NULL: never set, used
+ * by copies), and returns the value found.
+ */
+static AO_t nb_put_if_match(ht_intset_t *set, nb_kvs_t *kvs, uint32_t key,
+														AO_t putval, AO_t expval) {
+	unsigned long mask = kvs->len - 1, idx = nb_hash(key) & mask, reprobes = 0;
+	AO_t k, v;
+	nb_kvs_t *newkvs;
+
+	while (1) {
+		v = kvs->vals[idx];
+		k = kvs->keys[idx];
+		if (k == NB_K_EMPTY) {
+			/* Removing a key that never was in this table */
+			if (putval == NB_V_TOMB)
+				return putval;
+			if (ATOMIC_CAS_MB(&kvs->keys[idx], NB_K_EMPTY, NB_K_KEY(key))) {
+				nb_counter_add(&kvs->slots, 1);
+				break;
+			}
+			k = kvs->keys[idx];
+		}
+		newkvs = kvs->newkvs;
+		if (k == NB_K_KEY(key))
+			break;
+		if (++reprobes >= nb_reprobe_limit(kvs->len) || k == NB_K_TOMB) {
+			newkvs = nb_resize(set, kvs);
+			if (expval != NB_V_NULL)
+				nb_help_copy(set, newkvs);
+			return nb_put_if_match(set, newkvs, key, putval, expval);
+		}
+		idx = (idx + 1) & mask;
+	}
+
+	if (putval == v)
+		return v;
+	newkvs = kvs->newkvs;
+	if (newkvs == NULL &&
+			((v == NB_V_NULL && nb_table_full(kvs, reprobes)) || NB_IS_PRIME(v)))
+		newkvs = nb_resize(set, kvs);
+	if (newkvs != NULL)
+		return nb_put_if_match(set, nb_copy_slot_and_check(set, kvs, idx, expval),
+													 key, putval, expval);
+
+	while (1) {
+		if (!nb_match(v, expval))
+			return v;
+		if (ATOMIC_CAS_MB(&kvs->vals[idx], v, putval)) {
+			if (expval != NB_V_NULL) {
+				if ((v == NB_V_NULL || v == NB_V_TOMB) && putval != NB_V_TOMB)
+					nb_counter_add(&set->size, 1);
+				if (!(v == NB_V_NULL || v == NB_V_TOMB) && putval == NB_V_TOMB)
+					nb_counter_add(&set->size, (AO_t)-1);
+			}
+			return v;
+		}
+		v = kvs->vals[idx];
+		if (NB_IS_PRIME(v))
+			return nb_put_if_match(set, nb_copy_slot_and_check(set, kvs, idx, expval),
+														 key, putval, expval);
+	}
+}
+
+ht_intset_t *ht_new(unsigned long initial) {
+	ht_intset_t *set;
+	unsigned int i;
+
+	if ((set = (ht_intset_t *)calloc(1, sizeof(ht_intset_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	for (i = NB_MIN_SIZE_LOG; (1UL << i) < (initial << 2); i++)
+		;
+	set->kvs = nb_kvs_new(i);
+	set->initial_len = set->kvs->len;
+	gettimeofday(&set->last_resize, NULL);
+	return set;
+}
+
+void ht_delete(ht_intset_t *set) {
+	nb_kvs_t *kvs, *older;
+
+	/* An unfinished copy hangs off the top table */
+	if (set->kvs->newkvs != NULL)
+		nb_kvs_free(set->kvs->newkvs);
+	for (kvs = set->kvs; kvs != NULL; kvs = older) {
+		older = kvs->older;
+		nb_kvs_free(kvs);
+	}
+	free(set);
+}
+
+int ht_size(ht_intset_t *set) {
+	return (int)nb_counter_sum(&set->size);
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	return nb_get(set, set->kvs, (uint32_t)val);
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	AO_t v = nb_put_if_match(set, set->kvs, (uint32_t)val, NB_V_PRESENT, NB_V_TOMB);
+
+	return v == NB_V_NULL || v == NB_V_TOMB;
+}
+
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	return nb_put_if_match(set, set->kvs, (uint32_t)val, NB_V_TOMB, NB_MATCH_ANY) == NB_V_PRESENT;
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No CAS-based implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No other implementation of atomic snapshot is available\n");
+	exit(1);
+}
+
+void ht_print_stats(ht_intset_t *set) {
+	nb_kvs_t *kvs = set->kvs;
+	unsigned long i, live = 0, dead = 0;
+
+	for (i = 0; i < kvs->len; i++) {
+		if (kvs->keys[i] == NB_K_EMPTY || kvs->keys[i] == NB_K_TOMB)
+			continue;
+		if (NB_UNPRIME(kvs->vals[i]) == NB_V_PRESENT)
+			live++;
+		else
+			dead++;
+	}
+	printf("Slots         : %lu (initial %lu, %lu resizes%s)\n", kvs->len,
+				 set->initial_len, (unsigned long)set->nb_resizes,
+				 kvs->newkvs != NULL ? ", one in progress" : "");
+	printf("  #live       : %lu (%.1f%%)\n", live, 100.0 * live / kvs->len);
+	printf("  #dead keys  : %lu (%.1f%%)\n", dead, 100.0 * dead / kvs->len);
+	printf("  #copied     : %lu keys moved by resizes\n", (unsigned long)set->nb_copied);
+}
@@ -0,0 +1,143 @@
+/*
+ * File:
+ *   nbhm.h
+ * Description:
+ *   C port of Cliff Click's non-blocking hash map (NonBlockingHashMap,
+ *   java/src/hashtables/lockfree/NonBlockingCliffHashMap.java) used as
+ *   an integer set.
+ *
+ * nbhm.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <atomic_ops.h>
+
+#include "tm.h"
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_ELASTICITY              4
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+#define DEFAULT_GROW                    0
+
+#define MAXHTLENGTH                     65536
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+#define ATOMIC_CAS_MB(a, e, v)          (AO_compare_and_swap_full((volatile AO_t *)(a), (AO_t)(e), (AO_t)(v)))
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+
+/*
+ * Key slots go from empty to a key, or to NB_K_TOMB when a copy kills an
+ * empty slot so that nothing gets inserted in an old table. Value slots
+ * follow the state machine of the Java map: empty (NB_V_NULL), present,
+ * deleted (NB_V_TOMB), and boxed with NB_PRIME while being copied to the
+ * next table; NB_V_TOMBPRIME marks a slot whose copy is over.
+ */
+#define NB_K_EMPTY                      0
+#define NB_K_KEY(k)                     ((AO_t)(uint32_t)(k) | (1UL << 32))
+#define NB_K_TOMB                       (2UL << 32)
+
+#define NB_V_NULL                       0
+#define NB_V_PRESENT                    1
+#define NB_V_TOMB                       2
+#define NB_PRIME                        4
+#define NB_V_TOMBPRIME                  (NB_V_TOMB | NB_PRIME)
+#define NB_IS_PRIME(v)                  ((v) & NB_PRIME)
+#define NB_UNPRIME(v)                   ((v) & ~(AO_t)NB_PRIME)
+
+/* Expected values of nb_put_if_match besides NB_V_NULL and NB_V_TOMB */
+#define NB_MATCH_ANY                    ((AO_t)-1)
+
+#define NB_MIN_SIZE_LOG                 3
+#define NB_REPROBE_LIMIT                10
+
+/* Slots copied per claim when helping a resize */
+#define NB_MIN_COPY_WORK                1024
+
+/*
+ * Striped counter, after the ConcurrentAutoTable of the Java map: each
+ * thread adds to its own cache line and readers sum all of them.
+ */
+#define NB_COUNTER_STRIPES              64
+#define NB_CACHE_LINE                   64
+
+typedef struct nb_counter {
+  struct {
+    volatile AO_t n;
+    char pad[NB_CACHE_LINE - sizeof(AO_t)];
+  } cell[NB_COUNTER_STRIPES];
+} nb_counter_t;
+
+/* Hashtable seed */
+#ifdef TLS
+extern __thread unsigned int *rng_seed;
+#else /* ! TLS */
+extern pthread_key_t rng_seed_key;
+#endif /* ! TLS */
+
+typedef struct nb_kvs {
+  unsigned long len;              /* a power of two */
+  volatile AO_t *keys;
+  volatile AO_t *vals;
+  nb_counter_t slots;             /* key slots claimed */
+  struct nb_kvs *volatile newkvs; /* the table being copied to */
+  volatile AO_t copy_idx;         /* next chunk to claim for copying */
+  volatile AO_t copy_done;        /* slots copied */
+  struct nb_kvs *older;           /* replaced tables, freed with the set */
+} nb_kvs_t;
+
+typedef struct ht_intset {
+  nb_kvs_t *volatile kvs;
+  nb_counter_t size;              /* shared by all the tables */
+  unsigned long initial_len;
+  volatile AO_t nb_resizes;
+  volatile AO_t nb_copied;        /* live keys moved by copies */
+  struct timeval last_resize;
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(unsigned long initial);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
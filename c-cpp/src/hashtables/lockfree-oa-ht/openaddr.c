@@ -0,0 +1,332 @@
+/*
+ * File:
+ *   openaddr.c
+ * Description:
+ *   Lock-free open-addressing hash set.
+ *
+ *   Slots are probed linearly, one group of OA_GROUP slots at a time.
+ *   Next to the slot words, a byte array holds a 7-bit tag of the hash of
+ *   every occupied slot (top bit set) or 0 for an empty one, so that a
+ *   single vector compare finds the candidate slots and the empty ones of
+ *   a whole group; only candidates have their slot word read. A slot is
+ *   claimed with a CAS on its word and its tag is written afterwards, so a
+ *   zero tag is only trusted once the slot word confirms it is empty.
+ *   Tombstones keep their key and the set grows by chaining tables (see
+ *   openaddr.h).
+ *
+ * openaddr.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "openaddr.h"
+
+static inline uint64_t oa_hash(uint32_t key) {
+	return (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+}
+
+static inline uint8_t oa_tag(uint64_t h) {
+	return 0x80 | ((h >> 24) & 0x7F);
+}
+
+/* First slot of the group the probe sequence of h starts with */
+static inline unsigned long oa_start(oa_table_t *t, uint64_t h) {
+	return (unsigned long)(h >> (64 - t->bits)) & ~(unsigned long)(OA_GROUP - 1);
+}
+
+/*
+ * Bitmasks of the slots of the group at tags whose tag equals tag and of
+ * the empty ones. Slot i of the group is bit i << OA_SHIFT.
+ */
+#if defined(__AVX2__) && !defined(NO_SIMD)
+#  define OA_SHIFT                      0
+static inline uint64_t oa_match(volatile uint8_t *tags, uint8_t tag, uint64_t *empty) {
+	__m256i t = _mm256_load_si256((const __m256i *)tags);
+
+	*empty = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(t, _mm256_setzero_si256()));
+	return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(t, _mm256_set1_epi8((char)tag)));
+}
+#elif defined(__SSE2__) && !defined(NO_SIMD)
+#  define OA_SHIFT                      0
+static inline uint64_t oa_match(volatile uint8_t *tags, uint8_t tag, uint64_t *empty) {
+	__m128i t = _mm_load_si128((const __m128i *)tags);
+
+	*empty = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(t, _mm_setzero_si128()));
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(t, _mm_set1_epi8((char)tag)));
+}
+#else
+/* SWAR on 8 tags: the high bit of each matching byte is set */
+#  define OA_SHIFT                      3
+#  define OA_LO7                        0x7F7F7F7F7F7F7F7FULL
+static inline uint64_t oa_match(volatile uint8_t *tags, uint8_t tag, uint64_t *empty) {
+	uint64_t t = *(volatile uint64_t *)tags;
+	uint64_t x = t ^ (0x0101010101010101ULL * tag);
+
+	*empty = ~t & ~OA_LO7;
+	return ~(((x & OA_LO7) + OA_LO7) | x | OA_LO7);
+}
+#endif
+
+static inline unsigned long oa_first(uint64_t mask) {
+	return __builtin_ctzll(mask) >> OA_SHIFT;
+}
+
+static oa_table_t *oa_table_new(unsigned int bits) {
+	oa_table_t *t;
+	void *p;
+
+	if ((t = (oa_table_t *)malloc(sizeof(oa_table_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	t->bits = bits;
+	t->nb_slots = 1UL << bits;
+	t->next = NULL;
+	if (posix_memalign(&p, 64, t->nb_slots) != 0) {
+		perror("posix_memalign");
+		exit(1);
+	}
+	memset(p, OA_TAG_EMPTY, t->nb_slots);
+	t->tags = (volatile uint8_t *)p;
+	if ((p = calloc(t->nb_slots, sizeof(uint64_t))) == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	t->slots = (volatile uint64_t *)p;
+	return t;
+}
+
+static void oa_table_delete(oa_table_t *t) {
+	free((void *)t->tags);
+	free((void *)t->slots);
+	free(t);
+}
+
+/*
+ * Chains a table after t, twice as large up to OA_MAX_BITS, unless
+ * another thread did it first. Returns the next table.
+ */
+static oa_table_t *oa_grow(ht_intset_t *set, oa_table_t *t) {
+	oa_table_t *n;
+
+	if (t->next != NULL)
+		return t->next;
+	n = oa_table_new(t->bits < OA_MAX_BITS ? t->bits + 1 : t->bits);
+	if (!ATOMIC_CAS_MB(&t->next, NULL, n)) {
+		oa_table_delete(n);
+		return t->next;
+	}
+	AO_fetch_and_add_full(&set->nb_slots, n->nb_slots);
+	AO_fetch_and_add1_full(&set->nb_tables);
+	return n;
+}
+
+/*
+ * Returns the slot of table t holding key, -1 when the probe sequence
+ * reaches an empty slot first and -2 when it gives up after OA_MAX_PROBE
+ * groups. When inserted is not NULL, the key is put in the first empty
+ * slot instead, and *inserted tells whether this call claimed it.
+ */
+static long oa_probe(oa_table_t *t, uint32_t key, int *inserted) {
+	uint64_t h = oa_hash(key), m, empty, w;
+	uint8_t tag = oa_tag(h);
+	unsigned long g = oa_start(t, h), i, n;
+
+	for (n = 0; n < t->nb_slots && n < OA_MAX_PROBE * OA_GROUP; n += OA_GROUP) {
+		m = oa_match(t->tags + g, tag, &empty);
+		for (; m != 0; m &= m - 1) {
+			i = g + oa_first(m);
+			if (t->slots[i] != OA_EMPTY && OA_KEY(t->slots[i]) == key)
+				return i;
+		}
+		for (; empty != 0; empty &= empty - 1) {
+			i = g + oa_first(empty);
+			w = t->slots[i];
+			if (w == OA_EMPTY) {
+				if (inserted == NULL)
+					return -1;
+				if (ATOMIC_CAS_MB(&t->slots[i], OA_EMPTY, OA_LIVE | key)) {
+					t->tags[i] = tag;
+					*inserted = 1;
+					return i;
+				}
+				w = t->slots[i];
+			}
+			/* Claimed, but its tag is not written yet */
+			t->tags[i] = oa_tag(oa_hash(OA_KEY(w)));
+			if (OA_KEY(w) == key)
+				return i;
+		}
+		g = (g + OA_GROUP) & (t->nb_slots - 1);
+	}
+	return -2;
+}
+
+/*
+ * Returns the slot holding key and sets *table to its table, or returns
+ * -1 when the key has no slot. When inserted is not NULL, the key is
+ * put in a slot instead, chaining a new table if the last one is too
+ * full, and *inserted tells whether this call claimed the slot.
+ */
+static long oa_lookup(ht_intset_t *set, uint32_t key, int *inserted,
+											oa_table_t **table) {
+	oa_table_t *t = set->first;
+	long i;
+
+	while ((i = oa_probe(t, key, inserted)) == -2) {
+		if (t->next != NULL)
+			t = t->next;
+		else if (inserted != NULL)
+			t = oa_grow(set, t);
+		else
+			return -1;
+	}
+	*table = t;
+	return i;
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	oa_table_t *t;
+	long i = oa_lookup(set, (uint32_t)val, NULL, &t);
+
+	return i >= 0 && OA_STATE(t->slots[i]) == OA_LIVE;
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	oa_table_t *t;
+	int inserted = 0;
+	long i = oa_lookup(set, (uint32_t)val, &inserted, &t);
+	uint64_t w;
+
+	if (inserted)
+		return 1;
+	/* The key has a slot already, revive it if it is a tombstone */
+	do {
+		w = t->slots[i];
+		if (OA_STATE(w) == OA_LIVE)
+			return 0;
+	} while (!ATOMIC_CAS_MB(&t->slots[i], w, OA_LIVE | (uint32_t)val));
+	return 1;
+}
+
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	oa_table_t *t;
+	long i = oa_lookup(set, (uint32_t)val, NULL, &t);
+	uint64_t w;
+
+	if (i < 0)
+		return 0;
+	do {
+		w = t->slots[i];
+		if (OA_STATE(w) != OA_LIVE)
+			return 0;
+	} while (!ATOMIC_CAS_MB(&t->slots[i], w, OA_DEAD | (uint32_t)val));
+	return 1;
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No CAS-based implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No other implementation of atomic snapshot is available\n");
+	exit(1);
+}
+
+/*
+ * The first table gets 2 * initial / load slots, so that with the default
+ * load factor of 1 at most half of its slots are taken by the initial
+ * keys. Further keys of the range go to the tables chained as it fills.
+ */
+ht_intset_t *ht_new(int initial, int load) {
+	ht_intset_t *set;
+	unsigned long want = 2 * (unsigned long)initial / load;
+	unsigned int bits;
+
+	if ((set = (ht_intset_t *)malloc(sizeof(ht_intset_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	bits = floor_log_2(2 * OA_GROUP);
+	while ((1UL << bits) < want && bits < OA_MAX_BITS)
+		bits++;
+	set->first = oa_table_new(bits);
+	set->nb_slots = set->first->nb_slots;
+	set->nb_tables = 1;
+	return set;
+}
+
+void ht_delete(ht_intset_t *set) {
+	oa_table_t *t, *n;
+
+	for (t = set->first; t != NULL; t = n) {
+		n = t->next;
+		oa_table_delete(t);
+	}
+	free(set);
+}
+
+int ht_size(ht_intset_t *set) {
+	oa_table_t *t;
+	unsigned long i;
+	int size = 0;
+
+	for (t = set->first; t != NULL; t = t->next)
+		for (i = 0; i < t->nb_slots; i++)
+			if (OA_STATE(t->slots[i]) == OA_LIVE)
+				size++;
+	return size;
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+/* Probe length of a key: groups visited before the one holding it */
+void ht_print_stats(ht_intset_t *set) {
+	unsigned long i, live, dead, groups, max, d;
+	oa_table_t *t;
+	uint64_t w;
+
+	printf("Slots         : %lu in %lu tables (%s, %d tags per probe)\n",
+				 (unsigned long)set->nb_slots, (unsigned long)set->nb_tables,
+				 OA_SIMD_NAME, OA_GROUP);
+	for (t = set->first; t != NULL; t = t->next) {
+		live = dead = groups = max = 0;
+		for (i = 0; i < t->nb_slots; i++) {
+			w = t->slots[i];
+			if (w == OA_EMPTY)
+				continue;
+			if (OA_STATE(w) == OA_LIVE)
+				live++;
+			else
+				dead++;
+			d = ((i & ~(unsigned long)(OA_GROUP - 1)) - oa_start(t, oa_hash(OA_KEY(w))))
+				& (t->nb_slots - 1);
+			d /= OA_GROUP;
+			groups += d;
+			if (d > max)
+				max = d;
+		}
+		printf("  #table      : %lu slots\n", t->nb_slots);
+		printf("  #live       : %lu (%.1f%%)\n", live, 100.0 * live / t->nb_slots);
+		printf("  #tombstones : %lu (%.1f%%)\n", dead, 100.0 * dead / t->nb_slots);
+		printf("  #extra grps : %.3f avg, %lu max\n",
+					 live + dead ? (double)groups / (live + dead) : 0.0, max);
+	}
+}
@@ -0,0 +1,139 @@
+/*
+ * File:
+ *   openaddr.h
+ * Description:
+ *   Lock-free open-addressing hash set with one-byte tags probed a group
+ *   at a time (16 slots with SSE2, 32 with AVX2, 8 without SIMD).
+ *
+ * openaddr.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#include <atomic_ops.h>
+
+#include "tm.h"
+
+#if defined(__AVX2__) && !defined(NO_SIMD)
+#  include <immintrin.h>
+#  define OA_GROUP                      32
+#  define OA_SIMD_NAME                  "avx2"
+#elif defined(__SSE2__) && !defined(NO_SIMD)
+#  include <emmintrin.h>
+#  define OA_GROUP                      16
+#  define OA_SIMD_NAME                  "sse2"
+#else
+#  define OA_GROUP                      8
+#  define OA_SIMD_NAME                  "swar"
+#endif
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_LOAD                    1
+#define DEFAULT_ELASTICITY              4
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+#define DEFAULT_GROW                    0
+
+#define MAXHTLENGTH                     65536
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+#define ATOMIC_CAS_MB(a, e, v)          (AO_compare_and_swap_full((volatile AO_t *)(a), (AO_t)(e), (AO_t)(v)))
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+
+/*
+ * A slot word holds a key in its low 32 bits and its state above. Once
+ * a slot holds a key it keeps it forever: removing the key leaves a
+ * tombstone (OA_DEAD) that only the same key can revive. Lookups can
+ * thus stop at the first empty slot, and two inserts of the same key
+ * always race on the same slot, without locks.
+ * The price is one slot per distinct key ever inserted. Instead of
+ * moving keys, the set grows by chaining tables of twice the size: a
+ * key goes to the first table where its probe sequence reaches an
+ * empty slot within OA_MAX_PROBE groups. Slots never become empty
+ * again, so a table a key skipped stays skipped for that key, and
+ * every lookup walks the chain the same way the inserts did.
+ */
+#define OA_EMPTY                        0ULL
+#define OA_LIVE                         (1ULL << 32)
+#define OA_DEAD                         (2ULL << 32)
+#define OA_STATE(w)                     ((w) & ~0xFFFFFFFFULL)
+#define OA_KEY(w)                       ((uint32_t)(w))
+
+/* Tag of an empty slot, occupied slots have the top bit set */
+#define OA_TAG_EMPTY                    0
+
+/* Slots are allocated lazily by the OS, 64M slots take 576MB at most */
+#define OA_MAX_BITS                     26
+
+/* Groups probed in a table before trying the next one */
+#define OA_MAX_PROBE                    16
+
+/* Hashtable length (# of buckets) */
+extern unsigned int maxhtlength;
+
+/* Hashtable seed */
+#ifdef TLS
+extern __thread unsigned int *rng_seed;
+#else /* ! TLS */
+extern pthread_key_t rng_seed_key;
+#endif /* ! TLS */
+
+typedef struct oa_table {
+  volatile uint8_t *tags;       /* one byte per slot, OA_GROUP aligned */
+  volatile uint64_t *slots;
+  unsigned long nb_slots;       /* a power of two */
+  unsigned int bits;
+  struct oa_table *volatile next;
+} oa_table_t;
+
+typedef struct ht_intset {
+  oa_table_t *first;
+  volatile AO_t nb_slots;       /* in all the tables */
+  volatile AO_t nb_tables;
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(int initial, int load);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
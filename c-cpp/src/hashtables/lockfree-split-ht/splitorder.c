@@ -0,0 +1,231 @@
+/*
+ * File:
+ *   splitorder.c
+ * Description:
+ *   Resizable lock-free hash table using split-ordered lists
+ *   "Split-Ordered Lists: Lock-Free Extensible Hash Tables"
+ *   O. Shalev, N. Shavit, J. ACM 53(3), p. 379-405, 2006.
+ *
+ *   Keys are stored in the lock-free Harris list of lockfree-list, sorted
+ *   by their bit-reversed value, so that the keys of bucket b (key mod
+ *   size) form a contiguous run that starts at the sentinel of b. The
+ *   sentinel of bucket b is inserted lazily, after the one of its parent
+ *   (b without its most significant bit), which it splits in two. The list
+ *   operations are the harris_* ones, started from a bucket sentinel
+ *   instead of the list head.
+ *
+ * splitorder.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "splitorder.h"
+
+static inline uint32_t so_reverse(uint32_t k) {
+	k = ((k >> 1) & 0x55555555) | ((k & 0x55555555) << 1);
+	k = ((k >> 2) & 0x33333333) | ((k & 0x33333333) << 2);
+	k = ((k >> 4) & 0x0F0F0F0F) | ((k & 0x0F0F0F0F) << 4);
+	k = ((k >> 8) & 0x00FF00FF) | ((k & 0x00FF00FF) << 8);
+	return (k >> 16) | (k << 16);
+}
+
+/* Regular keys are odd once reversed, sentinel keys are even */
+static inline val_t so_regular_key(int val) {
+	return (val_t)so_reverse((uint32_t)val | SO_HIBIT);
+}
+
+static inline val_t so_sentinel_key(unsigned int bucket) {
+	return (val_t)so_reverse(bucket);
+}
+
+static inline unsigned int so_parent(unsigned int bucket) {
+	unsigned int msb = 1U << floor_log_2(bucket);
+
+	return bucket & ~msb;
+}
+
+static node_t *so_get_bucket(ht_intset_t *set, unsigned int bucket) {
+	node_t **segment = set->segments[bucket >> SO_SEGMENT_BITS];
+
+	if (segment == NULL)
+		return NULL;
+	return segment[bucket & (SO_SEGMENT_SIZE - 1)];
+}
+
+static void so_set_bucket(ht_intset_t *set, unsigned int bucket, node_t *sentinel) {
+	node_t ***slot = &set->segments[bucket >> SO_SEGMENT_BITS];
+	node_t **segment = *slot;
+
+	if (segment == NULL) {
+		if ((segment = (node_t **)calloc(SO_SEGMENT_SIZE, sizeof(node_t *))) == NULL) {
+			perror("calloc");
+			exit(1);
+		}
+		if (!ATOMIC_CAS_MB(slot, NULL, segment)) {
+			free(segment);
+			segment = *slot;
+		}
+	}
+	/* Racing initialisations insert the same sentinel node */
+	ATOMIC_CAS_MB(&segment[bucket & (SO_SEGMENT_SIZE - 1)], NULL, sentinel);
+}
+
+/*
+ * Inserts the sentinel of bucket into the list, starting from the
+ * sentinel of its parent, and returns it. Another thread may have
+ * inserted it first, in which case that node is returned.
+ */
+static node_t *so_initialise_bucket(ht_intset_t *set, unsigned int bucket) {
+	unsigned int parent = so_parent(bucket);
+	node_t *start, *left_node, *right_node, *sentinel;
+	intset_t sub;
+	val_t key = so_sentinel_key(bucket);
+
+	if ((start = so_get_bucket(set, parent)) == NULL)
+		start = so_initialise_bucket(set, parent);
+	sub.head = start;
+	left_node = start;
+	do {
+		right_node = harris_search(&sub, key, &left_node);
+		if (right_node->val == key) {
+			sentinel = right_node;
+			break;
+		}
+		sentinel = new_node(key, right_node, 0);
+		/* mem-bar between node creation and insertion */
+		AO_nop_full();
+		if (ATOMIC_CAS_MB(&left_node->next, right_node, sentinel)) {
+			AO_fetch_and_add1_full(&set->nb_sentinels);
+			break;
+		}
+		free(sentinel);
+	} while (1);
+	so_set_bucket(set, bucket, sentinel);
+	return sentinel;
+}
+
+/* Sub-list that starts at the sentinel of the bucket of val */
+static inline void so_bucket_list(ht_intset_t *set, int val, intset_t *sub) {
+	unsigned int bucket = (unsigned int)val & (AO_load_full(&set->size) - 1);
+
+	if ((sub->head = so_get_bucket(set, bucket)) == NULL)
+		sub->head = so_initialise_bucket(set, bucket);
+}
+
+ht_intset_t *ht_new(unsigned int load) {
+	ht_intset_t *set;
+	node_t *tail;
+	unsigned int size = 1;
+
+	if ((set = (ht_intset_t *)calloc(1, sizeof(ht_intset_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	while (size < maxhtlength && size < SO_MAX_BUCKETS)
+		size <<= 1;
+	set->size = size;
+	set->initial_size = size;
+	set->load = load;
+	tail = new_node(SO_TAIL, NULL, 0);
+	set->head = new_node(so_sentinel_key(0), tail, 0);
+	so_set_bucket(set, 0, set->head);
+	set->nb_sentinels = 1;
+	return set;
+}
+
+void ht_delete(ht_intset_t *set) {
+	node_t *node, *next;
+	int i;
+
+	node = set->head;
+	while (node != NULL) {
+		next = (node_t *)get_unmarked_ref((long)node->next);
+		free(node);
+		node = next;
+	}
+	for (i = 0; i < SO_MAX_SEGMENTS; i++)
+		free(set->segments[i]);
+	free(set);
+}
+
+int ht_size(ht_intset_t *set) {
+	int size = 0;
+	node_t *node;
+
+	node = set->head->next;
+	while (node->next) {
+		if ((node->val & 1) && !is_marked_ref((long)node->next))
+			size++;
+		node = (node_t *)get_unmarked_ref((long)node->next);
+	}
+	return size;
+}
+
+int floor_log_2(unsigned int n) {
+	int pos = 0;
+	if (n >= 1<<16) { n >>= 16; pos += 16; }
+	if (n >= 1<< 8) { n >>=  8; pos +=  8; }
+	if (n >= 1<< 4) { n >>=  4; pos +=  4; }
+	if (n >= 1<< 2) { n >>=  2; pos +=  2; }
+	if (n >= 1<< 1) {           pos +=  1; }
+	return ((n == 0) ? (-1) : pos);
+}
+
+int ht_contains(ht_intset_t *set, int val, int transactional) {
+	intset_t sub;
+
+	so_bucket_list(set, val, &sub);
+	return harris_find(&sub, so_regular_key(val));
+}
+
+int ht_add(ht_intset_t *set, int val, int transactional) {
+	intset_t sub;
+	AO_t size, count;
+
+	so_bucket_list(set, val, &sub);
+	if (!harris_insert(&sub, so_regular_key(val)))
+		return 0;
+	count = AO_fetch_and_add1_full(&set->count) + 1;
+	size = AO_load_full(&set->size);
+	/* Lock-free doubling: only the bucket count changes */
+	if (count > size * set->load && size < SO_MAX_BUCKETS &&
+			ATOMIC_CAS_MB(&set->size, size, size << 1))
+		AO_fetch_and_add1_full(&set->nb_doublings);
+	return 1;
+}
+
+int ht_remove(ht_intset_t *set, int val, int transactional) {
+	intset_t sub;
+
+	so_bucket_list(set, val, &sub);
+	if (!harris_delete(&sub, so_regular_key(val)))
+		return 0;
+	AO_fetch_and_sub1_full(&set->count);
+	return 1;
+}
+
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional) {
+	printf("ht_move: No CAS-based implementation is available\n");
+	exit(1);
+}
+
+int ht_snapshot(ht_intset_t *set, int transactional) {
+	printf("ht_snapshot: No other implementation of atomic snapshot is available\n");
+	exit(1);
+}
+
+void ht_print_stats(ht_intset_t *set) {
+	printf("Buckets       : %lu (initial %u, %lu doublings)\n",
+				 (unsigned long)set->size, set->initial_size,
+				 (unsigned long)set->nb_doublings);
+	printf("  #sentinels  : %lu initialised\n", (unsigned long)set->nb_sentinels);
+	printf("  #keys/bucket: %.2f\n", (double)set->count / set->size);
+}
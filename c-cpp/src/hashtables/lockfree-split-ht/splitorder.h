@@ -0,0 +1,85 @@
+/*
+ * File:
+ *   splitorder.h
+ * Description:
+ *   Resizable lock-free hash table using split-ordered lists
+ *   "Split-Ordered Lists: Lock-Free Extensible Hash Tables"
+ *   O. Shalev, N. Shavit, J. ACM 53(3), p. 379-405, 2006.
+ *
+ * splitorder.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "../../linkedlists/lockfree-list/intset.h"
+
+#define DEFAULT_MOVE                    0
+#define DEFAULT_SNAPSHOT                0
+#define DEFAULT_LOAD                    1
+#define DEFAULT_ELASTICITY              4
+#define DEFAULT_ALTERNATE               0
+#define DEFAULT_EFFECTIVE               1
+#define DEFAULT_GROW                    0
+
+#define MAXHTLENGTH                     65536
+
+/*
+ * Bucket pointers live in segments that are allocated on first use, so
+ * that doubling the table never copies or moves anything.
+ */
+#define SO_SEGMENT_BITS                 10
+#define SO_SEGMENT_SIZE                 (1 << SO_SEGMENT_BITS)
+#define SO_MAX_SEGMENTS                 16384
+#define SO_MAX_BUCKETS                  (SO_SEGMENT_SIZE * SO_MAX_SEGMENTS)
+
+/* Split-order keys use 32 bits, the tail sorts after all of them */
+#define SO_HIBIT                        0x80000000U
+#define SO_TAIL                         ((val_t)1 << 32)
+
+/* Hashtable length (# of buckets) */
+extern unsigned int maxhtlength;
+
+/* Hashtable seed */
+#ifdef TLS
+extern __thread unsigned int *rng_seed;
+#else /* ! TLS */
+extern pthread_key_t rng_seed_key;
+#endif /* ! TLS */
+
+/*
+ * All keys sit in a single Harris list sorted by bit-reversed key. A
+ * bucket points to a sentinel node in that list, inserted the first time
+ * the bucket is used, and the table doubles by merely doubling size: the
+ * new buckets split their parent's run of the list when they are first
+ * touched.
+ */
+typedef struct ht_intset {
+  node_t **segments[SO_MAX_SEGMENTS];
+  node_t *head;
+  volatile AO_t size;           /* number of buckets, a power of two */
+  volatile AO_t count;          /* number of keys */
+  unsigned int load;            /* keys per bucket before doubling */
+  unsigned int initial_size;
+  volatile AO_t nb_doublings;
+  volatile AO_t nb_sentinels;
+} ht_intset_t;
+
+void ht_delete(ht_intset_t *set);
+int ht_size(ht_intset_t *set);
+int floor_log_2(unsigned int n);
+ht_intset_t *ht_new(unsigned int load);
+void ht_print_stats(ht_intset_t *set);
+
+int ht_contains(ht_intset_t *set, int val, int transactional);
+int ht_add(ht_intset_t *set, int val, int transactional);
+int ht_remove(ht_intset_t *set, int val, int transactional);
+int ht_move(ht_intset_t *set, int val1, int val2, int transactional);
+int ht_snapshot(ht_intset_t *set, int transactional);
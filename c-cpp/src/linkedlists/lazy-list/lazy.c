@@ -26,27 +26,34 @@
 
 #include "lazy.h"
 
-inline int is_marked_ref(long i) {
-	return (int) (i &= LONG_MIN+1);
-}
-
-inline long unset_mark(long i) {
-	i &= LONG_MAX-1;
-	return i;
-}
+#ifdef FINGER
+__thread parse_finger_t parse_finger;
+#endif
 
-inline long set_mark(long i) {
-	i = unset_mark(i);
-	i += 1;
-	return i;
-}
+/*
+ * With FINGER, an access starts from the predecessor the previous access
+ * of the thread found if it is unmarked and lower than val, instead of
+ * from the head. Removed nodes are never freed, so the finger can always
+ * be read.
+ */
+static inline node_l_t *parse_start(intset_l_t *set, val_t val) {
+#ifdef FINGER
+	node_l_t *n = parse_finger.node;
 
-inline node_l_t *get_unmarked_ref(node_l_t *n) {
-	return (node_l_t *) unset_mark((long) n);
+	if (parse_finger.set == set && n->val < val && !is_marked_ref((long) n->next)) {
+		parse_finger.hits++;
+		return n;
+	}
+	parse_finger.misses++;
+#endif
+	return set->head;
 }
 
-inline node_l_t *get_marked_ref(node_l_t *n) {
-	return (node_l_t *) set_mark((long) n);
+static inline void parse_remember(intset_l_t *set, node_l_t *pred) {
+#ifdef FINGER
+	parse_finger.set = set;
+	parse_finger.node = pred;
+#endif
 }
 
 /*
@@ -58,10 +65,14 @@ inline int parse_validate(node_l_t *pred, node_l_t *curr) {
 }
 
 int parse_find(intset_l_t *set, val_t val) {
-	node_l_t *curr;
-	curr = set->head;
-	while (curr->val < val)
+	node_l_t *pred, *curr;
+	pred = curr = parse_start(set, val);
+	while (curr->val < val) {
+		pred = curr;
+		FS_READ(&curr->next, curr, sizeof(node_l_t));
 		curr = get_unmarked_ref(curr->next);
+	}
+	parse_remember(set, pred);
 	return ((curr->val == val) && !is_marked_ref((long) curr));
 }
 
@@ -69,17 +80,22 @@ int parse_insert(intset_l_t *set, val_t val) {
 	node_l_t *curr, *pred, *newnode;
 	int result;
 	
-	pred = set->head;
+	pred = parse_start(set, val);
 	curr = get_unmarked_ref(pred->next);
 	while (curr->val < val) {
 		pred = curr;
+		FS_READ(&curr->next, curr, sizeof(node_l_t));
 		curr = get_unmarked_ref(curr->next);
 	}
+	parse_remember(set, pred);
+	FS_WRITE(&pred->lock);
 	LOCK(&pred->lock);
+	FS_WRITE(&curr->lock);
 	LOCK(&curr->lock);
 	result = (parse_validate(pred, curr) && (curr->val != val));
 	if (result) {
 		newnode = new_node_l(val, curr, 0);
+		FS_WRITE(&pred->next);
 		pred->next = newnode;
 	} 
 	UNLOCK(&curr->lock);
@@ -100,17 +116,23 @@ int parse_delete(intset_l_t *set, val_t val) {
 	node_l_t *pred, *curr;
 	int result;
 	
-	pred = set->head;
+	pred = parse_start(set, val);
 	curr = get_unmarked_ref(pred->next);
 	while (curr->val < val) {
 		pred = curr;
+		FS_READ(&curr->next, curr, sizeof(node_l_t));
 		curr = get_unmarked_ref(curr->next);
 	}
+	parse_remember(set, pred);
+	FS_WRITE(&pred->lock);
 	LOCK(&pred->lock);
+	FS_WRITE(&curr->lock);
 	LOCK(&curr->lock);
 	result = (parse_validate(pred, curr) && (val == curr->val));
 	if (result) {
+		FS_WRITE(&curr->next);
 		curr->next = get_marked_ref(curr->next);
+		FS_WRITE(&pred->next);
 		pred->next = get_unmarked_ref(curr->next);
 	}
 	UNLOCK(&curr->lock);
@@ -27,11 +27,40 @@
 #include "coupling.h"
 
 /* handling logical deletion flag */ 
-inline int is_marked_ref(long i);
-inline long unset_mark(long i);
-inline long set_mark(long i);
-inline node_l_t *get_unmarked_ref(node_l_t *n);
-inline node_l_t *get_marked_ref(node_l_t *n);
+static inline int is_marked_ref(long i) {
+	return (int) (i &= LONG_MIN+1);
+}
+
+static inline long unset_mark(long i) {
+	i &= LONG_MAX-1;
+	return i;
+}
+
+static inline long set_mark(long i) {
+	i = unset_mark(i);
+	i += 1;
+	return i;
+}
+
+static inline node_l_t *get_unmarked_ref(node_l_t *n) {
+	return (node_l_t *) unset_mark((long) n);
+}
+
+static inline node_l_t *get_marked_ref(node_l_t *n) {
+	return (node_l_t *) set_mark((long) n);
+}
+
+#ifdef FINGER
+/* Where the last lazy list access of the thread stopped, see lazy.c */
+typedef struct parse_finger {
+	intset_l_t *set;
+	node_l_t *node;
+	unsigned long hits;
+	unsigned long misses;
+} parse_finger_t;
+
+extern __thread parse_finger_t parse_finger;
+#endif
 
 /* linked list accesses */
 int parse_validate(node_l_t *pred, node_l_t *curr);
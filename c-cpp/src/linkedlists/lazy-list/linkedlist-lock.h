@@ -34,6 +34,8 @@
 
 #include <atomic_ops.h>
 
+#include "placement.h"
+
 #define DEFAULT_DURATION                10000
 #define DEFAULT_INITIAL                 256
 #define DEFAULT_NB_THREADS              1
@@ -59,18 +61,29 @@ typedef intptr_t val_t;
 #define VAL_MIN                         INT_MIN
 #define VAL_MAX                         INT_MAX
 
-#ifdef MUTEX
-typedef pthread_mutex_t ptlock_t;
-#  define INIT_LOCK(lock)				pthread_mutex_init((pthread_mutex_t *) lock, NULL);
-#  define DESTROY_LOCK(lock)			pthread_mutex_destroy((pthread_mutex_t *) lock)
-#  define LOCK(lock)					pthread_mutex_lock((pthread_mutex_t *) lock)
-#  define UNLOCK(lock)					pthread_mutex_unlock((pthread_mutex_t *) lock)
+/*
+ * Nodes embed a lock of the LOCK=<name> algorithm (see locks.h), or,
+ * with NODELOCK=TAS, a one-byte test-and-test-and-set lock that fits in
+ * the padding after the next pointer: a node then takes 24 bytes instead
+ * of 56 with a mutex.
+ */
+#if defined(NODELOCK_TAS)
+typedef unsigned char ptlock_t;
+#  define NODELOCK_NAME                 "tas"
+#  define INIT_LOCK(lock)				(*(volatile ptlock_t *) (lock) = 0)
+#  define DESTROY_LOCK(lock)			((void) (lock))
+#  define LOCK(lock)					tas_lock((volatile ptlock_t *) lock)
+#  define UNLOCK(lock)					__sync_lock_release((volatile ptlock_t *) lock)
+#  define LOCKS_DEFINE
+
+static inline void tas_lock(volatile ptlock_t *lock) {
+  while (__sync_lock_test_and_set(lock, 1))
+    while (*lock)
+      ;
+}
 #else
-typedef pthread_spinlock_t ptlock_t;
-#  define INIT_LOCK(lock)				pthread_spin_init((pthread_spinlock_t *) lock, PTHREAD_PROCESS_PRIVATE);
-#  define DESTROY_LOCK(lock)			pthread_spin_destroy((pthread_spinlock_t *) lock)
-#  define LOCK(lock)					pthread_spin_lock((pthread_spinlock_t *) lock)
-#  define UNLOCK(lock)					pthread_spin_unlock((pthread_spinlock_t *) lock)
+#  include "locks.h"
+#  define NODELOCK_NAME                 LOCK_NAME
 #endif
 
 typedef struct node_l {
@@ -88,5 +101,6 @@ intset_l_t *set_new_l();
 void set_delete_l(intset_l_t *set);
 int set_size_l(intset_l_t *set);
 void node_delete_l(node_l_t *node);
+size_t node_footprint_l(node_l_t *node);
 
 
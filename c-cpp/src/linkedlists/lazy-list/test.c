@@ -106,6 +106,8 @@ typedef struct thread_data {
   unsigned long nb_aborts_validate_commit;
   unsigned long nb_aborts_invalid_memory;
   unsigned long max_retries;
+  unsigned long finger_hits;
+  unsigned long finger_misses;
   unsigned int seed;
   intset_l_t *set;
   barrier_t *barrier;
@@ -193,6 +195,11 @@ void *test(void *data) {
     }
 			
   }	
+#ifdef FINGER
+  d->finger_hits = parse_finger.hits;
+  d->finger_misses = parse_finger.misses;
+#endif
+  FS_THREAD_EXIT();
   return NULL;
 }
 
@@ -217,7 +224,7 @@ int main(int argc, char **argv)
   val_t val = 0;
   unsigned long reads, effreads, updates, effupds, aborts, aborts_locked_read, aborts_locked_write,
     aborts_validate_read, aborts_validate_write, aborts_validate_commit,
-    aborts_invalid_memory, max_retries;
+    aborts_invalid_memory, max_retries, finger_hits, finger_misses;
   thread_data_t *data;
   pthread_t *threads;
   pthread_attr_t attr;
@@ -380,6 +387,10 @@ int main(int argc, char **argv)
   }
   size = set_size_l(set);
   printf("Set size     : %d\n", size);
+  printf("Node size    : %d bytes (%s lock)", (int)sizeof(node_l_t), NODELOCK_NAME);
+  if (node_footprint_l(set->head) > 0)
+    printf(", %d allocated by glibc malloc", (int)node_footprint_l(set->head));
+  printf("\n");
 	
   /* Access set from all threads */
   barrier_init(&barrier, nb_threads + 1);
@@ -400,6 +411,8 @@ int main(int argc, char **argv)
     data[i].nb_removed = 0;
     data[i].nb_contains = 0;
     data[i].nb_found = 0;
+    data[i].finger_hits = 0;
+    data[i].finger_misses = 0;
     data[i].nb_aborts = 0;
     data[i].nb_aborts_locked_read = 0;
     data[i].nb_aborts_locked_write = 0;
@@ -454,6 +467,8 @@ int main(int argc, char **argv)
   updates = 0;
   effupds = 0;
   max_retries = 0;
+  finger_hits = 0;
+  finger_misses = 0;
   for (i = 0; i < nb_threads; i++) {
     printf("Thread %d\n", i);
     printf("  #add        : %lu\n", data[i].nb_add);
@@ -488,6 +503,8 @@ int main(int argc, char **argv)
     size += data[i].nb_added - data[i].nb_removed;
     if (max_retries < data[i].max_retries)
       max_retries = data[i].max_retries;
+    finger_hits += data[i].finger_hits;
+    finger_misses += data[i].finger_misses;
   }
   printf("Set size      : %d (expected: %d)\n", set_size_l(set), size);
   printf("Duration      : %d (ms)\n", duration);
@@ -516,6 +533,14 @@ int main(int argc, char **argv)
   printf("  #val-c      : %lu (%f / s)\n", aborts_validate_commit, aborts_validate_commit * 1000.0 / duration);
   printf("  #inv-mem    : %lu (%f / s)\n", aborts_invalid_memory, aborts_invalid_memory * 1000.0 / duration);
   printf("Max retries   : %lu\n", max_retries);
+#ifdef FINGER
+  printf("#finger hits  : %lu (%.1f%%)\n", finger_hits,
+	 finger_hits + finger_misses ?
+	 100.0 * finger_hits / (finger_hits + finger_misses) : 0.0);
+#endif
+#ifdef FS_STATS
+  fs_print_stats(sizeof(node_l_t));
+#endif
 	
   /* Delete set */
   set_delete_l(set);
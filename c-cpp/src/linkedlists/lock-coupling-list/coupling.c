@@ -23,12 +23,27 @@
 
 #include "coupling.h"
 
+__thread unsigned long lockc_retries, lockc_fallbacks;
+
+/*
+ * An update that changes curr->next makes the version of curr odd
+ * meanwhile; a removed node keeps an odd version for good.
+ */
+static inline void version_begin(node_l_t *n) {
+	n->version++;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void version_end(node_l_t *n) {
+	__atomic_store_n(&n->version, n->version + 1, __ATOMIC_RELEASE);
+}
+
 /* 
  * Similar algorithm for the delete, find, and insert:
  * Lock the first two elements (locking each before getting the copy of the element)
  * then unlock previous, keep ownership of the current, and lock next in a loop.
  */
-int lockc_delete(intset_l_t *set, val_t val) {
+static int lockc_remove(intset_l_t *set, val_t val, int reclaim) {
 	node_l_t *curr, *next;
 	int found;
 	
@@ -45,9 +60,13 @@ int lockc_delete(intset_l_t *set, val_t val) {
 	}
 	found = (val == next->val);
 	if (found) {
+	  version_begin(curr);
+	  version_begin(next);
 	  curr->next = next->next;
+	  version_end(curr);
 	  UNLOCK(&next->lock);
-	  node_delete_l(next);
+	  if (reclaim)
+	    node_delete_l(next);
 	  UNLOCK(&curr->lock);
 	} else {
 	  UNLOCK(&curr->lock);
@@ -56,6 +75,18 @@ int lockc_delete(intset_l_t *set, val_t val) {
 	return found;
 }
 
+int lockc_delete(intset_l_t *set, val_t val) {
+	return lockc_remove(set, val, 1);
+}
+
+/*
+ * Lock-free readers may still be on the removed node, so it is not
+ * freed, as in the lazy list.
+ */
+int lockc_delete_opt(intset_l_t *set, val_t val) {
+	return lockc_remove(set, val, 0);
+}
+
 int lockc_find(intset_l_t *set, val_t val) {
 	node_l_t *curr, *next; 
 	int found;
@@ -77,6 +108,42 @@ int lockc_find(intset_l_t *set, val_t val) {
 	return found;
 }
 
+/*
+ * Optimistic contains: the traversal takes no lock and couples versions
+ * instead. It reads next from curr and only moves on when the version
+ * of curr did not change meanwhile, so that curr->next was next at a
+ * time curr was in the list; next, whose version was read before that
+ * check, was then in the list too. After LOCKC_OPT_TRIES failed
+ * validations, the search falls back to lock coupling.
+ */
+int lockc_find_opt(intset_l_t *set, val_t val) {
+	node_l_t *curr, *next;
+	unsigned int v, nv;
+	int tries;
+
+	for (tries = 0; tries < LOCKC_OPT_TRIES; tries++) {
+		curr = set->head;
+		v = __atomic_load_n(&curr->version, __ATOMIC_ACQUIRE);
+		if (v & 1)
+			goto retry;
+		next = __atomic_load_n(&curr->next, __ATOMIC_ACQUIRE);
+		while (next->val < val) {
+			nv = __atomic_load_n(&next->version, __ATOMIC_ACQUIRE);
+			if ((nv & 1) || curr->version != v)
+				goto retry;
+			curr = next;
+			v = nv;
+			next = __atomic_load_n(&curr->next, __ATOMIC_ACQUIRE);
+		}
+		if (curr->version == v)
+			return (val == next->val);
+	retry:
+		lockc_retries++;
+	}
+	lockc_fallbacks++;
+	return lockc_find(set, val);
+}
+
 int lockc_insert(intset_l_t *set, val_t val) {
 	node_l_t *curr, *next, *newnode;
 	int found;
@@ -97,7 +164,9 @@ int lockc_insert(intset_l_t *set, val_t val) {
 	found = (val == next->val);
 	if (!found) {
 		newnode =  new_node_l(val, next, 0);
+		version_begin(curr);
 		curr->next = newnode;
+		version_end(curr);
 	}
 	UNLOCK(&curr->lock);
 	UNLOCK(&next->lock);
@@ -23,6 +23,14 @@
 
 #include "linkedlist-lock.h"
 
+/* Failed validations before an optimistic contains takes locks */
+#define LOCKC_OPT_TRIES                 8
+
+/* Optimistic contains restarts and lock-coupling fallbacks */
+extern __thread unsigned long lockc_retries, lockc_fallbacks;
+
 int lockc_delete(intset_l_t *set, val_t val);
+int lockc_delete_opt(intset_l_t *set, val_t val);
 int lockc_find(intset_l_t *set, val_t val);
+int lockc_find_opt(intset_l_t *set, val_t val);
 int lockc_insert(intset_l_t *set, val_t val);
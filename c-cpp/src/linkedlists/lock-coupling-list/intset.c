@@ -26,6 +26,7 @@
 int set_contains_l(intset_l_t *set, val_t val, int transactional)
 {
 	if (transactional == 2) return parse_find(set, val);
+	else if (transactional == 3) return lockc_find_opt(set, val);
 	else return lockc_find(set, val);
 }
 
@@ -38,5 +39,6 @@ int set_add_l(intset_l_t *set, val_t val, int transactional)
 int set_remove_l(intset_l_t *set, val_t val, int transactional)
 {
 	if (transactional == 2) return parse_delete(set, val);
+	else if (transactional == 3) return lockc_delete_opt(set, val);
 	else return lockc_delete(set, val);
 }
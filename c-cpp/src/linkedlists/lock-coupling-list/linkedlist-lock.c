@@ -21,8 +21,12 @@
  * GNU General Public License for more details.
  */
 
+#include <malloc.h>
+
 #include "intset.h"
 
+LOCKS_DEFINE
+
 node_l_t *new_node_l(val_t val, node_l_t *next, int transactional)
 {
   node_l_t *node_l;
@@ -34,6 +38,7 @@ node_l_t *new_node_l(val_t val, node_l_t *next, int transactional)
   }
   node_l->val = val;
   node_l->next = next;
+  node_l->version = 0;
   INIT_LOCK(&node_l->lock);	
   return node_l;
 }
@@ -54,6 +59,19 @@ intset_l_t *set_new_l()
   return set;
 }
 
+/* 
+ * Bytes glibc malloc uses for the node, including its chunk header, or 0
+ * with another allocator (e.g. tcmalloc with MALLOC=TC), whose size
+ * classes and metadata this does not know.
+ */
+size_t node_footprint_l(node_l_t *node) {
+#if defined(__GLIBC__) && !defined(MALLOC_TC)
+  return malloc_usable_size(node) + sizeof(size_t);
+#else
+  return 0;
+#endif
+}
+
 void node_delete_l(node_l_t *node) {
    DESTROY_LOCK(&node->lock);
    free(node);
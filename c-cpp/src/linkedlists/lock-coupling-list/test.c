@@ -193,6 +193,10 @@ void *test(void *data) {
     }
 			
   }	
+
+  /* Optimistic contains: validation failures and lock-coupling fallbacks */
+  d->nb_aborts = d->nb_aborts_validate_read = lockc_retries;
+  d->nb_aborts_locked_read = lockc_fallbacks;
   return NULL;
 }
 
@@ -276,6 +280,10 @@ int main(int argc, char **argv)
 	     "        RNG seed (0=time-based, default=" XSTR(DEFAULT_SEED) ")\n"
 	     "  -u, --update-rate <int>\n"
 	     "        Percentage of update transactions (default=" XSTR(DEFAULT_UPDATE) ")\n"
+	     "  -x, --lock-based algorithm (default=" XSTR(DEFAULT_LOCKTYPE) ")\n"
+	     "        Use lock-based algorithm\n"
+	     "        1 = lock-coupling,\n"
+	     "        3 = lock-coupling with optimistic contains\n"
 	     );
       exit(0);
     case 'A':
@@ -303,8 +311,12 @@ int main(int argc, char **argv)
       update = atoi(optarg);
       break;
     case 'x':
-      printf("The parameter x is not valid for this benchmark.\n");
-      exit(0);
+      unit_tx = atoi(optarg);
+      if (unit_tx != 1 && unit_tx != 3) {
+        printf("The lock-based algorithm must be 1 or 3.\n");
+        exit(0);
+      }
+      break;
     case 'a':
       printf("The parameter a is not valid for this benchmark.\n");
       exit(0);
@@ -324,6 +336,7 @@ int main(int argc, char **argv)
   assert(nb_threads > 0);
   assert(range > 0 && range >= initial);
   assert(update >= 0 && update <= 100);
+  assert(unit_tx == 1 || unit_tx == 3);
 	
   printf("Set type     : linked list\n");
   printf("Length       : %d\n", duration);
@@ -377,6 +390,10 @@ int main(int argc, char **argv)
   }
   size = set_size_l(set);
   printf("Set size     : %d\n", size);
+  printf("Node size    : %d bytes (%s lock)", (int)sizeof(node_l_t), NODELOCK_NAME);
+  if (node_footprint_l(set->head) > 0)
+    printf(", %d allocated by glibc malloc", (int)node_footprint_l(set->head));
+  printf("\n");
 	
   /* Access set from all threads */
   barrier_init(&barrier, nb_threads + 1);
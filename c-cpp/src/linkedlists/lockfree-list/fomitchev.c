@@ -0,0 +1,233 @@
+/*
+ * File:
+ *   fomitchev.c
+ * Description:
+ *   Lock-free linkedlist implementation of Fomitchev and Ruppert's algorithm
+ *   "Lock-Free Linked Lists and Skip Lists"
+ *   M. Fomitchev, E. Ruppert, p. 50-59, PODC 2004.
+ *
+ *   A deletion first flags the next pointer of the predecessor, then
+ *   sets the backlink of the node to that predecessor and marks the node,
+ *   and finally unlinks it. A flagged pointer cannot change until the
+ *   deletion completes, so the predecessor is never marked while its
+ *   successor is deleted and the backlink always leads to a node that
+ *   was in the list. An update whose CAS fails follows the backlinks of
+ *   the marked nodes it holds and searches again from there, instead of
+ *   from the head as harris.c and michael.c do.
+ *
+ * fomitchev.c is part of Synchrobench
+ * 
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "fomitchev.h"
+
+static inline node_t *fr_next(node_t *n) {
+	return *(node_t *volatile *)&n->next;
+}
+
+static inline node_t *fr_ref(node_t *w) {
+	return (node_t *) ((uintptr_t) w & ~(FR_MARK | FR_FLAG));
+}
+
+static inline int fr_is_marked(node_t *w) {
+	return ((uintptr_t) w & FR_MARK) != 0;
+}
+
+static inline int fr_is_flagged(node_t *w) {
+	return ((uintptr_t) w & FR_FLAG) != 0;
+}
+
+static inline node_t *fr_with(node_t *n, uintptr_t bits) {
+	return (node_t *) ((uintptr_t) n | bits);
+}
+
+static void fr_help_flagged(node_t *prev, node_t *del);
+
+/*
+ * Unlinks the marked node del from prev, whose next pointer is flagged.
+ */
+static void fr_help_marked(node_t *prev, node_t *del) {
+	node_t *next = fr_ref(fr_next(del));
+
+	FS_WRITE(&prev->next);
+	if (ATOMIC_CAS_MB(&prev->next, fr_with(del, FR_FLAG), next)) {
+		LIST_STAT(unlinks, 1);
+		LIST_STAT(unlinked, 1);
+	}
+}
+
+/*
+ * Marks del, helping the deletion of its successor first if del->next
+ * is flagged.
+ */
+static void fr_try_mark(node_t *del) {
+	node_t *next;
+
+	do {
+		next = fr_ref(fr_next(del));
+		FS_WRITE(&del->next);
+		if (!ATOMIC_CAS_MB(&del->next, next, fr_with(next, FR_MARK))) {
+			next = fr_next(del);
+			if (fr_is_flagged(next))
+				fr_help_flagged(del, fr_ref(next));
+		}
+	} while (!fr_is_marked(fr_next(del)));
+}
+
+/*
+ * Completes the deletion of del, the successor of prev once prev->next
+ * is flagged.
+ */
+static void fr_help_flagged(node_t *prev, node_t *del) {
+	del->backlink = prev;
+	if (!fr_is_marked(fr_next(del)))
+		fr_try_mark(del);
+	fr_help_marked(prev, del);
+}
+
+/*
+ * Follows the backlinks from prev to an unmarked node.
+ */
+static node_t *fr_recover(node_t *prev) {
+	while (fr_is_marked(fr_next(prev))) {
+		prev = prev->backlink;
+		LIST_STAT(traversed, 1);
+	}
+	return prev;
+}
+
+/*
+ * Flags the pointer from prev to target. Returns the node whose pointer
+ * got flagged, by this call or by another deletion of target, and sets
+ * *flagged if this call flagged it; returns NULL if target is no longer
+ * in the list.
+ */
+static node_t *fr_try_flag(node_t *prev, node_t *target, int *flagged) {
+	node_t *del;
+
+	*flagged = 0;
+	while (1) {
+		if (fr_next(prev) == fr_with(target, FR_FLAG))
+			return prev;
+		FS_WRITE(&prev->next);
+		if (ATOMIC_CAS_MB(&prev->next, target, fr_with(target, FR_FLAG))) {
+			*flagged = 1;
+			return prev;
+		}
+		if (fr_next(prev) == fr_with(target, FR_FLAG))
+			return prev;
+		LIST_STAT(cas_fails, 1);
+		prev = fr_recover(prev);
+		fomitchev_search_from(target->val - 1, prev, &prev, &del);
+		if (del != target)
+			return NULL;
+	}
+}
+
+/*
+ * fomitchev_search_from looks for value val from node curr, whose value
+ * must be at most val, it
+ *  - sets right_node to the first node owning a value higher than val and 
+ *  - sets left_node to its predecessor, the node owning val if present. 
+ * Marked successors of a node are unlinked on the way.
+ */
+void fomitchev_search_from(val_t val, node_t *curr, node_t **left_node,
+			   node_t **right_node) {
+	node_t *next, *w;
+	unsigned long steps = 0;
+
+	next = fr_ref(fr_next(curr));
+	while (next->val <= val) {
+		FS_READ(&next->next, next, sizeof(node_t));
+		while (fr_is_marked(fr_next(next)) &&
+			   (!fr_is_marked(w = fr_next(curr)) || fr_ref(w) != next)) {
+			if (fr_ref(fr_next(curr)) == next)
+				fr_help_marked(curr, next);
+			next = fr_ref(fr_next(curr));
+		}
+		if (next->val <= val) {
+			curr = next;
+			next = fr_ref(fr_next(curr));
+			steps++;
+		}
+	}
+	LIST_STAT(traversed, steps);
+	*left_node = curr;
+	*right_node = next;
+}
+
+/*
+ * fomitchev_find returns whether there is a node in the list owning value val.
+ */
+int fomitchev_find(intset_t *set, val_t val) {
+	node_t *left_node, *right_node;
+
+	fomitchev_search_from(val, set->head, &left_node, &right_node);
+	return (left_node->val == val);
+}
+
+/*
+ * fomitchev_insert inserts a new node with the given value val in the list
+ * (if the value was absent) or does nothing (if the value is already present).
+ */
+int fomitchev_insert(intset_t *set, val_t val) {
+	node_t *prev, *next, *w, *newnode = NULL;
+
+	fomitchev_search_from(val, set->head, &prev, &next);
+	if (prev->val == val)
+		return 0;
+	while (1) {
+		w = fr_next(prev);
+		if (fr_is_flagged(w)) {
+			fr_help_flagged(prev, fr_ref(w));
+		} else {
+			if (newnode == NULL)
+				newnode = new_node(val, next, 0);
+			else
+				newnode->next = next;
+			/* mem-bar between node creation and insertion */
+			AO_nop_full();
+			FS_WRITE(&prev->next);
+			if (ATOMIC_CAS_MB(&prev->next, next, newnode))
+				return 1;
+			LIST_STAT(cas_fails, 1);
+			w = fr_next(prev);
+			if (fr_is_flagged(w))
+				fr_help_flagged(prev, fr_ref(w));
+			prev = fr_recover(prev);
+		}
+		fomitchev_search_from(val, prev, &prev, &next);
+		if (prev->val == val) {
+			if (newnode != NULL)
+				free(newnode);
+			return 0;
+		}
+	}
+}
+
+/*
+ * fomitchev_delete deletes a node with the given value val (if the value
+ * is present) or does nothing (if the value is absent). Only the deletion
+ * that flags the predecessor succeeds, the others help it complete.
+ */
+int fomitchev_delete(intset_t *set, val_t val) {
+	node_t *prev, *del;
+	int flagged;
+
+	fomitchev_search_from(val - 1, set->head, &prev, &del);
+	if (del->val != val)
+		return 0;
+	prev = fr_try_flag(prev, del, &flagged);
+	if (prev != NULL)
+		fr_help_flagged(prev, del);
+	return flagged;
+}
@@ -0,0 +1,36 @@
+/*
+ * File:
+ *   fomitchev.h
+ * Description:
+ *   Lock-free linkedlist implementation of Fomitchev and Ruppert's algorithm
+ *   "Lock-Free Linked Lists and Skip Lists"
+ *   M. Fomitchev, E. Ruppert, p. 50-59, PODC 2004.
+ *
+ * fomitchev.h is part of Synchrobench
+ * 
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "linkedlist.h"
+
+/* ################################################################### *
+ * FOMITCHEV AND RUPPERT'S LINKED LIST
+ * ################################################################### */
+
+/* Low-order bits of a next pointer */
+#define FR_MARK                         1UL   /* the node is deleted */
+#define FR_FLAG                         2UL   /* the successor is being deleted */
+
+void fomitchev_search_from(val_t val, node_t *curr, node_t **left_node,
+			   node_t **right_node);
+int fomitchev_find(intset_t *set, val_t val);
+int fomitchev_insert(intset_t *set, val_t val);
+int fomitchev_delete(intset_t *set, val_t val);
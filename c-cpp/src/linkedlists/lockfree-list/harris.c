@@ -25,35 +25,15 @@
 
 #include "harris.h"
 
-/*
- * The five following functions handle the low-order mark bit that indicates
- * whether a node is logically deleted (1) or not (0).
- *  - is_marked_ref returns whether it is marked, 
- *  - (un)set_marked changes the mark,
- *  - get_(un)marked_ref sets the mark before returning the node.
- */
-inline int is_marked_ref(long i) {
-    return (int) (i & (LONG_MIN+1));
-}
+FS_STATS_DEFINE
 
-inline long unset_mark(long i) {
-	i &= LONG_MAX-1;
-	return i;
-}
-
-inline long set_mark(long i) {
-	i = unset_mark(i);
-	i += 1;
-	return i;
-}
-
-inline long get_unmarked_ref(long w) {
-	return unset_mark(w);
-}
-
-inline long get_marked_ref(long w) {
-	return set_mark(w);
-}
+#ifdef FINGER
+/* Where the last search of the thread stopped, see harris_search */
+static __thread struct {
+	intset_t *set;
+	node_t *node;
+} harris_finger;
+#endif
 
 /*
  * harris_search looks for value val, it
@@ -62,23 +42,47 @@ inline long get_marked_ref(long w) {
  *  - sets the left_node to the node owning the value immediately lower than val. 
  * Encountered nodes that are marked as logically deleted are physically removed
  * from the list, yet not garbage collected.
+ *
+ * With FINGER, the search starts from the left_node of the previous search
+ * of the thread if it is unmarked and lower than val: an unmarked node is
+ * still in the list, and never freed once removed. A restart goes back to
+ * the head.
  */
 node_t *harris_search(intset_t *set, val_t val, node_t **left_node) {
-	node_t *left_node_next, *right_node;
+	node_t *left_node_next, *right_node, *t, *start = set->head;
+	unsigned long steps = 0, snipped = 0;
 	left_node_next = set->head;
 	
+#ifdef FINGER
+	if (harris_finger.set == set && harris_finger.node->val < val &&
+		!is_marked_ref((long) harris_finger.node->next)) {
+		start = harris_finger.node;
+		list_stats.finger_hits++;
+	} else
+		list_stats.finger_misses++;
+#endif
+
 search_again:
 	do {
-		node_t *t = set->head;
-		node_t *t_next = set->head->next;
+		node_t *t_next;
+		t = start;
+		t_next = t->next;
+		start = set->head;
+		/* only a finger can be marked */
+		if (is_marked_ref((long) t_next))
+			goto search_again;
 		
 		/* Find left_node and right_node */
 		do {
 			if (!is_marked_ref((long) t_next)) {
 				(*left_node) = t;
 				left_node_next = t_next;
-			}
+				snipped = 0;
+			} else
+				snipped++;
 			t = (node_t *) get_unmarked_ref((long) t_next);
+			steps++;
+			FS_READ(&t->next, t, sizeof(node_t));
 			if (!t->next) break;
 			t_next = t->next;
 		} while (is_marked_ref((long) t_next) || (t->val < val));
@@ -86,20 +90,37 @@ search_again:
 		
 		/* Check that nodes are adjacent */
 		if (left_node_next == right_node) {
-			if (right_node->next && is_marked_ref((long) right_node->next))
+			if (right_node->next && is_marked_ref((long) right_node->next)) {
+				LIST_STAT(restarts, 1);
 				goto search_again;
-			else return right_node;
+			}
+			LIST_STAT(traversed, steps);
+#ifdef FINGER
+			harris_finger.set = set;
+			harris_finger.node = *left_node;
+#endif
+			return right_node;
 		}
 		
 		/* Remove one or more marked nodes */
+		FS_WRITE(&(*left_node)->next);
 		if (ATOMIC_CAS_MB(&(*left_node)->next, 
 						  left_node_next, 
 						  right_node)) {
-			if (right_node->next && is_marked_ref((long) right_node->next))
+			LIST_STAT(unlinks, 1);
+			LIST_STAT(unlinked, snipped);
+			if (right_node->next && is_marked_ref((long) right_node->next)) {
+				LIST_STAT(restarts, 1);
 				goto search_again;
-			else return right_node;
+			}
+			LIST_STAT(traversed, steps);
+#ifdef FINGER
+			harris_finger.set = set;
+			harris_finger.node = *left_node;
+#endif
+			return right_node;
 		} 
-		
+		LIST_STAT(restarts, 1);
 	} while (1);
 }
 
@@ -132,8 +153,10 @@ int harris_insert(intset_t *set, val_t val) {
 		newnode = new_node(val, right_node, 0);
 		/* mem-bar between node creation and insertion */
 		AO_nop_full(); 
+		FS_WRITE(&left_node->next);
 		if (ATOMIC_CAS_MB(&left_node->next, right_node, newnode))
 			return 1;
+		LIST_STAT(cas_fails, 1);
 	} while(1);
 }
 
@@ -151,14 +174,22 @@ int harris_delete(intset_t *set, val_t val) {
 		if (right_node->val != val)
 			return 0;
 		right_node_next = right_node->next;
-		if (!is_marked_ref((long) right_node_next))
+		if (!is_marked_ref((long) right_node_next)) {
+			FS_WRITE(&right_node->next);
 			if (ATOMIC_CAS_MB(&right_node->next, 
 							  right_node_next, 
 							  get_marked_ref((long) right_node_next)))
 				break;
+		}
+		LIST_STAT(cas_fails, 1);
 	} while(1);
+	FS_WRITE(&left_node->next);
 	if (!ATOMIC_CAS_MB(&left_node->next, right_node, right_node_next))
 		right_node = harris_search(set, right_node->val, &left_node);
+	else {
+		LIST_STAT(unlinks, 1);
+		LIST_STAT(unlinked, 1);
+	}
 	return 1;
 }
 
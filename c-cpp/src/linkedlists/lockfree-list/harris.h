@@ -30,11 +30,35 @@
  * HARRIS' LINKED LIST
  * ################################################################### */
 
-inline int is_marked_ref(long i);
-inline long unset_mark(long i);
-inline long set_mark(long i);
-inline long get_unmarked_ref(long w);
-inline long get_marked_ref(long w);
+/*
+ * The five following functions handle the low-order mark bit that indicates
+ * whether a node is logically deleted (1) or not (0).
+ *  - is_marked_ref returns whether it is marked, 
+ *  - (un)set_marked changes the mark,
+ *  - get_(un)marked_ref sets the mark before returning the node.
+ */
+static inline int is_marked_ref(long i) {
+    return (int) (i & (LONG_MIN+1));
+}
+
+static inline long unset_mark(long i) {
+	i &= LONG_MAX-1;
+	return i;
+}
+
+static inline long set_mark(long i) {
+	i = unset_mark(i);
+	i += 1;
+	return i;
+}
+
+static inline long get_unmarked_ref(long w) {
+	return unset_mark(w);
+}
+
+static inline long get_marked_ref(long w) {
+	return set_mark(w);
+}
 
 node_t *harris_search(intset_t *set, val_t val, node_t **left_node);
 int harris_find(intset_t *set, val_t val);
@@ -70,7 +70,13 @@ int set_contains(intset_t *set, val_t val, int transactional)
 
 
 #elif defined LOCKFREE			
+#ifdef MICHAEL
+	result = michael_find(set, val);
+#elif defined FOMITCHEV
+	result = fomitchev_find(set, val);
+#else
 	result = harris_find(set, val);
+#endif
 #endif	
 	
 	return result;
@@ -158,7 +164,13 @@ int set_add(intset_t *set, val_t val, int transactional)
 		}
 
 #elif defined LOCKFREE
+#ifdef MICHAEL
+		result = michael_insert(set, val);
+#elif defined FOMITCHEV
+		result = fomitchev_insert(set, val);
+#else
 		result = harris_insert(set, val);
+#endif
 #endif
 		
 	}
@@ -240,7 +252,13 @@ int set_remove(intset_t *set, val_t val, int transactional)
 	}
 	
 #elif defined LOCKFREE
+#ifdef MICHAEL
+	result = michael_delete(set, val);
+#elif defined FOMITCHEV
+	result = fomitchev_delete(set, val);
+#else
 	result = harris_delete(set, val);
+#endif
 #endif
 	
 	return result;
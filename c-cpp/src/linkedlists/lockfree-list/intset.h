@@ -7,7 +7,13 @@
  *
  */
 
+#ifdef MICHAEL
+#include "michael.h"
+#elif defined FOMITCHEV
+#include "fomitchev.h"
+#else
 #include "harris.h"
+#endif
 
 int set_contains(intset_t *set, val_t val, int transactional);
 int set_add(intset_t *set, val_t val, int transactional);
@@ -10,6 +10,8 @@
 
 #include "linkedlist.h"
 
+__thread list_stats_t list_stats;
+
 node_t *new_node(val_t val, node_t *next, int transactional)
 {
   node_t *node;
@@ -17,7 +19,7 @@ node_t *new_node(val_t val, node_t *next, int transactional)
   if (transactional) {
 	node = (node_t *)MALLOC(sizeof(node_t));
   } else {
-	node = (node_t *)malloc(sizeof(node_t));
+	node = (node_t *)placement_alloc(sizeof(node_t));
   }
   if (node == NULL) {
 	perror("malloc");
@@ -26,6 +28,9 @@ node_t *new_node(val_t val, node_t *next, int transactional)
 
   node->val = val;
   node->next = next;
+#ifdef FOMITCHEV
+  node->backlink = NULL;
+#endif
 
   return node;
 }
@@ -14,6 +14,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <stdint.h>
@@ -21,6 +22,7 @@
 #include <atomic_ops.h>
 
 #include "tm.h"
+#include "placement.h"
 
 #ifdef DEBUG
 #define IO_FLUSH                        fflush(NULL)
@@ -53,12 +55,35 @@ typedef intptr_t val_t;
 typedef struct node {
 	val_t val;
 	struct node *next;
+#ifdef FOMITCHEV
+	struct node *backlink;          /* predecessor when the node got marked */
+#endif
 } node_t;
 
 typedef struct intset {
 	node_t *head;
 } intset_t;
 
+/* Per-thread counters of the lock-free searches and updates (LIST_STATS) */
+typedef struct list_stats {
+	unsigned long traversed;        /* nodes searches went through */
+	unsigned long restarts;         /* searches started again from the head */
+	unsigned long unlinks;          /* CAS that unlinked marked nodes */
+	unsigned long unlinked;         /* marked nodes these CAS unlinked */
+	unsigned long cas_fails;        /* insert and mark CAS that failed */
+	unsigned long finger_hits;      /* searches started from a finger */
+	unsigned long finger_misses;    /* searches started from the head */
+} list_stats_t;
+
+extern __thread list_stats_t list_stats;
+
+/* Only LIST_STATS builds count, so that the lists keep their plain hot paths */
+#ifdef LIST_STATS
+#  define LIST_STAT(c, n)               (list_stats.c += (n))
+#else
+#  define LIST_STAT(c, n)               ((void)(n))
+#endif
+
 node_t *new_node(val_t val, node_t *next, int transactional);
 intset_t *set_new();
 void set_delete(intset_t *set);
@@ -0,0 +1,141 @@
+/*
+ * File:
+ *   michael.c
+ * Description:
+ *   Lock-free linkedlist implementation of Michael's algorithm
+ *   "High Performance Dynamic Lock-Free Hash Tables and List-Based Sets"
+ *   M. M. Michael, p. 73-82, SPAA 2002.
+ *
+ *   Nodes are marked as in Harris' list, but a search unlinks each marked
+ *   node it meets with its own CAS instead of skipping a run of them and
+ *   unlinking the run at the end. A search thus never follows the next
+ *   pointer of a marked node, which is what lets hazard pointers protect
+ *   the two nodes it holds; nodes are still not freed here, as in
+ *   harris.c.
+ *
+ * michael.c is part of Synchrobench
+ * 
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "michael.h"
+
+/*
+ * michael_search looks for value val, it
+ *  - returns right_node owning val (if present) or its immediately higher 
+ *    value present in the list (otherwise) and 
+ *  - sets the left_node to the unmarked node that pointed to right_node. 
+ * The search starts again from the head whenever left_node gets marked
+ * or changes its successor, or when unlinking a marked node fails.
+ */
+node_t *michael_search(intset_t *set, val_t val, node_t **left_node) {
+	node_t *prev, *curr, *next;
+	unsigned long steps = 0;
+	
+search_again:
+	prev = set->head;
+	curr = prev->next;
+	while (1) {
+		FS_READ(&curr->next, curr, sizeof(node_t));
+		next = curr->next;
+		if (prev->next != curr) {
+			LIST_STAT(restarts, 1);
+			goto search_again;
+		}
+		if (!is_marked_ref((long) next)) {
+			if (curr->val >= val)
+				break;
+			prev = curr;
+		} else {
+			next = (node_t *) get_unmarked_ref((long) next);
+			FS_WRITE(&prev->next);
+			if (!ATOMIC_CAS_MB(&prev->next, curr, next)) {
+				LIST_STAT(restarts, 1);
+				goto search_again;
+			}
+			LIST_STAT(unlinks, 1);
+			LIST_STAT(unlinked, 1);
+		}
+		curr = next;
+		steps++;
+	}
+	LIST_STAT(traversed, steps);
+	*left_node = prev;
+	return curr;
+}
+
+/*
+ * michael_find returns whether there is a node in the list owning value val.
+ */
+int michael_find(intset_t *set, val_t val) {
+	node_t *right_node, *left_node;
+	
+	right_node = michael_search(set, val, &left_node);
+	return (right_node->val == val);
+}
+
+/*
+ * michael_insert inserts a new node with the given value val in the list
+ * (if the value was absent) or does nothing (if the value is already present).
+ */
+int michael_insert(intset_t *set, val_t val) {
+	node_t *newnode = NULL, *right_node, *left_node;
+	
+	do {
+		right_node = michael_search(set, val, &left_node);
+		if (right_node->val == val) {
+			if (newnode != NULL)
+				free(newnode);
+			return 0;
+		}
+		if (newnode == NULL)
+			newnode = new_node(val, right_node, 0);
+		else
+			newnode->next = right_node;
+		/* mem-bar between node creation and insertion */
+		AO_nop_full(); 
+		FS_WRITE(&left_node->next);
+		if (ATOMIC_CAS_MB(&left_node->next, right_node, newnode))
+			return 1;
+		LIST_STAT(cas_fails, 1);
+	} while(1);
+}
+
+/*
+ * michael_delete deletes a node with the given value val (if the value is
+ * present) or does nothing (if the value is absent). The node is marked,
+ * then unlinked by this CAS or, if it fails, by the search that follows.
+ */
+int michael_delete(intset_t *set, val_t val) {
+	node_t *right_node, *right_node_next, *left_node;
+	
+	do {
+		right_node = michael_search(set, val, &left_node);
+		if (right_node->val != val)
+			return 0;
+		right_node_next = right_node->next;
+		if (!is_marked_ref((long) right_node_next)) {
+			FS_WRITE(&right_node->next);
+			if (ATOMIC_CAS_MB(&right_node->next, 
+							  right_node_next, 
+							  get_marked_ref((long) right_node_next)))
+				break;
+		}
+		LIST_STAT(cas_fails, 1);
+	} while(1);
+	FS_WRITE(&left_node->next);
+	if (ATOMIC_CAS_MB(&left_node->next, right_node, right_node_next)) {
+		LIST_STAT(unlinks, 1);
+		LIST_STAT(unlinked, 1);
+	} else
+		michael_search(set, val, &left_node);
+	return 1;
+}
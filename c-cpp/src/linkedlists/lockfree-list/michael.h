@@ -0,0 +1,31 @@
+/*
+ * File:
+ *   michael.h
+ * Description:
+ *   Lock-free linkedlist implementation of Michael's algorithm
+ *   "High Performance Dynamic Lock-Free Hash Tables and List-Based Sets"
+ *   M. M. Michael, p. 73-82, SPAA 2002.
+ *
+ * michael.h is part of Synchrobench
+ * 
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "harris.h"
+
+/* ################################################################### *
+ * MICHAEL'S LINKED LIST
+ * ################################################################### */
+
+node_t *michael_search(intset_t *set, val_t val, node_t **left_node);
+int michael_find(intset_t *set, val_t val);
+int michael_insert(intset_t *set, val_t val);
+int michael_delete(intset_t *set, val_t val);
@@ -111,6 +111,7 @@ typedef struct thread_data {
 	unsigned long nb_aborts_invalid_memory;
 	unsigned long nb_aborts_double_write;
 	unsigned long max_retries;
+	list_stats_t stats;
 	unsigned int seed;
 	intset_t *set;
 	barrier_t *barrier;
@@ -209,8 +210,11 @@ void *test(void *data) {
 	}
 #endif /* ICC */
 	
+	d->stats = list_stats;
+
 	/* Free transaction */
 	TM_THREAD_EXIT();
+	FS_THREAD_EXIT();
 	
 	return NULL;
 }
@@ -241,6 +245,7 @@ int main(int argc, char **argv) {
 	aborts_locked_write, aborts_validate_read, aborts_validate_write, 
 	aborts_validate_commit, aborts_invalid_memory, aborts_double_write, 
 	max_retries, failures_because_contention;
+	list_stats_t stats;
 	thread_data_t *data;
 	pthread_t *threads;
 	pthread_attr_t attr;
@@ -350,7 +355,13 @@ int main(int argc, char **argv) {
 	assert(range > 0 && range >= initial);
 	assert(update >= 0 && update <= 100);
 	
+#ifdef MICHAEL
+	printf("Bench type   : linked list (Michael)\n");
+#elif defined FOMITCHEV
+	printf("Bench type   : linked list (Fomitchev-Ruppert)\n");
+#else
 	printf("Bench type   : linked list\n");
+#endif
 	printf("Duration     : %d\n", duration);
 	printf("Initial size : %d\n", initial);
 	printf("Nb threads   : %d\n", nb_threads);
@@ -481,6 +492,7 @@ int main(int argc, char **argv) {
 	aborts_invalid_memory = 0;
 	aborts_double_write = 0;
 	failures_because_contention = 0;
+	memset(&stats, 0, sizeof(stats));
 	reads = 0;
 	effreads = 0;
 	updates = 0;
@@ -504,6 +516,20 @@ int main(int argc, char **argv) {
 		printf("    #inv-mem  : %lu\n", data[i].nb_aborts_double_write);
 		printf("    #failures : %lu\n", data[i].failures_because_contention);
 		printf("  Max retries : %lu\n", data[i].max_retries);
+#ifdef LOCKFREE
+#ifdef LIST_STATS
+		printf("  #restarts   : %lu\n", data[i].stats.restarts);
+		printf("  #unlinks    : %lu\n", data[i].stats.unlinks);
+		printf("  #cas fails  : %lu\n", data[i].stats.cas_fails);
+#endif
+		stats.traversed += data[i].stats.traversed;
+		stats.restarts += data[i].stats.restarts;
+		stats.unlinks += data[i].stats.unlinks;
+		stats.unlinked += data[i].stats.unlinked;
+		stats.cas_fails += data[i].stats.cas_fails;
+		stats.finger_hits += data[i].stats.finger_hits;
+		stats.finger_misses += data[i].stats.finger_misses;
+#endif
 		aborts += data[i].nb_aborts;
 		aborts_locked_read += data[i].nb_aborts_locked_read;
 		aborts_locked_write += data[i].nb_aborts_locked_write;
@@ -562,6 +588,26 @@ int main(int argc, char **argv) {
 				 aborts_double_write * 1000.0 / duration);
 	printf("  #failures   : %lu\n",  failures_because_contention);
 	printf("Max retries   : %lu\n", max_retries);
+#ifdef LOCKFREE
+#ifdef LIST_STATS
+	printf("#traversed    : %lu (%f nodes / op)\n", stats.traversed,
+				 reads + updates ? (double)stats.traversed / (reads + updates) : 0.0);
+	printf("#restarts     : %lu (%f / update)\n", stats.restarts,
+				 updates ? (double)stats.restarts / updates : 0.0);
+	printf("#unlinks      : %lu (%f nodes / unlink)\n", stats.unlinks,
+				 stats.unlinks ? (double)stats.unlinked / stats.unlinks : 0.0);
+	printf("#cas fails    : %lu (%f / update)\n", stats.cas_fails,
+				 updates ? (double)stats.cas_fails / updates : 0.0);
+#endif
+#ifdef FINGER
+	printf("#finger hits  : %lu (%.1f%%)\n", stats.finger_hits,
+				 stats.finger_hits + stats.finger_misses ? 100.0 * stats.finger_hits /
+				 (stats.finger_hits + stats.finger_misses) : 0.0);
+#endif
+#endif
+#ifdef FS_STATS
+	fs_print_stats(sizeof(node_t));
+#endif
 	
 	/* Delete set */
 	set_delete(set);
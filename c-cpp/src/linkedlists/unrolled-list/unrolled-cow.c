@@ -0,0 +1,190 @@
+/*
+ * File:
+ *   unrolled-cow.c
+ * Description:
+ *   Lock-free unrolled linked list. Nodes are copied on write: an update
+ *   builds the node that replaces the one owning its key (two nodes when
+ *   that one is full) and links the replacement in with one CAS on the
+ *   next pointer of the old node, setting its mark bit. The marked
+ *   pointer leads to the replacement, or to the successor when an empty
+ *   node is removed, so a search that reaches a replaced node carries
+ *   on; it also swings the pointer to the replaced node past it.
+ *
+ *   NB. as in harris.c, replaced nodes are not freed: a search may still
+ *   be reading them.
+ *
+ * unrolled-cow.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "intset.h"
+
+static inline int ul_is_marked(ul_node_t *w)
+{
+  return ((uintptr_t)w & 1) != 0;
+}
+
+static inline ul_node_t *ul_ref(ul_node_t *w)
+{
+  return (ul_node_t *)((uintptr_t)w & ~(uintptr_t)1);
+}
+
+static inline ul_node_t *ul_marked(ul_node_t *n)
+{
+  return (ul_node_t *)((uintptr_t)n | 1);
+}
+
+/*
+ * Finds the node that owns val and the unmarked next pointer it had, and
+ * sets *link to the pointer that led to it, set->head or the next
+ * pointer of its predecessor.
+ */
+static ul_node_t *ul_search(intset_t *set, val_t val,
+			    ul_node_t *volatile **link, ul_node_t **next)
+{
+  ul_node_t *volatile *l;
+  ul_node_t *node, *w, *succ;
+
+ search_again:
+  l = &set->head;
+  node = *l;
+  while (1) {
+    FS_READ(&node->next, node, sizeof(ul_node_t));
+    w = node->next;
+    if (ul_is_marked(w)) {
+      succ = ul_ref(w);
+      FS_WRITE(l);
+      if (!ATOMIC_CAS_MB(l, node, succ))
+	goto search_again;
+      /* a removed node leaves its keys to its predecessor */
+      if (succ == NULL || succ->low > val)
+	goto search_again;
+      node = succ;
+      continue;
+    }
+    if (w == NULL || w->low > val)
+      break;
+    l = &node->next;
+    node = w;
+  }
+  *link = l;
+  *next = w;
+  return node;
+}
+
+/* A copy of node holding count keys from src, unlinked */
+static ul_node_t *ul_copy(val_t low, const int32_t *src, int count)
+{
+  ul_node_t *node = ul_new_node(low, NULL);
+
+  memcpy(node->keys, src, count * sizeof(int32_t));
+  node->count = count;
+  return node;
+}
+
+/*
+ * Makes repl replace node, whose next pointer was next. Whether or not
+ * the pointer to node is swung here, searches swing it later.
+ */
+static int ul_replace(ul_node_t *volatile *link, ul_node_t *node,
+		      ul_node_t *next, ul_node_t *repl)
+{
+  FS_WRITE(&node->next);
+  if (!ATOMIC_CAS_MB(&node->next, next, ul_marked(repl)))
+    return 0;
+  FS_WRITE(link);
+  ATOMIC_CAS_MB(link, node, repl);
+  return 1;
+}
+
+int ul_find(intset_t *set, val_t val)
+{
+  ul_node_t *volatile *link;
+  ul_node_t *node, *next;
+  int rank;
+
+  node = ul_search(set, val, &link, &next);
+  rank = ul_rank(node->keys, val);
+  return (rank < node->count && node->keys[rank] == val);
+}
+
+int ul_insert(intset_t *set, val_t val)
+{
+  ul_node_t *volatile *link;
+  ul_node_t *node, *next, *repl, *split, *dst;
+  int rank, half = UL_KEYS / 2;
+
+  while (1) {
+    node = ul_search(set, val, &link, &next);
+    rank = ul_rank(node->keys, val);
+    if (rank < node->count && node->keys[rank] == val)
+      return 0;
+    if (node->count < UL_KEYS) {
+      repl = ul_copy(node->low, node->keys, node->count);
+      split = NULL;
+      repl->next = next;
+      dst = repl;
+    } else {
+      repl = ul_copy(node->low, node->keys, half);
+      split = ul_copy(node->keys[half], &node->keys[half], UL_KEYS - half);
+      repl->next = split;
+      split->next = next;
+      if (val > split->low) {
+	dst = split;
+	rank = ul_rank(split->keys, val);
+      } else
+	dst = repl;
+    }
+    memmove(&dst->keys[rank + 1], &dst->keys[rank],
+	    (dst->count - rank) * sizeof(int32_t));
+    dst->keys[rank] = (int32_t)val;
+    dst->count++;
+    if (ul_replace(link, node, next, repl))
+      return 1;
+    free(repl);
+    if (split != NULL)
+      free(split);
+  }
+}
+
+/*
+ * Deletes val from the node that owns it. The last key of a node other
+ * than the first removes the node: its marked next pointer then leads to
+ * its successor.
+ */
+int ul_delete(intset_t *set, val_t val)
+{
+  ul_node_t *volatile *link;
+  ul_node_t *node, *next, *repl;
+  int rank;
+
+  while (1) {
+    node = ul_search(set, val, &link, &next);
+    rank = ul_rank(node->keys, val);
+    if (rank >= node->count || node->keys[rank] != val)
+      return 0;
+    if (node->count == 1 && node->low != VAL_MIN) {
+      if (ul_replace(link, node, next, next))
+	return 1;
+      continue;
+    }
+    repl = ul_copy(node->low, node->keys, node->count);
+    memmove(&repl->keys[rank], &repl->keys[rank + 1],
+	    (repl->count - rank - 1) * sizeof(int32_t));
+    repl->count--;
+    repl->keys[repl->count] = UL_EMPTY;
+    repl->next = next;
+    if (ul_replace(link, node, next, repl))
+      return 1;
+    free(repl);
+  }
+}
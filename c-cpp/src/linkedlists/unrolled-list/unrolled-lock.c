@@ -0,0 +1,237 @@
+/*
+ * File:
+ *   unrolled-lock.c
+ * Description:
+ *   Lock-based unrolled linked list. Traversals take no lock and read the
+ *   keys of a node under its version, like a seqlock; an update locks the
+ *   one node that owns its key, and the removal of an empty node also
+ *   locks its predecessor.
+ *
+ *   NB. as in the lazy list, unlinked nodes are not freed: a traversal
+ *   may still be reading them.
+ *
+ * unrolled-lock.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "intset.h"
+
+/*
+ * Returns the last node from node on whose low is at most val, node's
+ * low being at most val.
+ */
+static ul_node_t *ul_locate(ul_node_t *node, val_t val)
+{
+  ul_node_t *next;
+
+  while ((next = node->next) != NULL && next->low <= val) {
+    FS_READ(&next->next, next, sizeof(ul_node_t));
+    node = next;
+  }
+  return node;
+}
+
+/* Starts and ends a change to a locked node */
+static inline void ul_write_begin(ul_node_t *node)
+{
+  node->version++;
+  AO_nop_write();
+}
+
+static inline void ul_write_end(ul_node_t *node)
+{
+  AO_nop_write();
+  node->version++;
+}
+
+/*
+ * Returns whether the node that owns val holds it, reading that node at
+ * a version no writer changed during the read. The search goes on from
+ * node, or from the head if node was unlinked.
+ */
+static int ul_search(intset_t *set, ul_node_t *node, val_t val,
+		     ul_node_t **owner)
+{
+  ul_node_t *next;
+  unsigned int version;
+  int rank, found;
+
+  node = ul_locate(node, val);
+  while (1) {
+    version = node->version;
+    AO_nop_read();
+    if (version & 1)
+      continue;
+    if (node->deleted) {
+      node = ul_locate(set->head, val);
+      continue;
+    }
+    next = node->next;
+    if (next != NULL && next->low <= val) {
+      node = ul_locate(next, val);
+      continue;
+    }
+    rank = ul_rank(node->keys, val);
+    found = (rank < node->count && node->keys[rank] == val);
+    AO_nop_read();
+    if (node->version == version)
+      break;
+  }
+  *owner = node;
+  return found;
+}
+
+/*
+ * Locks the node that owns val, starting from node.
+ */
+static ul_node_t *ul_lock_owner(intset_t *set, ul_node_t *node, val_t val)
+{
+  ul_node_t *next;
+
+  while (1) {
+    FS_WRITE(&node->lock);
+    LOCK(&node->lock);
+    if (node->deleted) {
+      UNLOCK(&node->lock);
+      node = ul_locate(set->head, val);
+      continue;
+    }
+    next = node->next;
+    if (next != NULL && next->low <= val) {
+      UNLOCK(&node->lock);
+      node = ul_locate(next, val);
+      continue;
+    }
+    return node;
+  }
+}
+
+/*
+ * Unlinks node if it is still empty. Its predecessor then owns its keys.
+ */
+static void ul_unlink(intset_t *set, ul_node_t *node)
+{
+  ul_node_t *pred, *next;
+
+  while (!node->deleted && node->count == 0) {
+    pred = set->head;
+    while ((next = pred->next) != NULL && next != node && next->low < node->low)
+      pred = next;
+    if (next != node)
+      return;
+    FS_WRITE(&pred->lock);
+    LOCK(&pred->lock);
+    if (pred->deleted || pred->next != node) {
+      UNLOCK(&pred->lock);
+      continue;
+    }
+    FS_WRITE(&node->lock);
+    LOCK(&node->lock);
+    if (node->count == 0) {
+      ul_write_begin(pred);
+      ul_write_begin(node);
+      node->deleted = 1;
+      FS_WRITE(&pred->next);
+      pred->next = node->next;
+      ul_write_end(node);
+      ul_write_end(pred);
+    }
+    UNLOCK(&node->lock);
+    UNLOCK(&pred->lock);
+    return;
+  }
+}
+
+int ul_find(intset_t *set, val_t val)
+{
+  ul_node_t *node;
+
+  return ul_search(set, set->head, val, &node);
+}
+
+/*
+ * Inserts val in the node that owns it, or splits that node if it is
+ * full: the upper half of its keys moves to a new node linked after it.
+ */
+int ul_insert(intset_t *set, val_t val)
+{
+  ul_node_t *node, *split;
+  int rank, half = UL_KEYS / 2, i;
+
+  if (ul_search(set, set->head, val, &node))
+    return 0;
+  node = ul_lock_owner(set, node, val);
+  rank = ul_rank(node->keys, val);
+  if (rank < node->count && node->keys[rank] == val) {
+    UNLOCK(&node->lock);
+    return 0;
+  }
+  ul_write_begin(node);
+  if (node->count == UL_KEYS) {
+    split = ul_new_node(node->keys[half], node->next);
+    for (i = half; i < UL_KEYS; i++) {
+      split->keys[i - half] = node->keys[i];
+      node->keys[i] = UL_EMPTY;
+    }
+    split->count = UL_KEYS - half;
+    node->count = half;
+    if (val > split->low) {
+      rank = ul_rank(split->keys, val);
+      memmove(&split->keys[rank + 1], &split->keys[rank],
+	      (split->count - rank) * sizeof(int32_t));
+      split->keys[rank] = (int32_t)val;
+      split->count++;
+    } else {
+      memmove(&node->keys[rank + 1], &node->keys[rank],
+	      (node->count - rank) * sizeof(int32_t));
+      node->keys[rank] = (int32_t)val;
+      node->count++;
+    }
+    AO_nop_write();
+    FS_WRITE(&node->next);
+    node->next = split;
+  } else {
+    memmove(&node->keys[rank + 1], &node->keys[rank],
+	    (node->count - rank) * sizeof(int32_t));
+    node->keys[rank] = (int32_t)val;
+    node->count++;
+  }
+  ul_write_end(node);
+  UNLOCK(&node->lock);
+  return 1;
+}
+
+int ul_delete(intset_t *set, val_t val)
+{
+  ul_node_t *node;
+  int rank, empty;
+
+  if (!ul_search(set, set->head, val, &node))
+    return 0;
+  node = ul_lock_owner(set, node, val);
+  rank = ul_rank(node->keys, val);
+  if (rank >= node->count || node->keys[rank] != val) {
+    UNLOCK(&node->lock);
+    return 0;
+  }
+  ul_write_begin(node);
+  memmove(&node->keys[rank], &node->keys[rank + 1],
+	  (node->count - rank - 1) * sizeof(int32_t));
+  node->count--;
+  node->keys[node->count] = UL_EMPTY;
+  ul_write_end(node);
+  empty = (node->count == 0 && node != set->head);
+  UNLOCK(&node->lock);
+  if (empty)
+    ul_unlink(set, node);
+  return 1;
+}
@@ -0,0 +1,123 @@
+/*
+ * File:
+ *   unrolled.c
+ * Description:
+ *   Unrolled linked list nodes and the sequential operations on the set
+ *
+ * unrolled.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "intset.h"
+
+FS_STATS_DEFINE
+LOCKS_DEFINE
+
+ul_node_t *ul_new_node(val_t low, ul_node_t *next)
+{
+  ul_node_t *node;
+  int i;
+
+  if (posix_memalign((void **)&node, UL_LINE, UL_NODE_SIZE) != 0) {
+    perror("malloc");
+    exit(1);
+  }
+  memset(node, 0, UL_NODE_SIZE);
+  node->next = next;
+  node->low = (int32_t)low;
+  node->count = 0;
+  for (i = 0; i < UL_KEYS; i++)
+    node->keys[i] = UL_EMPTY;
+#ifndef LOCKFREE
+  INIT_LOCK(&node->lock);
+#endif
+  return node;
+}
+
+intset_t *set_new()
+{
+  intset_t *set;
+
+  if ((set = (intset_t *)malloc(sizeof(intset_t))) == NULL) {
+    perror("malloc");
+    exit(1);
+  }
+  set->head = ul_new_node(VAL_MIN, NULL);
+
+  return set;
+}
+
+/*
+ * A replaced node of the lock-free list stays linked until a traversal
+ * unlinks it; its marked next pointer leads to what replaced it.
+ */
+static ul_node_t *ul_successor(ul_node_t *node)
+{
+  return (ul_node_t *)((uintptr_t)node->next & ~(uintptr_t)1);
+}
+
+static int ul_replaced(ul_node_t *node)
+{
+  return ((uintptr_t)node->next & 1) != 0;
+}
+
+void set_delete(intset_t *set)
+{
+  ul_node_t *node, *next;
+
+  node = set->head;
+  while (node != NULL) {
+    next = ul_successor(node);
+#ifndef LOCKFREE
+    DESTROY_LOCK(&node->lock);
+#endif
+    free(node);
+    node = next;
+  }
+  free(set);
+}
+
+int set_size(intset_t *set)
+{
+  int size = 0;
+  ul_node_t *node;
+
+  for (node = set->head; node != NULL; node = ul_successor(node))
+    if (!ul_replaced(node))
+      size += node->count;
+
+  return size;
+}
+
+void set_print_stats(intset_t *set)
+{
+  unsigned long nodes = 0, keys = 0, empty = 0, full = 0;
+  ul_node_t *node;
+
+  for (node = set->head; node != NULL; node = ul_successor(node)) {
+    if (ul_replaced(node))
+      continue;
+    nodes++;
+    keys += node->count;
+    if (node->count == 0)
+      empty++;
+    if (node->count == UL_KEYS)
+      full++;
+  }
+  printf("Nodes         : %lu (%d keys, %d bytes each, %s scan)\n", nodes,
+	 UL_KEYS, UL_NODE_SIZE, UL_SIMD_NAME);
+  printf("  #keys/node  : %.2f (%.1f%% full)\n",
+	 nodes ? (double)keys / nodes : 0.0,
+	 nodes ? 100.0 * keys / (nodes * UL_KEYS) : 0.0);
+  printf("  #empty      : %lu\n", empty);
+  printf("  #full       : %lu\n", full);
+}
@@ -0,0 +1,188 @@
+/*
+ * File:
+ *   unrolled.h
+ * Description:
+ *   Unrolled linked list implementation of an integer set: each node
+ *   holds a sorted array of keys and fills one cache line (two with
+ *   pthread mutexes), so a traversal reads several keys per miss.
+ *
+ *   Node n owns the keys in [n->low, n->next->low). A full node splits
+ *   in two, an empty node other than the first is unlinked; nodes are
+ *   not merged otherwise. Keys are 32-bit, compared 4 at a time with
+ *   SSE2 or 8 at a time with AVX2 (SIMD=AVX2), see common/Makefile.common.
+ *
+ * unrolled.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <stdint.h>
+
+#if defined(__AVX2__) && !defined(NO_SIMD)
+#  include <immintrin.h>
+#  define UL_SIMD_NAME                  "avx2"
+#elif defined(__SSE2__) && !defined(NO_SIMD)
+#  include <emmintrin.h>
+#  define UL_SIMD_NAME                  "sse2"
+#else
+#  define UL_SIMD_NAME                  "scalar"
+#endif
+
+#include <atomic_ops.h>
+
+#include "locks.h"
+#include "placement.h"
+
+#define DEFAULT_DURATION                10000
+#define DEFAULT_INITIAL                 256
+#define DEFAULT_NB_THREADS              1
+#define DEFAULT_RANGE                   0x7FFFFFFF
+#define DEFAULT_SEED                    0
+#define DEFAULT_UPDATE                  20
+#define DEFAULT_LOCKTYPE	    	1
+#define DEFAULT_ALTERNATE	        0
+#define DEFAULT_EFFECTIVE	 	1
+
+#define XSTR(s)                         STR(s)
+#define STR(s)                          #s
+
+#define ATOMIC_CAS_MB(a, e, v)          (AO_compare_and_swap_full((volatile AO_t *)(a), (AO_t)(e), (AO_t)(v)))
+
+static volatile AO_t stop;
+
+#define TRANSACTIONAL                   d->unit_tx
+
+typedef intptr_t val_t;
+#define VAL_MIN                         INT_MIN
+#define VAL_MAX                         INT_MAX
+
+/* ################################################################### *
+ * UNROLLED LINKED LIST
+ * ################################################################### */
+
+#define UL_LINE                         64
+
+/* Empty slots hold UL_EMPTY, which is never lower than a key */
+#define UL_EMPTY                        INT32_MAX
+
+#ifdef LOCKFREE
+
+/*
+ * Nodes are never modified once published, but for their next pointer.
+ * An update replaces a node with a copy by CAS-ing its next pointer to
+ * the copy with the low-order bit set, see unrolled-cow.c.
+ */
+#define UL_KEYS                         12
+#define UL_NODE_SIZE                    UL_LINE
+
+typedef struct ul_node {
+  struct ul_node *volatile next;
+  int32_t low;
+  int32_t count;
+  int32_t keys[UL_KEYS];
+} ul_node_t;
+
+#else
+
+/*
+ * The version is odd while the keys or the next pointer of the node
+ * change, under its lock, see unrolled-lock.c.
+ * Larger locks leave room for fewer keys, so their nodes take more lines.
+ */
+#if defined(LOCK_COHORT)
+#define UL_KEYS                         24
+#define UL_NODE_SIZE                    (3 * UL_LINE)
+#elif defined(MUTEX) || defined(LOCK_MCS) || defined(LOCK_CLH)
+#define UL_KEYS                         16
+#define UL_NODE_SIZE                    (2 * UL_LINE)
+#else
+#define UL_KEYS                         8
+#define UL_NODE_SIZE                    UL_LINE
+#endif
+
+typedef struct ul_node {
+  struct ul_node *volatile next;
+  volatile unsigned int version;
+  volatile int deleted;
+  int32_t low;
+  int32_t count;
+  ptlock_t lock;
+  int32_t keys[UL_KEYS];
+} ul_node_t;
+
+#endif /* LOCKFREE */
+
+/* Fails to compile if a node outgrows its cache lines */
+typedef char ul_node_fits[sizeof(ul_node_t) <= UL_NODE_SIZE ? 1 : -1];
+
+typedef struct intset {
+  ul_node_t *head;                /* first node, its low is VAL_MIN */
+} intset_t;
+
+/*
+ * Number of keys of the node lower than val, that is the slot val has
+ * or would have in keys[].
+ */
+static inline int ul_rank(const int32_t *keys, val_t val)
+{
+#if defined(__AVX2__) && !defined(NO_SIMD)
+  __m256i v8 = _mm256_set1_epi32((int32_t)val);
+  int i, rank = 0;
+
+  for (i = 0; i + 8 <= UL_KEYS; i += 8) {
+    __m256i k = _mm256_loadu_si256((const __m256i *)&keys[i]);
+
+    rank += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v8, k))));
+  }
+  if (i < UL_KEYS) {
+    __m128i k = _mm_loadu_si128((const __m128i *)&keys[i]);
+
+    rank += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(k, _mm256_castsi256_si128(v8)))));
+  }
+  return rank;
+#elif defined(__SSE2__) && !defined(NO_SIMD)
+  __m128i v = _mm_set1_epi32((int32_t)val);
+  int i, rank = 0;
+
+  for (i = 0; i < UL_KEYS; i += 4) {
+    __m128i k = _mm_loadu_si128((const __m128i *)&keys[i]);
+
+    rank += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(k, v))));
+  }
+  return rank;
+#else
+  int i;
+
+  for (i = 0; i < UL_KEYS && keys[i] < val; i++)
+    ;
+  return i;
+#endif
+}
+
+ul_node_t *ul_new_node(val_t low, ul_node_t *next);
+intset_t *set_new();
+void set_delete(intset_t *set);
+int set_size(intset_t *set);
+void set_print_stats(intset_t *set);
+
+int ul_find(intset_t *set, val_t val);
+int ul_insert(intset_t *set, val_t val);
+int ul_delete(intset_t *set, val_t val);
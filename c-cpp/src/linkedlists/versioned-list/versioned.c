@@ -0,0 +1,149 @@
+/*
+ * File:
+ *   versioned.c
+ * Description:
+ *   Versioned linked list implementation of an integer set based on the
+ *   VBL algorithm of Aksenov et al.
+ *   "A Concurrency-Optimal List-Based Set"
+ *   V. Aksenov, V. Gramoli, P. Kuznetsov, A. Malova, S. Ravi
+ *   arXiv:1502.01633, 2015
+ *
+ *   Traversals take no lock. An update locks the predecessor it found
+ *   only if the version of that predecessor has not changed since it
+ *   checked the predecessor was still linked to its successor, so the
+ *   check stays valid once the lock is held. Inserts lock one node and
+ *   never wait: a failed attempt restarts from the predecessor.
+ *
+ * versioned.c is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "versioned.h"
+
+/*
+ * Locks n if it is free and still at the given version. The version of
+ * a node only changes while its lock is held, so the state read at that
+ * version is the one the lock now protects.
+ */
+int vbl_lock_at(node_l_t *n, AO_t version) {
+	FS_WRITE(&n->lock);
+	if (TRYLOCK(&n->lock) != 0)
+		return 0;
+	if (n->version != version) {
+		UNLOCK(&n->lock);
+		return 0;
+	}
+	return 1;
+}
+
+void vbl_unlock(node_l_t *n) {
+	AO_store_release(&n->version, n->version + 1);
+	UNLOCK(&n->lock);
+}
+
+/*
+ * Finds the last node pred whose value is lower than val and its
+ * successor curr, starting from *pred when it is still in the list, and
+ * returns the version at which pred was seen unmarked and linked to curr.
+ */
+static AO_t vbl_locate(intset_l_t *set, val_t val, node_l_t **pred,
+		       node_l_t **curr) {
+	node_l_t *p, *c;
+	AO_t version;
+
+	p = *pred;
+	if (p == NULL || p->deleted)
+		p = set->head;
+	while (1) {
+		c = p->next;
+		while (c->val < val) {
+			p = c;
+			FS_READ(&c->next, c, sizeof(node_l_t));
+			c = c->next;
+		}
+		version = AO_load_acquire(&p->version);
+		if (!p->deleted && p->next == c)
+			break;
+		if (p->deleted)
+			p = set->head;
+	}
+	*pred = p;
+	*curr = c;
+	return version;
+}
+
+int vbl_find(intset_l_t *set, val_t val) {
+	node_l_t *curr;
+
+	curr = set->head;
+	while (curr->val < val) {
+		FS_READ(&curr->next, curr, sizeof(node_l_t));
+		curr = curr->next;
+	}
+	return ((curr->val == val) && !curr->deleted);
+}
+
+int vbl_insert(intset_l_t *set, val_t val) {
+	node_l_t *pred = NULL, *curr, *newnode = NULL;
+	AO_t version;
+
+	while (1) {
+		version = vbl_locate(set, val, &pred, &curr);
+		if (curr->val == val) {
+			/* a node being removed is unlinked once pred is free */
+			if (curr->deleted)
+				continue;
+			if (newnode != NULL)
+				node_delete_l(newnode);
+			return 0;
+		}
+		if (newnode == NULL)
+			newnode = new_node_l(val, curr, 0);
+		else
+			newnode->next = curr;
+		if (!vbl_lock_at(pred, version))
+			continue;
+		AO_nop_write();
+		FS_WRITE(&pred->next);
+		pred->next = newnode;
+		vbl_unlock(pred);
+		return 1;
+	}
+}
+
+/*
+ * Marks curr as deleted and unlinks it with both pred and curr locked,
+ * so that no insert after curr is lost.
+ *
+ * NB. as in the lazy list, the node is not freed: a traversal may still
+ * be reading it.
+ */
+int vbl_delete(intset_l_t *set, val_t val) {
+	node_l_t *pred = NULL, *curr;
+	AO_t version;
+
+	while (1) {
+		version = vbl_locate(set, val, &pred, &curr);
+		if (curr->val != val)
+			return 0;
+		if (!vbl_lock_at(pred, version))
+			continue;
+		FS_WRITE(&curr->lock);
+		LOCK(&curr->lock);
+		curr->deleted = 1;
+		FS_WRITE(&pred->next);
+		pred->next = curr->next;
+		vbl_unlock(curr);
+		vbl_unlock(pred);
+		return 1;
+	}
+}
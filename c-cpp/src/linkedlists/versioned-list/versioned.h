@@ -0,0 +1,33 @@
+/*
+ * File:
+ *   versioned.h
+ * Description:
+ *   Versioned linked list implementation of an integer set based on the
+ *   VBL algorithm of Aksenov et al.
+ *   "A Concurrency-Optimal List-Based Set"
+ *   V. Aksenov, V. Gramoli, P. Kuznetsov, A. Malova, S. Ravi
+ *   arXiv:1502.01633, 2015
+ *
+ * versioned.h is part of Synchrobench
+ *
+ * Synchrobench is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, version 2
+ * of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "linkedlist-lock.h"
+
+/* node locks taken at a version */
+int vbl_lock_at(node_l_t *n, AO_t version);
+void vbl_unlock(node_l_t *n);
+
+/* linked list accesses */
+int vbl_find(intset_l_t *set, val_t val);
+int vbl_insert(intset_l_t *set, val_t val);
+int vbl_delete(intset_l_t *set, val_t val);
@@ -30,10 +30,13 @@
 #include <unistd.h>
 #include "portable_defns.h"
 #include "gc.h"
+#include "gcstats.h"
+#ifdef HUGEPAGE
+#include "hugepage.h"
+#endif
 
 //#define MINIMAL_GC
 /*#define YIELD_TO_HELP_PROGRESS*/
-//#define PROFILE_GC
 
 /* Recycled nodes are filled with this value if WEAK_MEM_ORDER. */
 #define INVALID_BYTE 0
@@ -122,13 +125,18 @@ static struct gc_global_st
     /* Main allocation lists. */
     chunk_t * VOLATILE alloc[MAX_SIZES];
     VOLATILE unsigned int alloc_size[MAX_SIZES];
-#ifdef PROFILE_GC
-    VOLATILE unsigned int total_size;
-    VOLATILE unsigned int allocations;
-    VOLATILE unsigned int num_reclaims;
-#endif
+    CACHE_PAD(4);
+
+    /* Reclamation statistics, mostly updated under inreclaim. */
+    VOLATILE unsigned int nr_threads;
+    gc_stats_t stats;
 } gc_global;
 
+#ifdef HUGEPAGE
+/* Node blocks are carved out of huge-page regions. */
+static hp_arena_t gc_hp_arena = HP_ARENA_INITIALIZER;
+#endif
+
 
 /* Per-thread state. */
 struct gc_st
@@ -136,6 +144,13 @@ struct gc_st
     /* Epoch that this thread sees. */
     unsigned int epoch;
 
+    /* Thread number reported for epoch stalls. */
+    int id;
+
+    /* Blocks (and bytes) passed to gc_free() by this thread. */
+    unsigned long retired;
+    unsigned long retired_bytes;
+
     /* Number of calls to gc_entry() since last gc_reclaim() attempt. */
     unsigned int entries_since_reclaim;
 
@@ -239,12 +254,13 @@ static chunk_t *get_filled_chunks(int n, int sz)
     char *node;
     int i;
 
-#ifdef PROFILE_GC
-    ADD_TO(gc_global.total_size, n * BLKS_PER_CHUNK * sz);
-    ADD_TO(gc_global.allocations, 1);
-#endif
+    gc_stats_chunks(&gc_global.stats, n, n * BLKS_PER_CHUNK * sz);
 
+#ifdef HUGEPAGE
+    node = hp_alloc(&gc_hp_arena, n * BLKS_PER_CHUNK * sz);
+#else
     node = ALIGNED_ALLOC(n * BLKS_PER_CHUNK * sz);
+#endif
     if ( node == NULL ) MEM_FAIL(n * BLKS_PER_CHUNK * sz);
 #ifdef WEAK_MEM_ORDER
     INITIALISE_NODES(node, n * BLKS_PER_CHUNK * sz);
@@ -325,8 +341,9 @@ static void gc_reclaim(void)
 {
     ptst_t       *ptst, *first_ptst, *our_ptst = NULL;
     gc_t         *gc = NULL;
-    unsigned long curr_epoch;
-    chunk_t      *ch, *t;
+    unsigned long curr_epoch, retired_bytes, n;
+    unsigned long long now;
+    chunk_t      *ch, *t, *c;
     int           two_ago, three_ago, i, j;
     
     /* Barrier to entering the reclaim critical section. */
@@ -340,10 +357,21 @@ static void gc_reclaim(void)
     MB();
     curr_epoch = gc_global.current;
 
+    now = gc_stats_now();
+    gc_global.stats.attempts++;
+    retired_bytes = 0;
+    for ( ptst = first_ptst; ptst != NULL; ptst = ptst_next(ptst) )
+        retired_bytes += ptst->gc->retired_bytes;
+    gc_stats_sample(&gc_global.stats, now, retired_bytes);
+
     /* Have all threads seen the current epoch, or not in mutator code? */
     for ( ptst = first_ptst; ptst != NULL; ptst = ptst_next(ptst) )
     {
-        if ( (ptst->count > 1) && (ptst->gc->epoch != curr_epoch) ) goto out;
+        if ( (ptst->count > 1) && (ptst->gc->epoch != curr_epoch) )
+        {
+            gc_stats_stall(&gc_global.stats, now, ptst->gc->id);
+            goto out;
+        }
     }
 
     /*
@@ -378,6 +406,9 @@ static void gc_reclaim(void)
             /* NB. Leave one chunk behind, as it is probably not yet full. */
             t = gc->garbage[three_ago][i];
             if ( (t == NULL) || ((ch = t->next) == t) ) continue;
+            for ( n = 0, c = ch; c != t; c = c->next ) n += c->i;
+            gc_stats_reclaim(&gc_global.stats, now, three_ago, NR_EPOCHS,
+                             n, n * gc_global.blk_sizes[i]);
             gc->garbage_tail[three_ago][i]->next = ch;
             gc->garbage_tail[three_ago][i] = t;
             t->next = t;
@@ -399,13 +430,10 @@ static void gc_reclaim(void)
         }
     }
 
-    #ifdef PROFILE_GC
-    ADD_TO(gc_global.num_reclaims, 1);
-    #endif
-
     /* Update current epoch. */
     WMB();
     gc_global.current = (curr_epoch+1) % NR_EPOCHS;
+    gc_stats_advance(&gc_global.stats, now, (curr_epoch+1) % NR_EPOCHS);
 
  out:
     gc_global.inreclaim = 0;
@@ -462,8 +490,8 @@ static chunk_t *chunk_from_cache(gc_t *gc)
 
 void gc_free(ptst_t *ptst, void *p, int alloc_id) 
 {
-#ifndef MINIMAL_GC
     gc_t *gc = ptst->gc;
+#ifndef MINIMAL_GC
     chunk_t *prev, *new, *ch = gc->garbage[gc->epoch][alloc_id];
 
     if ( ch == NULL )
@@ -483,6 +511,8 @@ void gc_free(ptst_t *ptst, void *p, int alloc_id)
 
     ch->blk[ch->i++] = p;
 #endif
+    gc->retired++;
+    gc->retired_bytes += gc_global.blk_sizes[alloc_id];
 }
 
 
@@ -581,12 +611,16 @@ void gc_exit(ptst_t *ptst)
 gc_t *gc_init(void)
 {
     gc_t *gc;
-    int   i;
+    int   i, ni;
 
     gc = ALIGNED_ALLOC(sizeof(*gc));
     if ( gc == NULL ) MEM_FAIL(sizeof(*gc));
     memset(gc, 0, sizeof(*gc));
 
+    i = gc_global.nr_threads;
+    while ( (ni = CASIO(&gc_global.nr_threads, i, i+1)) != i ) i = ni;
+    gc->id = i;
+
 #ifdef WEAK_MEM_ORDER
     /* Initialise shootdown state. */
     gc->async_page = mmap(NULL, gc_global.page_size, PROT_NONE, 
@@ -643,13 +677,28 @@ void gc_remove_hook(int hook_id)
 }
 
 
+/*
+ * gc_get_stats: Snapshot of the reclamation statistics. The per-thread
+ * retirement counters are read without synchronisation.
+ */
+void gc_get_stats(gc_stats_t *s)
+{
+    ptst_t *ptst;
+
+    *s = gc_global.stats;
+    for ( ptst = ptst_first(); ptst != NULL; ptst = ptst_next(ptst) )
+    {
+        s->retired       += ptst->gc->retired;
+        s->retired_bytes += ptst->gc->retired_bytes;
+    }
+    s->now_ns = gc_stats_now();
+}
+
+
 void _destroy_gc_subsystem(void)
 {
-#ifdef PROFILE_GC
-    printf("Total heap: %u bytes (%.2fMB) in %u allocations\n",
-           gc_global.total_size, (double)gc_global.total_size / 1000000,
-           gc_global.allocations);
-    printf("Num reclaims = %lu\n", gc_global.num_reclaims);
+#ifdef HUGEPAGE
+    hp_print_stats(&gc_hp_arena, "gc chunks");
 #endif
 }
 
@@ -657,6 +706,10 @@ void _destroy_gc_subsystem(void)
 void _init_gc_subsystem(void)
 {
     memset(&gc_global, 0, sizeof(gc_global));
+    gc_stats_init(&gc_global.stats);
+#ifdef MINIMAL_GC
+    gc_global.stats.disabled = 1;
+#endif
 
     gc_global.page_size   = (unsigned int)sysconf(_SC_PAGESIZE);
     gc_global.free_chunks = alloc_more_chunks();
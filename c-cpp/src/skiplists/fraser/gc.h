@@ -3,6 +3,8 @@
 
 typedef struct gc_st gc_t;
 
+#include "gcstats.h"
+
 /* Most of these functions peek into a per-thread state struct. */
 #include "ptst.h"
 
@@ -33,6 +35,9 @@ void gc_add_ptr_to_hook_list(ptst_t *ptst, void *ptr, int hook_id);
 void gc_enter(ptst_t *ptst);
 void gc_exit(ptst_t *ptst);
 
+/* Snapshot of the reclamation statistics, see gcstats.h */
+void gc_get_stats(gc_stats_t *s);
+
 /* Start-of-day initialisation of garbage collector. */
 void _init_gc_subsystem(void);
 void _destroy_gc_subsystem(void);
@@ -33,6 +33,7 @@ pthread_key_t ptst_key;
 ptst_t *ptst_list;
 
 static unsigned int next_id;
+static unsigned long reuse_count;
 
 ptst_t *critical_enter(void)
 {
@@ -46,6 +47,7 @@ ptst_t *critical_enter(void)
         {
             if ( (ptst->count == 0) && (CASIO(&ptst->count, 0, 1) == 0) ) 
             {
+                ADD_TO(reuse_count, 1);
                 break;
             }
         }
@@ -83,10 +85,23 @@ static void ptst_destructor(ptst_t *ptst)
 }
 
 
+/*
+ * A thread releases its ptst on exit and the next thread to enter a
+ * critical region takes it over, so under thread churn the number of
+ * ptsts stays at the peak number of concurrent threads.
+ */
+void ptst_get_counts(unsigned int *nr_ptst, unsigned long *nr_reused)
+{
+    *nr_ptst   = next_id;
+    *nr_reused = reuse_count;
+}
+
+
 void _init_ptst_subsystem(void) 
 {
     ptst_list = NULL;
     next_id   = 0;
+    reuse_count = 0;
     WMB();
     if ( pthread_key_create(&ptst_key, (void (*)(void *))ptst_destructor) )
     {
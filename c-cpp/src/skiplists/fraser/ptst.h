@@ -41,6 +41,9 @@ extern ptst_t *ptst_list;
 #define ptst_first()  (ptst_list)
 #define ptst_next(_p) ((_p)->next)
 
+/* Number of ptsts allocated, and of releases taken over by a new thread. */
+void ptst_get_counts(unsigned int *nr_ptst, unsigned long *nr_reused);
+
 /* Called once at start-of-day for entire application. */
 void _init_ptst_subsystem(void);
 
@@ -99,6 +99,10 @@ set_t *set_alloc(void);
 void set_print(set_t *set);
 unsigned long set_count(set_t *set);
 void set_print_nodenums(set_t *set);
+#ifdef FS_STATS
+/* Placement policy and false-sharing estimate, see placement.h */
+void set_print_fs_stats(void);
+#endif
 
 #endif /* __SET_IMPLEMENTATION__ */
 
@@ -42,6 +42,7 @@
 #include "portable_defns.h"
 #include "ptst.h"
 #include "set.h"
+#include "placement.h"
 
 
 /*
@@ -69,6 +70,13 @@ struct set_st
 
 static int gc_id[NUM_LEVELS];
 
+FS_STATS_DEFINE
+
+/* Bytes spanned by node @_n; the tail sentinel has a zero level. */
+#define NODE_BYTES(_n)                                                  \
+    (sizeof(node_t) + ((((_n)->level & LEVEL_MASK) ?                    \
+        ((_n)->level & LEVEL_MASK) : NUM_LEVELS) - 1) * sizeof(node_t *))
+
 /*
  * PRIVATE FUNCTIONS
  */
@@ -141,6 +149,7 @@ static sh_node_pt strong_search_predecessors(
             for ( ; ; )
             {
                 READ_FIELD(y_next, y->next[i]);
+                FS_READ(&y->next[i], y, NODE_BYTES(y));
                 if ( !is_marked_ref(y_next) ) break;
                 y = get_unmarked_ref(y_next);
             }
@@ -156,6 +165,7 @@ static sh_node_pt strong_search_predecessors(
         /* Swing forward pointer over any marked nodes. */
         if ( x_next != y )
         {
+            FS_WRITE(&x->next[i]);
             old_x_next = CASPO(&x->next[i], x_next, y);
             if ( old_x_next != x_next ) goto retry;
         }
@@ -182,6 +192,7 @@ static sh_node_pt weak_search_predecessors(
         for ( ; ; )
         {
             READ_FIELD(x_next, x->next[i]);
+            FS_READ(&x->next[i], x, NODE_BYTES(x));
             x_next = get_unmarked_ref(x_next);
 
             READ_FIELD(x_next_k, x_next->k);
@@ -211,6 +222,7 @@ static void mark_deleted(sh_node_pt x, int level)
     while ( --level >= 0 )
     {
         x_next = x->next[level];
+        FS_WRITE(&x->next[level]);
         while ( !is_marked_ref(x_next) )
         {
             x_next = CASPO(&x->next[level], x_next, get_marked_ref(x_next));
@@ -223,6 +235,7 @@ static void mark_deleted(sh_node_pt x, int level)
 static int check_for_full_delete(sh_node_pt x)
 {
     int level = x->level;
+    FS_WRITE(&x->level);
     return ((level & READY_FOR_FREE) ||
             (CASIO(&x->level, level, level | READY_FOR_FREE) != level));
 }
@@ -359,6 +372,7 @@ int set_update(set_t *l, setkey_t k, setval_t v, int overwrite)
 
     /* We've committed when we've inserted at level 1. */
     WMB_NEAR_CAS(); /* make sure node fully initialised before inserting */
+    FS_WRITE(&preds[0]->next[0]);
     old_next = CASPO(&preds[0]->next[0], succ, new);
     if ( old_next != succ )
     {
@@ -380,6 +394,7 @@ int set_update(set_t *l, setkey_t k, setval_t v, int overwrite)
         /* Ensure forward pointer of new node is up to date. */
         if ( new_next != succ )
         {
+            FS_WRITE(&new->next[i]);
             old_next = CASPO(&new->next[i], new_next, succ);
             if ( is_marked_ref(old_next) ) goto success;
             assert(old_next == new_next);
@@ -390,6 +405,7 @@ int set_update(set_t *l, setkey_t k, setval_t v, int overwrite)
         assert((pred->k < k) && (succ->k > k));
 
         /* Replumb predecessor's forward pointer. */
+        FS_WRITE(&pred->next[i]);
         old_next = CASPO(&pred->next[i], succ, new);
         if ( old_next != succ )
         {
@@ -436,6 +452,7 @@ int set_remove(set_t *l, setkey_t k)
 
     /* Once we've marked the value field, the node is effectively deleted. */
     new_v = x->v;
+    FS_WRITE(&x->v);
     do {
         v = new_v;
         if ( v == NULL ) goto out;
@@ -457,6 +474,7 @@ int set_remove(set_t *l, setkey_t k)
      */
     for ( i = level - 1; i >= 0; i-- )
     {
+        FS_WRITE(&preds[i]->next[i]);
         if ( CASPO(&preds[i]->next[i], x, get_unmarked_ref(x->next[i])) != x )
         {
             if ( (i != (level - 1)) || check_for_full_delete(x) )
@@ -553,13 +571,21 @@ void set_print_nodenums(set_t *set)
         }
 }
 
+#ifdef FS_STATS
+void set_print_fs_stats(void)
+{
+    fs_print_stats(sizeof(node_t));
+}
+#endif
+
 void _init_set_subsystem(void)
 {
     int i;
 
     for ( i = 0; i < NUM_LEVELS; i++ )
     {
-        gc_id[i] = gc_add_allocator(sizeof(node_t) + i*sizeof(node_t *));
+        gc_id[i] = gc_add_allocator(
+            placement_size(sizeof(node_t) + i*sizeof(node_t *)));
     }
 
     printf("_init_set_subsystem() done\n");
@@ -53,24 +53,41 @@ can interrupt other threads trying to traverse the list, as the background
 thread may cause cache invalidations in other threads and cause costly
 reads from memory to occur.
 
+On large lists a single thread can fall behind the updates, so the
+maintenance can also be shared by K background threads (see
+bg_set_threads). Each round, the first background thread cuts the
+list into K key ranges at index nodes of the highest index level
+that has BG_PART_MIN * K nodes. Thread k then owns the nodes from
+its boundary node up to (but excluding) the boundary node of range
+k + 1: it finishes their deletes and raises them into the index levels
+up to the partition level. The boundary nodes are tall, so they are
+neither removed nor raised during that phase, and every index node a
+thread links lies between its own two boundaries. The levels above the
+partition level, adding and removing a level, are left to the first
+thread once all ranges are done.
+
 */
 
 #include <stdlib.h>
 #include <pthread.h>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/time.h>
 
 #include "background.h"
 #include "skiplist.h"
 #include "garbagecoll.h"
 #include "ptst.h"
 #include "common.h"
+#include "bgsched.h"
 
 /* - Private variables - */
 
 static set_t *set;	        /* the set to maintain */
-static pthread_t bg_thread;	/* background thread */
+static pthread_t bg_thread[BG_MAX_THREADS]; /* background threads */
+static pthread_barrier_t bg_barrier;        /* separates round phases */
 
 /* Uncomment to collect background stats - reduces performance */
 /* #define BG_STATS */
@@ -87,167 +104,434 @@ static struct bg_stats {
 static int bg_finished;
 static int bg_running;
 
-/* for deciding whether to lower the skip list index level */
-static int bg_non_deleted;
-static int bg_tall_deleted;
-
-/* the amount of time the bg thread sleeps for each iteration */
+/* the amount of time the bg thread sleeps for each iteration,
+ * adapted to the changes of the list unless told otherwise */
 static int bg_sleep_time;
+static int bg_adaptive = 1;
+static bg_sched_t bg_sched;
+
+/* the number of background threads and, for the current round,
+ * the number of key ranges, the partition level and if we stop */
+static int bg_nthreads = 1;
+static int bg_nparts;
+static int bg_part_level;
+static int bg_quit;
+
+/* a key range maintained by one background thread */
+typedef struct bg_range bg_range_t;
+static struct bg_range {
+        /* first index node of the range at each level up to the
+         * partition level, and the first node of the next range */
+        inode_t *start[MAX_LEVELS];
+        node_t  *stop;
+        int raised;
+
+        /* for deciding whether to lower the skip list index level */
+        int non_deleted;
+        int tall_deleted;
+
+        /* for deciding the sleep time: nodes raised or removed and
+         * the longest run of level 0 nodes in the last pass */
+        unsigned long changed;
+        unsigned long run;
+
+        /* lag of the range, summed over the passes */
+        unsigned long passes;
+        unsigned long nodes;
+        unsigned long deleted;      /* deletes found unfinished */
+        unsigned long tall;         /* of those, nodes with index nodes */
+        unsigned long indexed;      /* live nodes with index nodes */
+        unsigned long max_run;      /* longest run of level 0 nodes */
+        unsigned long usecs;
+} __attribute__((aligned(CACHE_LINE_SIZE))) bg_range[BG_MAX_THREADS];
 
 /* - Private Functions - */
 
 static void* bg_loop(void *args);
-static void bg_trav_nodes(ptst_t *ptst);
+static void bg_round(ptst_t *ptst);
+static int bg_partition(void);
+static void bg_range_pass(bg_range_t *range, ptst_t *ptst);
+static void bg_finish_round(ptst_t *ptst);
+static void bg_schedule(void);
+static void bg_trav_nodes(bg_range_t *range, ptst_t *ptst);
 static void bg_lower_ilevel(inode_t *new_low, ptst_t *ptst);
-static int bg_raise_nlevel(inode_t *inode, ptst_t *ptst);
+static int bg_raise_nlevel(inode_t *inode, node_t *stop, ptst_t *ptst);
 static int bg_raise_ilevel(inode_t *iprev,inode_t *iprev_tall,
-                           int height, ptst_t *ptst);
+                           int height, node_t *stop, ptst_t *ptst);
 
 /**
  * bg_loop - loop for maintaining index levels
- * @args: void* args as per pthread_create requirements
+ * @args: the background thread number, as a void*
  *
  * Returns a void* value as per pthread_create requirements.
  * Note: Do this loop forever while the program is running.
+ * Thread 0 sleeps and cuts the list into ranges, then every thread
+ * maintains its range, then thread 0 finishes the round.
  */
 static void* bg_loop(void *args)
 {
-        inode_t *inode;
-        inode_t *inew;
-        inode_t *inodes[MAX_LEVELS];
-        int raised = 0; /* keep track of if we raised index level */
-        int threshold;  /* for testing if we should lower index level */
-        int i;
+        long id = (long)args;
+        struct timeval start, end;
         struct sl_ptst *ptst;
 
         assert(NULL != set);
 
         while (1) {
-                if (bg_finished)
+                if (0 == id) {
+                        bg_quit = bg_finished;
+                        if (!bg_quit) {
+                                usleep(bg_sleep_time);
+                                bg_nparts = bg_partition();
+                        }
+                }
+                pthread_barrier_wait(&bg_barrier);
+                if (bg_quit)
                         break;
 
-                usleep(bg_sleep_time);
-
                 #ifdef USE_GC
                 ptst = ptst_critical_enter();
                 #endif
 
-                for (i = 0; i < MAX_LEVELS; i++)
-                        inodes[i] = NULL;
+                if (bg_nparts > 1 && id < bg_nparts)
+                        bg_range_pass(&bg_range[id], ptst);
+
+                pthread_barrier_wait(&bg_barrier);
+
+                if (0 == id) {
+                        if (bg_nparts > 1) {
+                                bg_finish_round(ptst);
+                        } else {
+                                gettimeofday(&start, NULL);
+                                bg_round(ptst);
+                                gettimeofday(&end, NULL);
+                                bg_range[0].usecs +=
+                                        (end.tv_sec - start.tv_sec) * 1000000 +
+                                        (end.tv_usec - start.tv_usec);
+                        }
+                        bg_schedule();
+                }
 
-                #ifdef BG_STATS
-                ++bg_stats.loops;
+                #ifdef USE_GC
+                ptst_critical_exit(ptst);
                 #endif
+        }
 
-                bg_non_deleted = 0;
-                bg_tall_deleted = 0;
+        return NULL;
+}
 
-                /* traverse the node level and do physical deletes */
-                bg_trav_nodes(ptst);
+/**
+ * bg_round - maintain the whole skip list from a single thread
+ * @ptst: per-thread state
+ */
+static void bg_round(ptst_t *ptst)
+{
+        inode_t *inode;
+        inode_t *inew;
+        inode_t **inodes = bg_range[0].start;
+        int raised = 0; /* keep track of if we raised index level */
+        int threshold;  /* for testing if we should lower index level */
+        int i;
 
-                assert(set->head->level < MAX_LEVELS);
+        for (i = 0; i < MAX_LEVELS; i++)
+                inodes[i] = NULL;
 
-                /* get the first index node at each level */
-                inode = set->top;
-                for (i = set->head->level - 1; i >= 0; i--) {
-                        inodes[i] = inode;
-                        assert(NULL != inodes[i]);
-                        inode = inode->down;
-                }
-                assert(NULL == inode);
+        #ifdef BG_STATS
+        ++bg_stats.loops;
+        #endif
 
-                /* raise bottom level nodes */
-                raised = bg_raise_nlevel(inodes[0], ptst);
+        assert(set->head->level < MAX_LEVELS);
 
-                if (raised && (1 == set->head->level)) {
-                        /* add a new index level */
-                        inew = inode_new(NULL, set->top, set->head, ptst);
-                        set->top = inew;
-                        ++set->head->level;
-                        assert(NULL == inodes[1]);
-                        inodes[1] = set->top;
+        /* get the first index node at each level */
+        inode = set->top;
+        for (i = set->head->level - 1; i >= 0; i--) {
+                inodes[i] = inode;
+                assert(NULL != inodes[i]);
+                inode = inode->down;
+        }
+        assert(NULL == inode);
+        bg_range[0].stop = NULL;
 
-                        #ifdef BG_STATS
-                        ++bg_stats.raises;
-                        #endif
-                }
+        /* traverse the node level and do physical deletes */
+        bg_trav_nodes(&bg_range[0], ptst);
 
-                /* raise the index level nodes */
-                for (i = 0; i < (set->head->level - 1); i++) {
-                        assert(i < MAX_LEVELS-1);
-                        raised = bg_raise_ilevel(inodes[i],/* level raised */
-                                                 inodes[i + 1],/* level above */
-                                                 i + 1,/* current height */
-                                                 ptst);
-                }
+        /* raise bottom level nodes */
+        raised = bg_raise_nlevel(inodes[0], NULL, ptst);
+        bg_range[0].changed += raised;
+
+        if (raised && (1 == set->head->level)) {
+                /* add a new index level */
+                inew = inode_new(NULL, set->top, set->head, ptst);
+                set->top = inew;
+                ++set->head->level;
+                assert(NULL == inodes[1]);
+                inodes[1] = set->top;
+
+                #ifdef BG_STATS
+                ++bg_stats.raises;
+                #endif
+        }
+
+        /* raise the index level nodes */
+        for (i = 0; i < (set->head->level - 1); i++) {
+                assert(i < MAX_LEVELS-1);
+                raised = bg_raise_ilevel(inodes[i],/* level raised */
+                                         inodes[i + 1],/* level above */
+                                         i + 1,/* current height */
+                                         NULL,/* up to the end */
+                                         ptst);
+        }
+
+        if (raised) {
+                /* add a new index level */
+                inew = inode_new(NULL, set->top, set->head, ptst);
+                set->top = inew;
+                ++set->head->level;
 
-                if (raised) {
-                        /* add a new index level */
-                        inew = inode_new(NULL, set->top, set->head, ptst);
-                        set->top = inew;
-                        ++set->head->level;
+                #ifdef BG_STATS
+                ++bg_stats.raises;
+                #endif
+        }
+
+        /* if needed, remove the lowest index level */
+        threshold = bg_range[0].non_deleted * 10;
+        if (bg_range[0].tall_deleted > threshold) {
+                if (NULL != inodes[1]) {
+                        bg_lower_ilevel(inodes[1],/* level above */
+                                        ptst);
 
                         #ifdef BG_STATS
-                        ++bg_stats.raises;
+                        ++bg_stats.lowers;
                         #endif
                 }
+        }
+}
 
-                /* if needed, remove the lowest index level */
-                threshold = bg_non_deleted * 10;
-                if (bg_tall_deleted > threshold) {
-                        if (NULL != inodes[1]) {
-                                bg_lower_ilevel(inodes[1],/* level above */
-                                                ptst);
+/**
+ * bg_partition - cut the skip list into key ranges for this round
+ *
+ * Returns the number of ranges, 1 if the index is too small to be
+ * shared among the background threads.
+ * Note: the ranges hold about the same number of index nodes at the
+ * highest index level that has BG_PART_MIN index nodes per thread.
+ */
+static int bg_partition(void)
+{
+        inode_t *inode, *first;
+        int count = 0, pos = 0;
+        int i, j, k;
+
+        if (1 == bg_nthreads)
+                return 1;
+
+        /* find the partition level */
+        first = set->top;
+        for (i = set->head->level - 1; i >= 0; i--) {
+                count = 0;
+                for (inode = first->right; NULL != inode; inode = inode->right)
+                        ++count;
+                if (count >= BG_PART_MIN * bg_nthreads)
+                        break;
+                first = first->down;
+        }
+        if (i < 0)
+                return 1;
+
+        /* the first range starts at the head */
+        bg_part_level = i;
+        for (j = i, inode = first; j >= 0; j--, inode = inode->down)
+                bg_range[0].start[j] = inode;
+
+        /* the others at evenly spaced index nodes */
+        k = 1;
+        for (inode = first->right; k < bg_nthreads; inode = inode->right) {
+                if (++pos < k * count / bg_nthreads)
+                        continue;
+                first = inode;
+                for (j = i; j >= 0; j--, inode = inode->down)
+                        bg_range[k].start[j] = inode;
+                bg_range[k - 1].stop = first->node;
+                inode = first;
+                ++k;
+        }
+        bg_range[k - 1].stop = NULL;
 
-                                #ifdef BG_STATS
-                                ++bg_stats.lowers;
-                                #endif
-                        }
-                }
+        return bg_nthreads;
+}
 
-                #ifdef USE_GC
-                ptst_critical_exit(ptst);
+/**
+ * bg_range_pass - maintain one key range up to the partition level
+ * @range: the range to maintain
+ * @ptst: per-thread state
+ */
+static void bg_range_pass(bg_range_t *range, ptst_t *ptst)
+{
+        struct timeval start, end;
+        int raised;
+        int i;
+
+        gettimeofday(&start, NULL);
+
+        bg_trav_nodes(range, ptst);
+
+        raised = bg_raise_nlevel(range->start[0], range->stop, ptst);
+        range->changed += raised;
+        for (i = 0; i < bg_part_level; i++)
+                raised = bg_raise_ilevel(range->start[i], range->start[i + 1],
+                                         i + 1, range->stop, ptst);
+        range->raised = raised;
+
+        gettimeofday(&end, NULL);
+        range->usecs += (end.tv_sec - start.tv_sec) * 1000000 +
+                        (end.tv_usec - start.tv_usec);
+}
+
+/**
+ * bg_finish_round - maintain the levels above the partition level
+ * @ptst: per-thread state
+ *
+ * Note: runs on the first background thread once every range pass
+ * is over, so the whole index is its own again.
+ */
+static void bg_finish_round(ptst_t *ptst)
+{
+        inode_t *inode;
+        inode_t *inew;
+        inode_t *inodes[MAX_LEVELS];
+        int raised = 0;
+        int non_deleted = 0, tall_deleted = 0;
+        int i;
+
+        #ifdef BG_STATS
+        ++bg_stats.loops;
+        #endif
+
+        for (i = 0; i < bg_nparts; i++) {
+                raised |= bg_range[i].raised;
+                non_deleted += bg_range[i].non_deleted;
+                tall_deleted += bg_range[i].tall_deleted;
+        }
+
+        inode = set->top;
+        for (i = set->head->level - 1; i >= 0; i--) {
+                inodes[i] = inode;
+                inode = inode->down;
+        }
+
+        /* raise the index levels the ranges did not */
+        for (i = bg_part_level; i < (set->head->level - 1); i++)
+                raised = bg_raise_ilevel(inodes[i], inodes[i + 1], i + 1,
+                                         NULL, ptst);
+
+        if (raised) {
+                /* add a new index level */
+                inew = inode_new(NULL, set->top, set->head, ptst);
+                set->top = inew;
+                ++set->head->level;
+
+                #ifdef BG_STATS
+                ++bg_stats.raises;
                 #endif
         }
 
-        return NULL;
+        /* if needed, remove the lowest index level */
+        if (tall_deleted > non_deleted * 10 && set->head->level > 1) {
+                bg_lower_ilevel(inodes[1], ptst);
+
+                #ifdef BG_STATS
+                ++bg_stats.lowers;
+                #endif
+        }
+}
+
+/**
+ * bg_schedule - decide how long to sleep before the next round
+ *
+ * Note: sums up what the passes of the last round changed, see
+ * bgsched.h for the policy.
+ */
+static void bg_schedule(void)
+{
+        unsigned long nodes = 0, changed = 0, run = 0;
+        int i;
+
+        for (i = 0; i < bg_nparts; i++) {
+                nodes += bg_range[i].non_deleted;
+                changed += bg_range[i].changed;
+                if (bg_range[i].run > run)
+                        run = bg_range[i].run;
+        }
+        bg_sleep_time = bg_sched_next(&bg_sched, nodes, changed, run);
 }
 
 /**
  * bg_trav_nodes - traverse node level of skip list and maintain
+ * @range: the key range to traverse
  * @ptst: per-thread state
  * 
  * Note: this will try to remove each of the nodes in the list,
  * in order to extract nodes that have already been logically deleted
  * but that are still accessible.
  */
-static void bg_trav_nodes(ptst_t *ptst)
+static void bg_trav_nodes(bg_range_t *range, ptst_t *ptst)
 {
         node_t *prev, *node;
+        unsigned long run = 0;
 
         assert(NULL != set && NULL != set->head);
 
-        prev = set->head;
+        range->non_deleted = 0;
+        range->tall_deleted = 0;
+        range->changed = 0;
+        range->run = 0;
+        ++range->passes;
+
+        prev = range->start[0]->node;
         node = prev->next;
-        while (NULL != node) {
+        while (NULL != node && range->stop != node) {
+                /* a marker only stands behind a node being removed, which
+                 * was already counted */
+                if (node->marker) {
+                        prev = node;
+                        node = node->next;
+                        continue;
+                }
+                if (NULL == node->val || node == node->val) {
+                        ++range->deleted;
+                        if (0 == node->level)
+                                ++range->changed;
+                }
                 bg_remove(prev, node, ptst);
-                if (NULL != node->val && node != node->val)
-                        ++bg_non_deleted;
+                if (NULL != node->val && node != node->val) {
+                        ++range->non_deleted;
+                        if (node->level >= 1)
+                                ++range->indexed;
+                }
                 else if (node->level >= 1)
-                        ++bg_tall_deleted;
+                        ++range->tall_deleted;
+                if (0 == node->level) {
+                        if (++run > range->run)
+                                range->run = run;
+                } else {
+                        run = 0;
+                }
                 prev = node;
                 node = node->next;
         }
+        range->nodes += range->non_deleted;
+        range->tall += range->tall_deleted;
+        if (range->run > range->max_run)
+                range->max_run = range->run;
 }
 
 /**
  * bg_raise_nlevel - raise level 0 nodes into index levels 
  * @inode: the index node at the start of the bottom index level
+ * @stop: the node to stop before, NULL for the end of the list
  * @ptst: per-thread state
  *
- * Returns 1 if a node was raised and 0 otherwise.
+ * Returns the number of nodes raised.
  */
-static int bg_raise_nlevel(inode_t *inode, ptst_t *ptst)
+static int bg_raise_nlevel(inode_t *inode, node_t *stop, ptst_t *ptst)
 {
         int raised = 0;
         node_t *prev, *node, *next;
@@ -257,22 +541,22 @@ static int bg_raise_nlevel(inode_t *inode, ptst_t *ptst)
 
         assert(NULL != inode);
 
-        prev = set->head;
-        node = set->head->next;
+        prev = inode->node;
+        node = prev->next;
 
         if (NULL == node)
                 return 0;
 
         next = node->next;
 
-        while (NULL != next) {
+        while (NULL != next && stop != node) {
                 /* don't raise deleted nodes */
                 if (node != node->val) {
                         if (((prev->level == 0) &&
                              (node->level == 0)) &&
                              (next->level == 0)) {
 
-                                raised = 1;
+                                ++raised;
 
                                 /* get the correct index above and behind */
                                 while (above && above->node->key < node->key) {
@@ -303,12 +587,13 @@ static int bg_raise_nlevel(inode_t *inode, ptst_t *ptst)
  * @iprev: the first index node at this level
  * @iprev_tall: the first index node at the next highest level
  * @height: the height of the level we are raising
+ * @stop: the node to stop before, NULL for the end of the list
  * @ptst: per-thread state
  *
  * Returns 1 if a node was raised and 0 otherwise.
  */
 static int bg_raise_ilevel(inode_t *iprev, inode_t *iprev_tall,
-                           int height, ptst_t *ptst)
+                           int height, node_t *stop, ptst_t *ptst)
 {
         int raised = 0;
         inode_t *index, *inext, *inew, *above, *above_prev;
@@ -320,7 +605,8 @@ static int bg_raise_ilevel(inode_t *iprev, inode_t *iprev_tall,
 
         index = iprev->right;
 
-        while ((NULL != index) && (NULL != (inext = index->right))) {
+        while ((NULL != index) && (stop != index->node) &&
+               (NULL != (inext = index->right))) {
                 while (index->node->val == index->node) {
                         /* skip deleted nodes */
                         iprev->right = inext;
@@ -330,7 +616,7 @@ static int bg_raise_ilevel(inode_t *iprev, inode_t *iprev_tall,
                         index = inext;
                         inext = inext->right;
                 }
-                if (NULL == inext)
+                if (NULL == inext || stop == index->node)
                         break;
                 if (((iprev->node->level <= height) &&
                      (index->node->level <= height)) &&
@@ -403,30 +689,65 @@ void bg_init(set_t *s)
 }
 
 /**
- * bg_start - start the background thread
+ * bg_set_adaptive - choose between an adaptive and a fixed sleep time
+ * @adaptive: 1 to adapt the sleep time to the changes of the list
+ *
+ * Note: takes effect at the next bg_start, whose sleep time is then
+ * the initial one.
+ */
+void bg_set_adaptive(int adaptive)
+{
+        bg_adaptive = adaptive;
+}
+
+/**
+ * bg_set_threads - set the number of background threads
+ * @nr: the number of threads, and of key ranges
+ *
+ * Note: takes effect at the next bg_start.
+ */
+void bg_set_threads(int nr)
+{
+        assert(nr >= 1 && nr <= BG_MAX_THREADS);
+        bg_nthreads = nr;
+}
+
+/**
+ * bg_start - start the background threads
  * @sleep_time: the time to sleep the bg thread per iteration
  *
- * Note: Only starts the background thread if it is not currently
- * running.
+ * Note: Only starts the background threads if they are not currently
+ * running. The range statistics restart with them.
  */
 void bg_start(int sleep_time)
 {
+        long i;
+
         if (!bg_running) {
                 bg_running = 1;
                 bg_finished = 0;
                 bg_sleep_time = sleep_time;
-                pthread_create(&bg_thread, NULL, bg_loop, NULL);
+                bg_sched_init(&bg_sched, sleep_time, bg_adaptive);
+                memset(bg_range, 0, sizeof(bg_range));
+                pthread_barrier_init(&bg_barrier, NULL, bg_nthreads);
+                for (i = 0; i < bg_nthreads; i++)
+                        pthread_create(&bg_thread[i], NULL, bg_loop,
+                                       (void *)i);
         }
 }
 
 /**
- * bg_stop - stop the background thread
+ * bg_stop - stop the background threads
  */
 void bg_stop(void)
 {
+        int i;
+
         if (bg_running) {
                 bg_finished = 1;
-                pthread_join(bg_thread, NULL);
+                for (i = 0; i < bg_nthreads; i++)
+                        pthread_join(bg_thread[i], NULL);
+                pthread_barrier_destroy(&bg_barrier);
                 BARRIER();
                 bg_running = 0;
         }
@@ -435,10 +756,30 @@ void bg_stop(void)
 /**
  * bg_print_stats - print background statistics
  *
- * Note: this is a noop if BG_STATS is not defined.
+ * Note: the sleep time decisions and the lag of each key range,
+ * averaged over its passes, are always printed, the rest is a noop
+ * if BG_STATS is not defined.
  */
 void bg_print_stats(void)
 {
+        bg_range_t *r;
+        int i;
+
+        bg_sched_print(&bg_sched);
+        for (i = 0; i < bg_nthreads; i++) {
+                r = &bg_range[i];
+                if (0 == r->passes)
+                        continue;
+                printf("  #range %-3d : %lu passes, %.1f ms/pass, "
+                       "%lu nodes, %lu unfinished deletes (%lu tall), "
+                       "%.1f%% indexed, max level 0 run %lu\n",
+                       i, r->passes, r->usecs / 1000.0 / r->passes,
+                       r->nodes / r->passes, r->deleted / r->passes,
+                       r->tall / r->passes,
+                       r->nodes ? r->indexed * 100.0 / r->nodes : 0.0,
+                       r->max_run);
+        }
+
         #ifdef BG_STATS
         printf("Loops = %i\n", bg_stats.loops);
         printf("Raises = %i\n", bg_stats.raises);
@@ -464,10 +805,7 @@ void bg_print_stats(void)
 void bg_help_remove(node_t *prev, node_t *node, ptst_t *ptst)
 {
         node_t *n, *new;
-
-        #ifdef BG_STATS 
         int retval;
-        #endif
 
         assert(NULL != prev);
         assert(NULL != node);
@@ -491,14 +829,15 @@ void bg_help_remove(node_t *prev, node_t *node, ptst_t *ptst)
                 return;
 
         /* remove the nodes */
-        #ifdef BG_STATS
         retval = CAS(&prev->next, node, n->next);
-        #else
-        CAS(&prev->next, node, n->next);
-        #endif
 
         assert (prev->next != prev);
 
+        /* stale prev pointers may still lead to @node, never to its
+         * marker, so only the marker is retired */
+        if (retval)
+                node_delete(n, ptst);
+
         #ifdef BG_STATS
         if (retval)
                 ++bg_stats.delete_succeeds;
@@ -9,7 +9,16 @@
 #include "skiplist.h"
 #include "ptst.h"
 
+/* most background threads, each maintaining one key range */
+#define BG_MAX_THREADS 64
+
+/* ranges are cut at the highest index level that has this many
+ * index nodes per background thread */
+#define BG_PART_MIN 4
+
 void bg_init(set_t *s);
+void bg_set_threads(int nr);
+void bg_set_adaptive(int adaptive);
 void bg_start(int sleep_time);
 void bg_stop(void);
 void bg_print_stats(void);
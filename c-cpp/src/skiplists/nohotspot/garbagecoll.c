@@ -25,7 +25,11 @@ http://www.cl.cam.ac.uk/research/srg/netos/lock-free
 #include "common.h"
 #include "ptst.h"
 #include "garbagecoll.h"
+#include "gcstats.h"
 #include "skiplist.h"
+#ifdef HUGEPAGE
+#include "hugepage.h"
+#endif
 
 /*
  * number of unique blk sizes we can deal with
@@ -48,8 +52,10 @@ do {                                                                    \
         __val = (_v);                                                   \
 } while ( 0 )
 
+/* Retired blocks are only counted, NOHOTSPOT_GC=1 reclaims them by epochs */
+#ifndef NOHOTSPOT_GC
 #define MINIMAL_GC
-/*#define PROFILE_GC*/
+#endif
 
 typedef struct gc_chunk gc_chunk;
 struct gc_chunk {
@@ -79,18 +85,26 @@ static struct gc_global {
         gc_chunk * VOLATILE alloc[MAX_SIZES];
         VOLATILE unsigned long alloc_size[MAX_SIZES];
 
-#ifdef PROFILE_GC
-        VOLATILE unsigned long total_size;
-        VOLATILE unsigned long allocations;
-        VOLATILE unsigned long alloc_chunk_num;
-        VOLATILE unsigned long num_reclaims;
-        VOLATILE unsigned long num_frees;
-#endif
+        CACHE_PAD(3);
+
+        /* reclamation statistics, mostly updated under inreclaim */
+        VOLATILE unsigned long threads;
+        gc_stats_t stats;
 } gc_global;
 
+#ifdef HUGEPAGE
+/* node blocks are carved out of huge-page regions */
+static hp_arena_t gc_hp_arena = HP_ARENA_INITIALIZER;
+#endif
+
 /* Per-thread state */
 struct gc_st {
         unsigned int epoch;     /* epoch seen by this thread */
+        int id;                 /* thread number reported for stalls */
+
+        /* blocks (and bytes) passed to gc_free() by this thread */
+        unsigned long retired;
+        unsigned long retired_bytes;
 
         /* number of calls to gc_entry since last gc_reclaim() attempt */
         unsigned int entries_since_reclaim;
@@ -212,12 +226,13 @@ static gc_chunk* gc_get_filled_chunks(int n, int sz)
         char *node;
         int i;
 
-#ifdef PROFILE_GC
-        ADD_TO(gc_global.total_size, (unsigned long) (n * BLKS_PER_CHUNK * sz));
-        ADD_TO(gc_global.allocations, 1);
-#endif
+        gc_stats_chunks(&gc_global.stats, n, n * BLKS_PER_CHUNK * sz);
 
+#ifdef HUGEPAGE
+        node = hp_alloc(&gc_hp_arena, n * BLKS_PER_CHUNK * sz);
+#else
         node = ALIGNED_ALLOC(n * BLKS_PER_CHUNK * sz);
+#endif
         if (!node) {
                 perror("malloc failed: gc_get_filled_chunks\n");
                 exit(1);
@@ -251,10 +266,6 @@ static gc_chunk* gc_get_alloc_chunk(gc_st *gc, int i)
                 p = alloc->next;
                 while (p == alloc) {
 
-                        #ifdef PROFILE_GC
-                        ADD_TO(gc_global.alloc_chunk_num, 1);
-                        #endif
-
                         sz = gc_global.alloc_size[i];
                         nh = gc_get_filled_chunks(sz,
                                         gc_global.blk_sizes[i]);
@@ -285,7 +296,9 @@ static void gc_reclaim(void)
         ptst_t  *ptst, *first_ptst, *our_ptst = NULL;
         gc_st   *gc = NULL;
         int     two_ago, three_ago, i, j;
-        gc_chunk *ch, *t;
+        unsigned long retired_bytes, n;
+        unsigned long long now;
+        gc_chunk *ch, *t, *c;
         unsigned long   curr_epoch;
 
         /* barrier to entering the reclaim critical section */
@@ -302,10 +315,19 @@ static void gc_reclaim(void)
 
         curr_epoch = gc_global.current;
 
+        now = gc_stats_now();
+        gc_global.stats.attempts++;
+        retired_bytes = 0;
+        for (ptst = first_ptst; NULL != ptst; ptst = ptst_next(ptst))
+                retired_bytes += ptst->gc->retired_bytes;
+        gc_stats_sample(&gc_global.stats, now, retired_bytes);
+
         /* Have all threads seen the current epoch in mutator code? */
-        for (ptst = first_ptst; NULL != ptst; ptst = sl_ptst_next(ptst)) {
-                if ((ptst->count > 1) && (ptst->gc->epoch != curr_epoch))
+        for (ptst = first_ptst; NULL != ptst; ptst = ptst_next(ptst)) {
+                if ((ptst->count > 1) && (ptst->gc->epoch != curr_epoch)) {
+                        gc_stats_stall(&gc_global.stats, now, ptst->gc->id);
                         goto out;
+                }
         }
 
         /*
@@ -329,6 +351,11 @@ static void gc_reclaim(void)
                         t = gc->garbage[three_ago][i];
                         if ((NULL == t) || ((ch = t->next) == t))
                                 continue;
+                        for (n = 0, c = ch; c != t; c = c->next)
+                                n += c->i;
+                        gc_stats_reclaim(&gc_global.stats, now, three_ago,
+                                         NUM_EPOCHS, n,
+                                         n * gc_global.blk_sizes[i]);
                         gc->garbage_tail[three_ago][i]->next = ch;
                         gc->garbage_tail[three_ago][i] = t;
                         t->next = t;
@@ -354,13 +381,10 @@ static void gc_reclaim(void)
                 }
         }
 
-        #ifdef PROFILE_GC
-        ADD_TO(gc_global.num_reclaims, 1);
-        #endif
-
         /* update the current epoch */
         BARRIER();
         gc_global.current = (curr_epoch + 1) % NUM_EPOCHS;
+        gc_stats_advance(&gc_global.stats, now, (curr_epoch + 1) % NUM_EPOCHS);
 
 out:
         gc_global.inreclaim = 0;
@@ -430,9 +454,8 @@ void* gc_alloc(ptst_t *ptst, int alloc_id)
  */
 void gc_free(ptst_t *ptst, void *p, int alloc_id)
 {
-#ifndef MINIMAL_GC
-
         gc_st *gc = ptst->gc;
+#ifndef MINIMAL_GC
         gc_chunk *prev, *new;
         gc_chunk *ch = gc->garbage[gc->epoch][alloc_id];
 
@@ -450,11 +473,9 @@ void gc_free(ptst_t *ptst, void *p, int alloc_id)
         }
 
         ch->blk[ch->i++] = p;
-
-        #ifdef PROFILE_GC
-        ADD_TO(gc_global.num_frees, 1);
-        #endif
 #endif
+        gc->retired++;
+        gc->retired_bytes += gc_global.blk_sizes[alloc_id];
 }
 
 /**
@@ -562,6 +583,11 @@ gc_st* gc_init(void)
         }
         memset(gc, 0, sizeof(*gc));
 
+        i = gc_global.threads;
+        while (!CAS(&gc_global.threads, i, i+1))
+                i = gc_global.threads;
+        gc->id = i;
+
         gc->chunk_cache = gc_get_empty_chunks(100);
 
         /* get ourselves a set of allocation chunks */
@@ -591,11 +617,6 @@ int gc_add_allocator(int alloc_size)
         gc_global.alloc[i] = gc_get_filled_chunks(ALLOC_CHUNKS_PER_LIST,
                                                   alloc_size);
 
-        #ifdef PROFILE_GC
-        printf("Added a new allocator of size %d bytes ", alloc_size);
-        printf("with alloc size %lu bytes\n", gc_global.alloc_size[i]);
-        #endif
-
         return i;
 }
 
@@ -635,21 +656,32 @@ void gc_remove_hook(int hook_id)
         /* noop */
 }
 
+/**
+ * gc_get_stats - snapshot of the reclamation statistics
+ * @s: where to store the snapshot
+ *
+ * Note: the per-thread retirement counters are read without
+ * synchronisation.
+ */
+void gc_get_stats(gc_stats_t *s)
+{
+        ptst_t *ptst;
+
+        *s = gc_global.stats;
+        for (ptst = ptst_first(); NULL != ptst; ptst = ptst_next(ptst)) {
+                s->retired += ptst->gc->retired;
+                s->retired_bytes += ptst->gc->retired_bytes;
+        }
+        s->now_ns = gc_stats_now();
+}
+
 /**
  * gc_subsystem_destroy - ...
  */
 void gc_subsystem_destroy(void)
 {
-#ifdef PROFILE_GC
-        printf("Total heap: %lu bytes (%.2fMB) in %lu allocations\n",
-                gc_global.total_size,
-                (double) gc_global.total_size / 1000000,
-                gc_global.allocations);
-        printf("Node alloc size = %lu\n", gc_global.alloc_size[0]);
-        printf("Inode alloc size = %lu\n", gc_global.alloc_size[1]);
-        printf("alloc chunk num = %lu\n", gc_global.alloc_chunk_num);
-        printf("Num reclaims = %lu\n", gc_global.num_reclaims);
-        printf("Num frees = %lu\n", gc_global.num_frees);
+#ifdef HUGEPAGE
+        hp_print_stats(&gc_hp_arena, "gc chunks");
 #endif
 }
 
@@ -661,6 +693,10 @@ void gc_subsystem_destroy(void)
 void gc_subsystem_init(void)
 {
         memset(&gc_global, 0, sizeof(gc_global));
+        gc_stats_init(&gc_global.stats);
+#ifdef MINIMAL_GC
+        gc_global.stats.disabled = 1;
+#endif
 
         gc_global.page_size = (unsigned int) sysconf(_SC_PAGESIZE);
         gc_global.free_chunks = gc_alloc_more_chunks();
@@ -9,6 +9,7 @@
 #define USE_GC
 
 #include "ptst.h"
+#include "gcstats.h"
 
 typedef struct gc_st gc_st;
 
@@ -32,6 +33,9 @@ void gc_hooklist_addptr(ptst_t *ptst, void *ptr, int hookid);
 void gc_enter(ptst_t* ptst);
 void gc_exit(ptst_t* ptst);
 
+/* Snapshot of the reclamation statistics, see gcstats.h */
+void gc_get_stats(gc_stats_t *s);
+
 /* Initialisation of GC */
 void gc_subsystem_init(void);
 void gc_subsystem_destroy(void);
@@ -61,6 +61,22 @@ finished.
 #include "garbagecoll.h"
 #include "ptst.h"
 
+#ifdef FINGER
+/*
+ * Where the last operation of the thread reached the node level. Linked
+ * nodes are never recycled, even with NOHOTSPOT_GC, so the finger can
+ * always be read; a physically removed finger is not used.
+ */
+static __thread struct {
+        set_t *set;
+        node_t *node;
+        unsigned long hits;
+        unsigned long misses;
+} sl_finger;
+
+static volatile AO_t sl_finger_hits, sl_finger_misses;
+#endif
+
 /* - Private Functions - */
 
 static int sl_finish_contains(sl_key_t key, node_t *node, val_t node_val,
@@ -184,6 +200,75 @@ static int sl_finish_insert(sl_key_t key, val_t val, node_t *node,
         return result;
 }
 
+/**
+ * sl_index_search - find an entry-point to the node level
+ * @set: the skip list set
+ * @key: the search key
+ *
+ * Returns a node whose key is at most @key.
+ */
+static node_t* sl_index_search(set_t *set, sl_key_t key)
+{
+        inode_t *item, *next_item;
+
+        item = set->top;
+        while (1) {
+                next_item = item->right;
+                if (NULL == next_item || next_item->node->key > key) {
+                        next_item = item->down;
+                        if (NULL == next_item)
+                                return item->node;
+                } else if (next_item->node->key == key) {
+                        return item->node;
+                }
+                item = next_item;
+        }
+}
+
+#ifdef FINGER
+/**
+ * sl_finger_start - the finger as an entry-point to the node level
+ * @set: the skip list set
+ * @key: the search key
+ *
+ * Returns the node the last operation of the thread ended on if it is
+ * still linked and its key is at most @key, and NULL otherwise.
+ */
+static node_t* sl_finger_start(set_t *set, sl_key_t key)
+{
+        node_t *node = sl_finger.node;
+
+        if (sl_finger.set == set && NULL != node && node->key <= key &&
+            node != node->val) {
+                return node;
+        }
+        return NULL;
+}
+
+/**
+ * sl_finger_exit - add the finger counters of the calling thread to
+ * the totals, to be called when the thread stops
+ */
+void sl_finger_exit(void)
+{
+        AO_fetch_and_add_full(&sl_finger_hits, sl_finger.hits);
+        AO_fetch_and_add_full(&sl_finger_misses, sl_finger.misses);
+        sl_finger.hits = sl_finger.misses = 0;
+}
+
+/**
+ * sl_finger_print_stats - print the share of operations that started
+ * from a finger
+ */
+void sl_finger_print_stats(void)
+{
+        unsigned long hits = sl_finger_hits, total = hits + sl_finger_misses;
+
+        printf("#finger hits  : %lu (%.1f%%)\n", hits,
+               total ? 100.0 * hits / total : 0.0);
+}
+#endif
+
 /* - The public nohotspot_ops interface - */
 
 /**
@@ -195,14 +280,20 @@ static int sl_finish_insert(sl_key_t key, val_t val, node_t *node,
  *
  * Returns the result of the operation.
  * Note: @val can be NULL. 
+ *
+ * With FINGER, the operation starts at the node level from where the
+ * last operation of the thread ended, if that node precedes @key, and
+ * goes back to the index levels after SL_FINGER_STEPS nodes.
  */
 int sl_do_operation(set_t *set, sl_optype_t optype, sl_key_t key, val_t val)
 {
-        inode_t *item = NULL, *next_item = NULL;
         node_t *node = NULL, *next = NULL;
         val_t node_val = NULL, *next_val = NULL;
         int result = 0;
         ptst_t *ptst;
+#ifdef FINGER
+        int steps = -1;
+#endif
 
         assert(NULL != set);
 
@@ -211,21 +302,14 @@ int sl_do_operation(set_t *set, sl_optype_t optype, sl_key_t key, val_t val)
 #endif
 
         /* find an entry-point to the node-level */
-        item = set->top;
-        while (1) {
-                next_item = item->right;
-                if (NULL == next_item || next_item->node->key > key) {
-                        next_item = item->down;
-                        if (NULL == next_item) {
-                                node = item->node;
-                                break;
-                        }
-                } else if (next_item->node->key == key) {
-                        node = item->node;
-                        break;
-                }
-                item = next_item;
-        }
+#ifdef FINGER
+        node = sl_finger_start(set, key);
+        if (NULL != node)
+                steps = 0;
+        else
+#endif
+        node = sl_index_search(set, key);
+
         /* find the correct node and next */
         while (1) {
                 while (node == (node_val = node->val)) {
@@ -254,8 +338,23 @@ int sl_do_operation(set_t *set, sl_optype_t optype, sl_key_t key, val_t val)
                         continue;
                 }
                 node = next;
+#ifdef FINGER
+                if (steps >= 0 && ++steps > SL_FINGER_STEPS) {
+                        node = sl_index_search(set, key);
+                        steps = -1;
+                }
+#endif
         }
 
+#ifdef FINGER
+        if (steps >= 0)
+                sl_finger.hits++;
+        else
+                sl_finger.misses++;
+        sl_finger.set = set;
+        sl_finger.node = node;
+#endif
+
 #ifdef USE_GC
         ptst_critical_exit(ptst);
 #endif
@@ -19,6 +19,14 @@ enum sl_optype {
 
 int sl_do_operation(set_t *set, sl_optype_t optype, sl_key_t key, val_t val);
 
+#ifdef FINGER
+/* Nodes walked from a finger before searching the index levels instead */
+#define SL_FINGER_STEPS 8
+
+void sl_finger_exit(void);
+void sl_finger_print_stats(void);
+#endif
+
 /* these are macros instead of functions to improve performance */
 #define sl_contains(a, b) sl_do_operation((a), CONTAINS, (b), NULL);
 #define sl_delete(a, b) sl_do_operation((a), DELETE, (b), NULL);
@@ -37,6 +37,9 @@ extern ptst_t *ptst_list;
 #define ptst_first() (ptst_list)
 #define ptst_next(_p) ((_p)->next)
 
+/* Registration counters, see ptst.c */
+void ptst_get_counts(unsigned int *nr_ptst, unsigned long *nr_reused);
+
 /* Called once at the beginning of the application */
 void ptst_subsystem_init(void);
 
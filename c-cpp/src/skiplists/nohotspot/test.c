@@ -37,6 +37,7 @@
 #include "common.h"
 #include "tm.h"
 #include "ptst.h"
+#include "churn.h"
 #include "garbagecoll.h"
 
 #define DEFAULT_DURATION                10000
@@ -50,6 +51,8 @@
 #define DEFAULT_EFFECTIVE               1
 
 #define DEFAULT_UNBALANCED              0
+#define DEFAULT_BG_THREADS              1
+#define DEFAULT_BG_SLEEP                1000000
 
 #define XSTR(s)                         STR(s)
 #define STR(s)                          #s
@@ -68,6 +71,7 @@ inline long rand_range(long r); /* declared in test.c */
 
 #include "intset.h"
 #include "background.h"
+#include "nohotspot_ops.h"
 
 VOLATILE AO_t stop;
 unsigned int global_seed;
@@ -140,7 +144,7 @@ inline long rand_range(long r) {
 }
 
 /* Re-entrant version of rand_range(r) */
-inline long rand_range_re(unsigned int *seed, long r) {
+static inline long rand_range_re(unsigned int *seed, long r) {
 	int m = RAND_MAX;
 	int d, v = 0;
 	
@@ -177,6 +181,7 @@ typedef struct thread_data {
 	unsigned int seed;
 	struct sl_set *set;
 	barrier_t *barrier;
+	churn_t *churn;
 	unsigned long failures_because_contention;
 } thread_data_t;
 
@@ -205,14 +210,16 @@ void print_skiplist(struct sl_set *set) {
 
 void *test(void *data) {
 	int unext, last = -1; 
+	unsigned long ops = 0;
 	unsigned int val = 0;
 	
 	thread_data_t *d = (thread_data_t *)data;
 	
 	/* Create transaction */
 	TM_THREAD_ENTER();
-	/* Wait on barrier */
-	barrier_cross(d->barrier);
+	/* Wait on barrier, unless replacing a thread that left */
+	if (churn_enter(d->churn))
+		barrier_cross(d->barrier);
 	
 	/* Is the first op an update? */
 	unext = (rand_range_re(&d->seed, 100) - 1 < d->update);
@@ -288,6 +295,10 @@ void *test(void *data) {
 		} else { // remove/add (even failed) is considered as an update
 			unext = (rand_range_re(&d->seed, 100) - 1 < d->update);
 		}
+
+		/* Leave after the churn period, a new thread takes over */
+		if (churn_leave(d->churn, ++ops))
+			break;
 		
 #ifdef ICC
 	}
@@ -297,6 +308,10 @@ void *test(void *data) {
 	
 	/* Free transaction */
 	TM_THREAD_EXIT();
+#ifdef FINGER
+	sl_finger_exit();
+#endif
+	churn_exit(d->churn);
 	
 	return NULL;
 }
@@ -318,6 +333,9 @@ int main(int argc, char **argv)
 		{"seed",                      required_argument, NULL, 's'},
 		{"update-rate",               required_argument, NULL, 'u'},
 		{"elasticity",                required_argument, NULL, 'x'},
+		{"churn",                     required_argument, NULL, 'c'},
+		{"bg-threads",                required_argument, NULL, 'b'},
+		{"bg-sleep",                  required_argument, NULL, 'B'},
 		{NULL, 0, NULL, 0}
 	};
 	
@@ -333,6 +351,7 @@ int main(int argc, char **argv)
 	pthread_attr_t attr;
 	barrier_t barrier;
 	struct timeval start, end;
+	gc_stats_t gc_start, gc_end;
 	struct timespec timeout;
 	int duration = DEFAULT_DURATION;
 	int initial = DEFAULT_INITIAL;
@@ -343,15 +362,21 @@ int main(int argc, char **argv)
 	int unit_tx = DEFAULT_ELASTICITY;
 	int alternate = DEFAULT_ALTERNATE;
 	int effective = DEFAULT_EFFECTIVE;
+	int churn = DEFAULT_CHURN;
+	churn_t *churn_slots;
+	unsigned int nr_ptst;
+	unsigned long nr_reused;
 	sigset_t block_set;
         struct sl_ptst *ptst;
         struct sl_node *temp;
 
         int unbalanced = DEFAULT_UNBALANCED;
+        int bg_threads = DEFAULT_BG_THREADS;
+        int bg_sleep = -1;
 
 	while(1) {
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:x:U:"
+		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:c:x:U:b:B:"
 										, long_options, &i);
 		
 		if(c == -1)
@@ -389,6 +414,12 @@ int main(int argc, char **argv)
 								 "        RNG seed (0=time-based, default=" XSTR(DEFAULT_SEED) ")\n"
 								 "  -u, --update-rate <int>\n"
 								 "        Percentage of update transactions (default=" XSTR(DEFAULT_UPDATE) ")\n"
+								 "  -c, --churn <int>\n"
+								 "        Threads leave after that many operations and are replaced (0=no churn, default=" XSTR(DEFAULT_CHURN) ")\n"
+								 "  -b, --bg-threads <int>\n"
+								 "        Background threads, each maintaining a key range (default=" XSTR(DEFAULT_BG_THREADS) ")\n"
+								 "  -B, --bg-sleep <int>\n"
+								 "        Fixed background sleep time in microseconds (default=adaptive, from " XSTR(DEFAULT_BG_SLEEP) ")\n"
 								 "  -x, --elasticity (default=4)\n"
 								 "        Use elastic transactions\n"
 								 "        0 = non-protected,\n"
@@ -423,12 +454,21 @@ int main(int argc, char **argv)
 				case 'u':
 					update = atoi(optarg);
 					break;
+				case 'c':
+					churn = atoi(optarg);
+					break;
 				case 'x':
 					unit_tx = atoi(optarg);
 					break;
                                 case 'U':
                                         unbalanced = atoi(optarg);
                                         break;
+				case 'b':
+					bg_threads = atoi(optarg);
+					break;
+				case 'B':
+					bg_sleep = atoi(optarg);
+					break;
 				case '?':
 					printf("Use -h or --help for help\n");
 					exit(0);
@@ -442,6 +482,9 @@ int main(int argc, char **argv)
 	assert(nb_threads > 0);
 	assert(range > 0 && range >= initial);
 	assert(update >= 0 && update <= 100);
+	assert(churn >= 0);
+	assert(bg_threads >= 1 && bg_threads <= BG_MAX_THREADS);
+	assert(bg_sleep >= -1);
 	
 	printf("Set type     : skip list\n");
 	printf("Duration     : %d\n", duration);
@@ -453,6 +496,12 @@ int main(int argc, char **argv)
 	printf("Elasticity   : %d\n", unit_tx);
 	printf("Alternate    : %d\n", alternate);
 	printf("Efffective   : %d\n", effective);
+	printf("Churn        : %d\n", churn);
+	printf("BG threads   : %d\n", bg_threads);
+	if (bg_sleep >= 0)
+		printf("BG sleep     : %d\n", bg_sleep);
+	else
+		printf("BG sleep     : adaptive\n");
 	printf("Type sizes   : int=%d/long=%d/ptr=%d/word=%d\n",
 				 (int)sizeof(int),
 				 (int)sizeof(long),
@@ -470,6 +519,10 @@ int main(int argc, char **argv)
 		perror("malloc");
 		exit(1);
 	}
+	if ((churn_slots = (churn_t *)malloc(nb_threads * sizeof(churn_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
 	
 	if (seed == 0)
 		srand((int)time(0));
@@ -482,6 +535,7 @@ int main(int argc, char **argv)
         ptst_subsystem_init();
         gc_subsystem_init();
         set_subsystem_init();
+        bg_set_threads(bg_threads);
         set = set_new(1);
 	stop = 0;
 
@@ -543,7 +597,12 @@ int main(int argc, char **argv)
         }
         printf("Number of levels is %d\n", set->head->level);
         bg_stop();
-        bg_start(1000000);
+        if (bg_sleep >= 0) {
+                bg_set_adaptive(0);
+                bg_start(bg_sleep);
+        } else {
+                bg_start(DEFAULT_BG_SLEEP);
+        }
 
         // Access set from all threads 
 	barrier_init(&barrier, nb_threads + 1);
@@ -576,6 +635,8 @@ int main(int argc, char **argv)
 		data[i].set = set;
 		data[i].barrier = &barrier;
 		data[i].failures_because_contention = 0;
+		data[i].churn = &churn_slots[i];
+		churn_init(&churn_slots[i], churn, &data[i]);
 		if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
 			fprintf(stderr, "Error creating thread\n");
 			exit(1);
@@ -596,7 +657,10 @@ int main(int argc, char **argv)
 	
 	printf("STARTING...\n");
 	gettimeofday(&start, NULL);
-	if (duration > 0) {
+	gc_get_stats(&gc_start);
+	if (churn > 0) {
+		churn_run(churn_slots, threads, nb_threads, test, duration);
+	} else if (duration > 0) {
 		nanosleep(&timeout, NULL);
 	} else {
 		sigemptyset(&block_set);
@@ -612,6 +676,7 @@ int main(int argc, char **argv)
         stop = 1;
 
 	gettimeofday(&end, NULL);
+	gc_get_stats(&gc_end);
 	printf("STOPPING...\n");
 	
 	// Wait for thread completion 
@@ -706,9 +771,18 @@ int main(int argc, char **argv)
 	printf("  #dup-w      : %lu (%f / s)\n", aborts_double_write, aborts_double_write * 1000.0 / duration);
 	printf("  #failures   : %lu\n",  failures_because_contention);
 	printf("Max retries   : %lu\n", max_retries);
+	gc_stats_print(&gc_start, &gc_end);
+	if (churn > 0) {
+		churn_print(churn_slots, nb_threads, duration);
+		ptst_get_counts(&nr_ptst, &nr_reused);
+		printf("  #ptst       : %u allocated, %lu reused\n", nr_ptst, nr_reused);
+	}
 
         bg_stop();
         bg_print_stats();
+#ifdef FINGER
+        sl_finger_print_stats();
+#endif
 
         /*sl_set_print(set, 1);*/
         gc_subsystem_destroy();
@@ -725,6 +799,7 @@ int main(int argc, char **argv)
 	
 	free(threads);
 	free(data);
+	free(churn_slots);
 	
 	return 0;
 }
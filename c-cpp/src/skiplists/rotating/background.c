@@ -50,6 +50,7 @@ common with other multi-threaded skip list implementations.
 #include <stdio.h>
 
 #include "common.h"
+#include "bgsched.h"
 #include "background.h"
 #include "skiplist.h"
 #include "garbagecoll.h"
@@ -80,7 +81,14 @@ static int bg_non_deleted;
 static int bg_deleted;
 static int bg_tall_deleted;
 
+/* for deciding the sleep time: nodes raised or removed and the
+ * longest run of level 0 nodes in the last pass */
+static int bg_changed;
+static int bg_run;
+
 static int bg_sleep_time;
+static int bg_adaptive = 1;
+static bg_sched_t bg_sched;
 static int bg_counter;
 static int bg_go;
 
@@ -145,6 +153,8 @@ static void* bg_loop(void *args)
                 bg_non_deleted = 0;
                 bg_deleted = 0;
                 bg_tall_deleted = 0;
+                bg_changed = 0;
+                bg_run = 0;
 
                 // traverse the node level and try deletes/raises
                 raised = bg_trav_nodes(ptst);
@@ -201,6 +211,9 @@ static void* bg_loop(void *args)
                 else {
                         bg_should_delete = 0;
                 }
+
+                bg_sleep_time = bg_sched_next(&bg_sched, bg_non_deleted,
+                                              bg_changed, bg_run);
                 BARRIER();
         }
 
@@ -222,6 +235,7 @@ static int bg_trav_nodes(ptst_t *ptst)
         node_t *above_head = set->head, *above_prev, *above_next;
         unsigned long zero = sl_zero;
         int raised = 0;
+        int run = 0;
 
         assert(NULL != set && NULL != set->head);
 
@@ -236,10 +250,19 @@ static int bg_trav_nodes(ptst_t *ptst)
 
         while (NULL != next) {
 
+                if (0 == node->level) {
+                        if (++run > bg_run)
+                                bg_run = run;
+                } else {
+                        run = 0;
+                }
+
                 if (NULL == node->val) {
                         bg_remove(prev, node, ptst);
                         if (node->level >= 1)
                                 ++bg_tall_deleted;
+                        else
+                                ++bg_changed;
                         ++bg_deleted;
                 }
                 else if (node->val != node) {
@@ -251,6 +274,7 @@ static int bg_trav_nodes(ptst_t *ptst)
                                 node->level = 1;
 
                                 raised = 1;
+                                ++bg_changed;
 
                                 get_index_above(above_head, &above_prev,
                                                 &above_next, 0, node->key,
@@ -420,6 +444,18 @@ void bg_init(set_t *s)
         bg_stats.delete_succeeds = 0;
 }
 
+/**
+ * bg_set_adaptive - choose between an adaptive and a fixed sleep time
+ * @adaptive: 1 to adapt the sleep time to the changes of the list
+ *
+ * Note: takes effect at the next bg_start, whose sleep time is then
+ * the initial one.
+ */
+void bg_set_adaptive(int adaptive)
+{
+        bg_adaptive = adaptive;
+}
+
 /**
  * bg_start - start the background thread
  *
@@ -431,6 +467,7 @@ void bg_start(int sleep_time)
         /* XXX not thread safe  XXX */
         if (!bg_running) {
                 bg_sleep_time = sleep_time;
+                bg_sched_init(&bg_sched, sleep_time, bg_adaptive);
                 bg_running = 1;
                 bg_finished = 0;
                 pthread_create(&bg_thread, NULL, bg_loop, NULL);
@@ -454,10 +491,13 @@ void bg_stop(void)
 /**
  * bg_print_stats - print background statistics
  *
- * Note: this is a noop if BG_STATS is not defined.
+ * Note: apart from the sleep time decisions, this is a noop if
+ * BG_STATS is not defined.
  */
 void bg_print_stats(void)
 {
+        bg_sched_print(&bg_sched);
+
         #ifdef BG_STATS
         printf("Loops = %lu\n", bg_stats.loops);
         printf("Raises = %lu\n", bg_stats.raises);
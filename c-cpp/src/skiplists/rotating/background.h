@@ -10,6 +10,7 @@
 #include "ptst.h"
 
 void bg_init(set_t *s);
+void bg_set_adaptive(int adaptive);
 void bg_start(int sleep_time);
 void bg_stop(void);
 void bg_print_stats(void);
@@ -15,6 +15,7 @@ do {                                        \
 typedef struct gc_st gc_st;
 
 #include "ptst.h"
+#include "gcstats.h"
 
 typedef struct gc_chunk gc_chunk;
 
@@ -38,6 +39,9 @@ void gc_hooklist_addptr(ptst_t *ptst, void *ptr, int hookid);
 void gc_enter(ptst_t* ptst);
 void gc_exit(ptst_t* ptst);
 
+/* Snapshot of the reclamation statistics, see gcstats.h */
+void gc_get_stats(gc_stats_t *s);
+
 /* Initialisation of GC */
 void gc_subsystem_init(void);
 void gc_subsystem_destroy(void);
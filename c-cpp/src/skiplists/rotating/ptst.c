@@ -23,6 +23,7 @@ Detailed description goes here.
 pthread_key_t  ptst_key;
 ptst_t *ptst_list;
 static unsigned int next_id;
+static unsigned long reuse_count;
 
 /* - Private function declarations - */
 static void ptst_destructor(ptst_t *ptst);
@@ -55,8 +56,10 @@ ptst_t* ptst_critical_enter(void)
         if (NULL == ptst) {
                 ptst = ptst_first();
                 for ( ; NULL != ptst; ptst = ptst_next(ptst)) {
-                        if ((0 == ptst->count) && CAS(&ptst->count, 0, 1))
+                        if ((0 == ptst->count) && CAS(&ptst->count, 0, 1)) {
+                                __sync_fetch_and_add(&reuse_count, 1);
                                 break;
+                        }
                 }
 
                 if (NULL == ptst) {
@@ -86,6 +89,21 @@ ptst_t* ptst_critical_enter(void)
         return ptst;
 }
 
+/**
+ * ptst_get_counts - per-thread state registration counters
+ * @nr_ptst: set to the number of ptst structures allocated so far
+ * @nr_reused: set to the number of times a released ptst was reclaimed
+ *
+ * A thread releases its ptst when it exits and the next thread to enter
+ * a critical section takes it over, so with threads joining and leaving
+ * @nr_ptst stays at the highest number of concurrent threads.
+ */
+void ptst_get_counts(unsigned int *nr_ptst, unsigned long *nr_reused)
+{
+        *nr_ptst = next_id;
+        *nr_reused = reuse_count;
+}
+
 /**
  * ptst_subsystem_init - initialise the ptst subsystem
  *
@@ -95,6 +113,7 @@ void ptst_subsystem_init(void)
 {
         ptst_list = NULL;
         next_id      = 0;
+        reuse_count  = 0;
         BARRIER();
         if (pthread_key_create(&ptst_key,
                                (void (*)(void *))ptst_destructor)) {
@@ -42,6 +42,9 @@ to implement this way.
 static int gc_id[NUM_SIZES];
 static int curr_id;
 
+/* offset of index level 0 in the rotating succs arrays */
+unsigned long sl_zero;
+
 /* - Public skiplist interface - */
 
 /**
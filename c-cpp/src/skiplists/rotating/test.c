@@ -36,6 +36,7 @@
 
 #include "tm.h"
 #include "ptst.h"
+#include "churn.h"
 #include "garbagecoll.h"
 
 #define DEFAULT_DURATION                10000
@@ -48,6 +49,7 @@
 #define DEFAULT_ALTERNATE               0
 #define DEFAULT_EFFECTIVE               1
 #define DEFAULT_UNBALANCED              0
+#define DEFAULT_BG_SLEEP                50000
 
 #define XSTR(s)                         STR(s)
 #define STR(s)                          #s
@@ -136,7 +138,7 @@ inline long rand_range(long r) {
 }
 
 /* Re-entrant version of rand_range(r) */
-inline long rand_range_re(unsigned int *seed, long r) {
+static inline long rand_range_re(unsigned int *seed, long r) {
 	int m = RAND_MAX;
 	int d, v = 0;
 	
@@ -173,6 +175,7 @@ typedef struct thread_data {
 	unsigned int seed;
 	set_t *set;
 	barrier_t *barrier;
+	churn_t *churn;
 	unsigned long failures_because_contention;
 } thread_data_t;
 
@@ -201,14 +204,16 @@ void print_skiplist(set_t *set) {
 
 void *test(void *data) {
 	int unext, last = -1;
+	unsigned long ops = 0;
 	unsigned int val = 0;
 
 	thread_data_t *d = (thread_data_t *)data;
 
 	/* Create transaction */
 	TM_THREAD_ENTER();
-	/* Wait on barrier */
-	barrier_cross(d->barrier);
+	/* Wait on barrier, unless replacing a thread that left */
+	if (churn_enter(d->churn))
+		barrier_cross(d->barrier);
 
 	/* Is the first op an update? */
 	unext = (rand_range_re(&d->seed, 100) - 1 < d->update);
@@ -286,6 +291,10 @@ void *test(void *data) {
 			unext = (rand_range_re(&d->seed, 100) - 1 < d->update);
 		}
 
+		/* Leave after the churn period, a new thread takes over */
+		if (churn_leave(d->churn, ++ops))
+			break;
+
 #ifdef ICC
 	}
 #else
@@ -294,6 +303,7 @@ void *test(void *data) {
 
 	/* Free transaction */
 	TM_THREAD_EXIT();
+	churn_exit(d->churn);
 
 	return NULL;
 }
@@ -316,6 +326,8 @@ int main(int argc, char **argv)
 		{"update-rate",               required_argument, NULL, 'u'},
 		{"unbalance",                 required_argument, NULL, 'U'},
 		{"elasticity",                required_argument, NULL, 'x'},
+		{"churn",                     required_argument, NULL, 'c'},
+		{"bg-sleep",                  required_argument, NULL, 'B'},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -331,6 +343,7 @@ int main(int argc, char **argv)
 	pthread_attr_t attr;
 	barrier_t barrier;
 	struct timeval start, end;
+	gc_stats_t gc_start, gc_end;
 	struct timespec timeout;
 	int duration = DEFAULT_DURATION;
 	int initial = DEFAULT_INITIAL;
@@ -341,14 +354,19 @@ int main(int argc, char **argv)
 	int unit_tx = DEFAULT_ELASTICITY;
 	int alternate = DEFAULT_ALTERNATE;
 	int effective = DEFAULT_EFFECTIVE;
+	int churn = DEFAULT_CHURN;
+	churn_t *churn_slots;
+	unsigned int nr_ptst;
+	unsigned long nr_reused;
 	sigset_t block_set;
         unsigned long top;
         node_t *node = NULL;
         int unbalanced = DEFAULT_UNBALANCED;
+        int bg_sleep = -1;
 
 	while(1) {
 		i = 0;
-		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:U:", long_options, &i);
+		c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:c:U:B:", long_options, &i);
 
 		if(c == -1)
 			break;
@@ -385,6 +403,10 @@ int main(int argc, char **argv)
 								 "        RNG seed (0=time-based, default=" XSTR(DEFAULT_SEED) ")\n"
 								 "  -u, --update-rate <int>\n"
 								 "        Percentage of update transactions (default=" XSTR(DEFAULT_UPDATE) ")\n"
+								 "  -c, --churn <int>\n"
+								 "        Threads leave after that many operations and are replaced (0=no churn, default=" XSTR(DEFAULT_CHURN) ")\n"
+								 "  -B, --bg-sleep <int>\n"
+								 "        Fixed background sleep time in microseconds (default=adaptive, from " XSTR(DEFAULT_BG_SLEEP) ")\n"
 					       );
 					exit(0);
 				case 'A':
@@ -411,9 +433,15 @@ int main(int argc, char **argv)
 				case 'u':
 					update = atoi(optarg);
 					break;
+				case 'c':
+					churn = atoi(optarg);
+					break;
 				case 'U':
                                         unbalanced = atoi(optarg);
                                         break;
+				case 'B':
+					bg_sleep = atoi(optarg);
+					break;
 				case '?':
 					printf("Use -h or --help for help\n");
 					exit(0);
@@ -427,6 +455,8 @@ int main(int argc, char **argv)
 	assert(nb_threads > 0);
 	assert(range > 0 && range >= initial);
 	assert(update >= 0 && update <= 100);
+	assert(churn >= 0);
+	assert(bg_sleep >= -1);
 
 	printf("Set type     : skip list\n");
 	printf("Duration     : %d\n", duration);
@@ -438,6 +468,11 @@ int main(int argc, char **argv)
 	printf("Elasticity   : %d\n", unit_tx);
 	printf("Alternate    : %d\n", alternate);
 	printf("Efffective   : %d\n", effective);
+	printf("Churn        : %d\n", churn);
+	if (bg_sleep >= 0)
+		printf("BG sleep     : %d\n", bg_sleep);
+	else
+		printf("BG sleep     : adaptive\n");
 	printf("Type sizes   : int=%d/long=%d/ptr=%d/word=%d\n",
 				 (int)sizeof(int),
 				 (int)sizeof(long),
@@ -455,6 +490,10 @@ int main(int argc, char **argv)
 		perror("malloc");
 		exit(1);
 	}
+	if ((churn_slots = (churn_t *)malloc(nb_threads * sizeof(churn_t))) == NULL) {
+		perror("malloc");
+		exit(1);
+	}
 
 	if (seed == 0)
 		srand((int)time(0));
@@ -537,7 +576,12 @@ int main(int argc, char **argv)
             AO_nop_full();
         }
         bg_stop();
-        bg_start(50000);
+        if (bg_sleep >= 0) {
+                bg_set_adaptive(0);
+                bg_start(bg_sleep);
+        } else {
+                bg_start(DEFAULT_BG_SLEEP);
+        }
         printf("Number of levels is %lu\n", set->head->level);
 
 
@@ -572,6 +616,8 @@ int main(int argc, char **argv)
 		data[i].set = set;
 		data[i].barrier = &barrier;
 		data[i].failures_because_contention = 0;
+		data[i].churn = &churn_slots[i];
+		churn_init(&churn_slots[i], churn, &data[i]);
                 if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
 			fprintf(stderr, "Error creating thread\n");
 			exit(1);
@@ -592,7 +638,10 @@ int main(int argc, char **argv)
 
 	printf("STARTING...\n");
 	gettimeofday(&start, NULL);
-	if (duration > 0) {
+	gc_get_stats(&gc_start);
+	if (churn > 0) {
+		churn_run(churn_slots, threads, nb_threads, test, duration);
+	} else if (duration > 0) {
 		nanosleep(&timeout, NULL);
 	} else {
 		sigemptyset(&block_set);
@@ -608,6 +657,7 @@ int main(int argc, char **argv)
         stop = 1;
 
 	gettimeofday(&end, NULL);
+	gc_get_stats(&gc_end);
 	printf("STOPPING...\n");
 
 	// Wait for thread completion
@@ -701,6 +751,12 @@ int main(int argc, char **argv)
 	printf("  #dup-w      : %lu (%f / s)\n", aborts_double_write, aborts_double_write * 1000.0 / duration);
 	printf("  #failures   : %lu\n",  failures_because_contention);
 	printf("Max retries   : %lu\n", max_retries);
+	gc_stats_print(&gc_start, &gc_end);
+	if (churn > 0) {
+		churn_print(churn_slots, nb_threads, duration);
+		ptst_get_counts(&nr_ptst, &nr_reused);
+		printf("  #ptst       : %u allocated, %lu reused\n", nr_ptst, nr_reused);
+	}
 
         bg_stop();
         bg_print_stats();
@@ -721,6 +777,7 @@ int main(int argc, char **argv)
 
 	free(threads);
 	free(data);
+	free(churn_slots);
 
 	return 0;
 }
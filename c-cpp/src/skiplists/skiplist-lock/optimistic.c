@@ -28,9 +28,7 @@
 
 #include "optimistic.h"
 
-unsigned int levelmax;
-
-inline int ok_to_delete(sl_node_t *node, int found) {
+static inline int ok_to_delete(sl_node_t *node, int found) {
   return (node->fullylinked && ((node->toplevel-1) == found) && !node->marked);
 }
 
@@ -39,7 +37,7 @@ inline int ok_to_delete(sl_node_t *node, int found) {
  * original paper. A fast parameter has been added to speed-up the search 
  * so that the function quits as soon as the searched element is found.
  */
-inline val_t optimistic_search(sl_intset_t *set, val_t val, sl_node_t **preds, sl_node_t **succs, int fast) {
+static inline val_t optimistic_search(sl_intset_t *set, val_t val, sl_node_t **preds, sl_node_t **succs, int fast) {
   int found, i;
   sl_node_t *pred, *curr;
 	
@@ -64,28 +62,22 @@ inline val_t optimistic_search(sl_intset_t *set, val_t val, sl_node_t **preds, s
 
 /*
  * Function optimistic_find corresponds to the contains method of the original 
- * paper. In contrast with the original version, it allocates and frees the 
- * memory at right places to avoid the use of a stop-the-world garbage 
- * collector. 
+ * paper. The predecessors are not needed by a read-only search, so only the 
+ * successors are recorded, on the stack, and contains never allocates.
  */
 int optimistic_find(sl_intset_t *set, val_t val) { 
-  sl_node_t **succs, **preds;
-  int result, found;
+  sl_node_t *succs[levelmax];
+  int found;
 	
-  preds = (sl_node_t **)xmalloc(levelmax * sizeof(sl_node_t *));
-  succs = (sl_node_t **)xmalloc(levelmax * sizeof(sl_node_t *));
-  found = optimistic_search(set, val, preds, succs, 1);
-  result = (found != -1 && succs[found]->fullylinked && !succs[found]->marked);
-  free(preds);
-  free(succs);
-  return result;
+  found = optimistic_search(set, val, NULL, succs, 1);
+  return (found != -1 && succs[found]->fullylinked && !succs[found]->marked);
 }
 
 /*
  * Function unlock_levels is an helper function for the insert and delete 
  * functions.
  */ 
-inline void unlock_levels(sl_node_t **nodes, int highestlevel, int j) {
+static inline void unlock_levels(sl_node_t **nodes, int highestlevel, int j) {
   int i, r;
   sl_node_t *old = NULL;
 
@@ -100,18 +92,16 @@ inline void unlock_levels(sl_node_t **nodes, int highestlevel, int j) {
 
 /*
  * Function optimistic_insert stands for the add method of the original paper.
- * Unlocking and freeing the memory are done at the right places.
+ * The preds and succs arrays are bounded by levelmax and kept on the stack.
  */
 int optimistic_insert(sl_intset_t *set, val_t val) {
-  sl_node_t **preds, **succs;
+  sl_node_t *preds[levelmax], *succs[levelmax];
   sl_node_t  *node_found, *prev_pred, *new_node;
   sl_node_t *pred, *succ;
   int toplevel, highest_locked, i, valid, found;
   unsigned int backoff;
   struct timespec timeout;
 
-  preds = (sl_node_t **)xmalloc(levelmax * sizeof(sl_node_t *));
-  succs = (sl_node_t **)xmalloc(levelmax * sizeof(sl_node_t *));
   toplevel = get_rand_level();
   backoff = 1;
 	
@@ -121,8 +111,6 @@ int optimistic_insert(sl_intset_t *set, val_t val) {
       node_found = succs[found];
       if (!node_found->marked) {
 	while (!node_found->fullylinked) {}
-	free(preds);
-	free(succs);
 	return 0;
       }
       continue;
@@ -164,9 +152,6 @@ int optimistic_insert(sl_intset_t *set, val_t val) {
 		
     new_node->fullylinked = 1;
     unlock_levels(preds, highest_locked, 12);
-    /* Freeing the previously allocated memory */
-    free(preds);
-    free(succs);
     return 1;
   }
 }
@@ -178,15 +163,13 @@ int optimistic_insert(sl_intset_t *set, val_t val) {
  * (cf. p132 of SIROCCO'07 proceedings).
  */
 int optimistic_delete(sl_intset_t *set, val_t val) {
-  sl_node_t **preds, **succs;
+  sl_node_t *preds[levelmax], *succs[levelmax];
   sl_node_t *node_todel, *prev_pred; 
   sl_node_t *pred, *succ;
   int is_marked, toplevel, highest_locked, i, valid, found;	
   unsigned int backoff;
   struct timespec timeout;
 
-  preds = (sl_node_t **)xmalloc(levelmax * sizeof(sl_node_t *));
-  succs = (sl_node_t **)xmalloc(levelmax * sizeof(sl_node_t *));
   node_todel = NULL;
   is_marked = 0;
   toplevel = -1;
@@ -208,8 +191,6 @@ int optimistic_delete(sl_intset_t *set, val_t val) {
 	  if (UNLOCK(&node_todel->lock) != 0)
 	    fprintf(stderr, "Error cannot unlock node_todel->val:%ld\n", 
 		    (long)node_todel->val);
-	  free(preds);
-	  free(succs);
 	  return 0;
 	}
 	node_todel->marked = 1;
@@ -245,14 +226,8 @@ int optimistic_delete(sl_intset_t *set, val_t val) {
 	preds[i]->next[i] = node_todel->next[i];
       UNLOCK(&node_todel->lock);	
       unlock_levels(preds, highest_locked, 22);
-      /* Freeing the previously allocated memory */
-      free(preds);
-      free(succs);
       return 1;
     } else {
-      /* Freeing the previously allocated memory */
-      free(preds);
-      free(succs);
       return 0;
     }
   }
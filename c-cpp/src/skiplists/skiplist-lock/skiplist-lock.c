@@ -24,16 +24,15 @@
 #include "skiplist-lock.h"
 
 unsigned int levelmax;
-
-inline void *xmalloc(size_t size)
-{
-	void *p = malloc(size);
-	if (p == NULL) {
-		perror("malloc");
-		exit(1);
-	}
-	return p;
-}
+LOCKS_DEFINE
+#ifdef HUGEPAGE
+/* 
+ * Nodes are only released when the whole set is deleted, so each thread
+ * bumps through its own huge-page backed region.
+ */
+hp_arena_t sl_hp_arena = HP_ARENA_INITIALIZER;
+static __thread hp_bump_t sl_hp_bump;
+#endif
 
 
 /* 
@@ -84,8 +83,14 @@ sl_node_t *sl_new_simple_node(val_t val, int toplevel, int transactional)
 {
 	sl_node_t *node;
 	
-	node = (sl_node_t *)xmalloc(sizeof(sl_node_t));
-	node->next = (sl_node_t **)xmalloc(toplevel * sizeof(sl_node_t *));
+#ifdef HUGEPAGE
+	node = (sl_node_t *)hp_bump_alloc(&sl_hp_arena, &sl_hp_bump, 
+					  sizeof(sl_node_t) + 
+					  toplevel * sizeof(sl_node_t *));
+#else
+	node = (sl_node_t *)xmalloc(sizeof(sl_node_t) + 
+				    toplevel * sizeof(sl_node_t *));
+#endif
 	node->val = val;
 	node->toplevel = toplevel;
 	node->marked = 0;
@@ -114,8 +119,9 @@ sl_node_t *sl_new_node(val_t val, sl_node_t *next, int toplevel, int transaction
 void sl_delete_node(sl_node_t *n)
 {
 	DESTROY_LOCK(&n->lock);
-	free(n->next);
+#ifndef HUGEPAGE
 	free(n);
+#endif
 }
 
 sl_intset_t *sl_set_new()
@@ -34,6 +34,12 @@
 
 #include <atomic_ops.h>
 
+#include "locks.h"
+
+#ifdef HUGEPAGE
+#include "hugepage.h"
+#endif
+
 #define DEFAULT_DURATION                10000
 #define DEFAULT_INITIAL                 256
 #define DEFAULT_NB_THREADS              1
@@ -56,6 +62,9 @@ extern __thread unsigned int *rng_seed;
 extern pthread_key_t rng_seed_key;
 #endif /* ! TLS */
 extern unsigned int levelmax;
+#ifdef HUGEPAGE
+extern hp_arena_t sl_hp_arena;
+#endif
 
 #define TRANSACTIONAL                   d->unit_tx
 
@@ -63,35 +72,32 @@ typedef intptr_t val_t;
 #define VAL_MIN                         INT_MIN
 #define VAL_MAX                         INT_MAX
 
-#ifdef MUTEX
-typedef pthread_mutex_t ptlock_t;
-#  define INIT_LOCK(lock)		pthread_mutex_init(lock, NULL);
-#  define DESTROY_LOCK(lock)		pthread_mutex_destroy(lock)
-#  define LOCK(lock)			pthread_mutex_lock(lock)
-#  define UNLOCK(lock)			pthread_mutex_unlock(lock)
-#else
-typedef pthread_spinlock_t ptlock_t;
-#  define INIT_LOCK(lock)		pthread_spin_init(lock, PTHREAD_PROCESS_PRIVATE);
-#  define DESTROY_LOCK(lock)		pthread_spin_destroy(lock)
-#  define LOCK(lock)			pthread_spin_lock(lock)
-#  define UNLOCK(lock)			pthread_spin_unlock(lock)
-#endif
-
+/*
+ * The tower of next pointers is allocated inline with the node so that
+ * moving down a level does not cost an extra pointer dereference.
+ */
 typedef struct sl_node {
 	val_t val; 
 	int toplevel;
-	struct sl_node** next;
 	volatile int marked;
 	volatile int fullylinked;
 	ptlock_t lock;	
+	struct sl_node* next[];
 } sl_node_t;
 
 typedef struct sl_intset {
 	sl_node_t *head;
 } sl_intset_t;
 
-inline void *xmalloc(size_t size);
-inline int rand_100();
+static inline void *xmalloc(size_t size)
+{
+	void *p = malloc(size);
+	if (p == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	return p;
+}
 
 int get_rand_level();
 int floor_log_2(unsigned int n);
@@ -117,4 +123,4 @@ int sl_set_size(sl_intset_t *set);
  * the granularity of rand() could be lower-bounded by the 32767^th which might 
  * be too high for given values of range and initial.
  */
-inline long rand_range(long r);
+long rand_range(long r);
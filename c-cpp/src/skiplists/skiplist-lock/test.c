@@ -30,7 +30,6 @@ __thread unsigned int *rng_seed;
 #else /* ! TLS */
 pthread_key_t rng_seed_key;
 #endif /* ! TLS */
-unsigned int levelmax;
 
 typedef struct barrier {
   pthread_cond_t complete;
@@ -445,6 +444,7 @@ void *test2(void *data)
     printf("Seed         : %d\n", seed);
     printf("Update rate  : %d\n", update);
     printf("Lock alg.    : %d\n", unit_tx);
+    printf("Lock type    : %s\n", LOCK_NAME);
     printf("Alternate    : %d\n", alternate);
     printf("Effective    : %d\n", effective);
     printf("Type sizes   : int=%d/long=%d/ptr=%d/word=%d\n",
@@ -658,6 +658,10 @@ void *test2(void *data)
     printf("  #inv-mem    : %lu (%f / s)\n", aborts_invalid_memory, 
 	   aborts_invalid_memory * 1000.0 / duration);
     printf("Max retries   : %lu\n", max_retries);
+
+#ifdef HUGEPAGE
+    hp_print_stats(&sl_hp_arena, "skip list nodes");
+#endif
 		
     /* Delete set */
     sl_set_delete(set);
@@ -4,7 +4,7 @@ int perform_one_insert_window_operation(thread_data_t* data, seekRecord_t * R, s
   node_t *newInt ;
 	node_t *newLeaf;
   if(data->recycledNodes.empty()){
-	  node_t * allocedNodeArr =(node_t *)xmalloc(2*sizeof(node_t));
+	  node_t * allocedNodeArr =(node_t *)node_alloc(2*sizeof(node_t));
     newInt = &allocedNodeArr[0];
     newLeaf = &allocedNodeArr[1]; 
   }
@@ -469,9 +469,9 @@ void *test2(void *data)
     else
       srand(seed);
 		
-    node_t * newRT = (node_t*)xmalloc(sizeof(node_t));
- node_t * newLC = (node_t*)xmalloc(sizeof(node_t));
- node_t * newRC = (node_t*)xmalloc(sizeof(node_t));
+    node_t * newRT = (node_t*)node_alloc(sizeof(node_t));
+ node_t * newLC = (node_t*)node_alloc(sizeof(node_t));
+ node_t * newRC = (node_t*)node_alloc(sizeof(node_t));
  
  /// Sentinel keys are larger than all other keys in the tree
  newRT->key = range+2;
@@ -626,7 +626,10 @@ void *test2(void *data)
       printf("  #upd trials : %lu (%f / s)\n", updates, updates * 1000.0 / 
 	     duration);
     } else printf("%lu (%f / s)\n", updates, updates * 1000.0 / duration);
-		
+
+#ifdef HUGEPAGE
+    hp_print_stats(&node_hp_arena, "tree nodes");
+#endif
 		
     /* Delete set */
     //sl_set_delete(set);
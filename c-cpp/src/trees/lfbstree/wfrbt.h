@@ -87,6 +87,21 @@ inline void *xmalloc(size_t size) {
   return p;
 }
 
+#ifdef HUGEPAGE
+#include "hugepage.h"
+
+// Nodes are never returned to the allocator (they are recycled per
+// thread), so each thread bumps through its own huge-page backed region.
+hp_arena_t node_hp_arena = HP_ARENA_INITIALIZER;
+__thread hp_bump_t node_hp_bump;
+
+inline void *node_alloc(size_t size) {
+  return hp_bump_alloc(&node_hp_arena, &node_hp_bump, size);
+}
+#else
+#define node_alloc(size) xmalloc(size)
+#endif
+
 
 // Forward declaration of window transactions
 int perform_one_delete_window_operation(thread_data_t* data, seekRecord_t * R, size_t key);
@@ -4,6 +4,8 @@
 #include "citrus.h" 
 #include "urcu.h"
 
+LOCKS_DEFINE
+
 /**
  * Copyright 2014 Maya Arbel (mayaarl [at] cs [dot] technion [dot] ac [dot] il).
  * 
@@ -47,7 +49,7 @@ node newNode(int key){
     new->child[1]=NULL;
     new->tag[0]=0;
     new->tag[1]=0;
-    if (pthread_mutex_init(&(new->lock), NULL) != 0){
+    if (INIT_LOCK(&(new->lock)) != 0){
         printf("\n mutex init failed\n");
     }
     return new;
@@ -112,15 +114,15 @@ bool insert(node root, int key, int value){
         tag = prev->tag[direction];
 		urcu_read_unlock();
         if (curr!=NULL) return false;
-        pthread_mutex_lock(&(prev->lock));
+        LOCK(&(prev->lock));
         if( validate(prev,tag,curr,direction) ){
             node new = newNode(key); 
 			prev->child[direction]=new;
 
-            pthread_mutex_unlock(&(prev->lock));
+            UNLOCK(&(prev->lock));
             return true;
         }
-        pthread_mutex_unlock(&(prev->lock));
+        UNLOCK(&(prev->lock));
     }
 }
 
@@ -150,11 +152,11 @@ bool delete(node root, int key){
             return false;
         }         
 		urcu_read_unlock();
-        pthread_mutex_lock(&(prev->lock));
-        pthread_mutex_lock(&(curr->lock));
+        LOCK(&(prev->lock));
+        LOCK(&(curr->lock));
         if( !validate(prev,0,curr,direction) ){
-            pthread_mutex_unlock(&(prev->lock));
-            pthread_mutex_unlock(&(curr->lock));
+            UNLOCK(&(prev->lock));
+            UNLOCK(&(curr->lock));
             continue;
         }
         if (curr->child[0] == NULL) {
@@ -163,8 +165,8 @@ bool delete(node root, int key){
             if(prev->child[direction] == NULL){
                 prev->tag[direction]++;
             }
-            pthread_mutex_unlock(&(prev->lock));
-            pthread_mutex_unlock(&(curr->lock));
+            UNLOCK(&(prev->lock));
+            UNLOCK(&(curr->lock));
             return true;
         }
         if (curr->child[1] == NULL){
@@ -173,8 +175,8 @@ bool delete(node root, int key){
             if(prev->child[direction] == NULL){
                 prev->tag[direction]++;
             }
-            pthread_mutex_unlock(&(prev->lock));
-            pthread_mutex_unlock(&(curr->lock));
+            UNLOCK(&(prev->lock));
+            UNLOCK(&(curr->lock));
             return true;
         }
 		node prevSucc = curr;
@@ -188,16 +190,16 @@ bool delete(node root, int key){
             }		
         int succDirection = 1; 
         if (prevSucc != curr){
-            pthread_mutex_lock(&(prevSucc->lock));
+            LOCK(&(prevSucc->lock));
             succDirection = 0;
         } 		
-        pthread_mutex_lock(&(succ->lock));
+        LOCK(&(succ->lock));
         if (validate(prevSucc,0,succ, succDirection) && validate(succ,succ->tag[0],NULL, 0)){
             curr->marked=true;
             node new = newNode(succ->key);
             new->child[0]=curr->child[0];
             new->child[1]=curr->child[1];
-            pthread_mutex_lock(&(new->lock)); 
+            LOCK(&(new->lock)); 
             prev->child[direction]=new;  
             urcu_synchronize();
             if(prev->child[direction] == NULL){
@@ -216,19 +218,19 @@ bool delete(node root, int key){
                     prevSucc->tag[1]++;
                 }
             }
-			pthread_mutex_unlock(&(prev->lock));
-            pthread_mutex_unlock(&(new->lock));            
-			pthread_mutex_unlock(&(curr->lock));  	
+			UNLOCK(&(prev->lock));
+            UNLOCK(&(new->lock));            
+			UNLOCK(&(curr->lock));  	
             if (prevSucc != curr)
-                pthread_mutex_unlock(&(prevSucc->lock));	
-            pthread_mutex_unlock(&(succ->lock));
+                UNLOCK(&(prevSucc->lock));	
+            UNLOCK(&(succ->lock));
             return true; 
         }
-        pthread_mutex_unlock(&(prev->lock));
-        pthread_mutex_unlock(&(curr->lock));
+        UNLOCK(&(prev->lock));
+        UNLOCK(&(curr->lock));
         if (prevSucc != curr)
-            pthread_mutex_unlock(&(prevSucc->lock));				
-        pthread_mutex_unlock(&(succ->lock));
+            UNLOCK(&(prevSucc->lock));				
+        UNLOCK(&(succ->lock));
     }
 }
 
@@ -2,6 +2,8 @@
 #define _DICTIONARY_H_
 #include <stdbool.h>
 
+#include "locks.h"
+
 /**
  * Copyright 2014 Maya Arbel (mayaarl [at] cs [dot] technion [dot] ac [dot] il).
  * 
@@ -30,7 +32,7 @@
 typedef struct node_t {
   int key;
   struct node_t* child[2];
-  pthread_mutex_t lock;
+  ptlock_t lock;
   bool marked;
   int tag[2];
   int value;
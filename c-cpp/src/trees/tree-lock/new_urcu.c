@@ -26,18 +26,21 @@
 
 int threads; 
 rcu_node** urcu_table;
+static unsigned long registrations;
 
 void initURCU(int num_threads){
-   rcu_node** result = (rcu_node**) malloc(sizeof(rcu_node)*num_threads);
+   rcu_node** result = (rcu_node**) malloc(sizeof(rcu_node*)*num_threads);
    int i;
    rcu_node* new;
    threads = num_threads; 
    for( i=0; i<threads ; i++){
         new = (rcu_node*) malloc(sizeof(rcu_node));
         new->time = 1; 
+        new->used = 0;
         *(result + i) = new;
     }
     urcu_table =  result;
+    registrations = 0;
     printf("initializing URCU finished, node_size: %zd\n", sizeof(rcu_node));
     return; 
 }
@@ -45,16 +48,58 @@ void initURCU(int num_threads){
 __thread long* times = NULL; 
 __thread int i; 
 
+/*
+ * Slots are claimed on registration and released on unregistration, so
+ * threads may come and go as long as at most num_threads are registered
+ * at once. id is only a hint for the slot to try first. A released slot
+ * keeps an odd (quiescent) time, so synchronize never waits on it, and
+ * its counter keeps growing across owners.
+ */
 void urcu_register(int id){
+    int j = -1, k;
+
     times = (long*) malloc(sizeof(long)*threads);
-    i = id; 
     if (times == NULL ){
         printf("malloc failed\n");
         exit(1);
     }
+    for( k=0; k<threads ; k++){
+        j = (id + k) % threads;
+        if (urcu_table[j]->used == 0 &&
+            __sync_bool_compare_and_swap(&urcu_table[j]->used, 0, 1))
+            break;
+    }
+    if (k == threads || j < 0){
+        printf("urcu_register: more than %d threads registered\n", threads);
+        exit(1);
+    }
+    i = j; 
+    __sync_fetch_and_add(&registrations, 1);
 }
 void urcu_unregister(){
+    if (times == NULL || !urcu_table[i]->used){
+        printf("urcu_unregister: thread not registered\n");
+        exit(1);
+    }
+    if (!(urcu_table[i]->time & 1)){
+        printf("urcu_unregister: thread inside a read-side section\n");
+        exit(1);
+    }
     free(times);
+    times = NULL;
+    __sync_lock_release(&urcu_table[i]->used);
+}
+
+int urcu_slots_used(){
+    int j, n = 0;
+
+    for( j=0; j<threads ; j++)
+        n += urcu_table[j]->used;
+    return n;
+}
+
+unsigned long urcu_registrations(){
+    return registrations;
 }
 
 void urcu_read_lock(){
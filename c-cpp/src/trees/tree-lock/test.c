@@ -34,7 +34,9 @@
 #include <atomic_ops.h>
 
 #include "citrus.h"
+#include "urcu.h"
 #include "tm.h"
+#include "churn.h"
 
 #define DEFAULT_DURATION                10000
 #define DEFAULT_INITIAL                 256
@@ -53,7 +55,7 @@
 #define ATOMIC_FETCH_AND_INC_FULL(a)    (AO_fetch_and_add1_full((volatile AO_t *)(a)))
 #define TRANSACTIONAL                   d->unit_tx
                                                                                                                                                                         
-inline void *xmalloc(size_t size) {
+static inline void *xmalloc(size_t size) {
   void *p = malloc(size);
   if (p == NULL) {
     perror("malloc");
@@ -89,21 +91,6 @@ typedef intptr_t val_t;
 #define VAL_MIN                         INT_MIN
 #define VAL_MAX                         INT_MAX
 
-#ifdef MUTEX
-typedef pthread_mutex_t ptlock_t;
-#  define INIT_LOCK(lock)               pthread_mutex_init(lock, NULL);
-#  define DESTROY_LOCK(lock)            pthread_mutex_destroy(lock)
-#  define LOCK(lock)                    pthread_mutex_lock(lock)
-#  define UNLOCK(lock)                  pthread_mutex_unlock(lock)
-#else
-typedef pthread_spinlock_t ptlock_t;
-#  define INIT_LOCK(lock)               pthread_spin_init(lock, PTHREAD_PROCESS_PRIVATE);
-#  define DESTROY_LOCK(lock)            pthread_spin_destroy(lock)
-#  define LOCK(lock)                    pthread_spin_lock(lock)
-#  define UNLOCK(lock)                  pthread_spin_unlock(lock)
-#endif
-
-
 volatile AO_t stop;
 unsigned int global_seed;
 #ifdef TLS
@@ -182,6 +169,7 @@ typedef struct thread_data {
   node_t *set;
   //sl_intset_t *set;
   barrier_t *barrier;
+  churn_t *churn;
   int id;
 } thread_data_t;
 
@@ -201,12 +189,14 @@ void *test(void *data) {
   val_t last = -1;
   val_t val = 0;
   int unext; 
+  unsigned long ops = 0;
 
   thread_data_t *d = (thread_data_t *)data;
   urcu_register(d->id);
 
-  /* Wait on barrier */
-  barrier_cross(d->barrier);
+  /* Wait on barrier, unless replacing a thread that left */
+  if (churn_enter(d->churn))
+    barrier_cross(d->barrier);
 	
   /* Is the first op an update? */
   unext = (rand_range_re(&d->seed, 100) - 1 < d->update);
@@ -292,6 +282,10 @@ void *test(void *data) {
     } else { // remove/add (even failed) is considered as an update
       unext = ((rand_range_re(&d->seed, 100) - 1) < d->update);
     }
+
+    /* Leave after the churn period, a new thread takes over */
+    if (churn_leave(d->churn, ++ops))
+      break;
 		
     //#ifdef ICC
   }
@@ -299,6 +293,8 @@ void *test(void *data) {
   //	}
   //#endif /* ICC */
 	
+  urcu_unregister();
+  churn_exit(d->churn);
   return NULL;
 }
 
@@ -379,6 +375,7 @@ void *test2(void *data)
       {"seed",                      required_argument, NULL, 'S'},
       {"update-rate",               required_argument, NULL, 'u'},
       {"unit-tx",                   required_argument, NULL, 'x'},
+      {"churn",                     required_argument, NULL, 'c'},
       {NULL, 0, NULL, 0}
     };
 
@@ -405,11 +402,13 @@ void *test2(void *data)
     int unit_tx = DEFAULT_ELASTICITY;
     int alternate = DEFAULT_ALTERNATE;
     int effective = DEFAULT_EFFECTIVE;
+    int churn = DEFAULT_CHURN;
+    churn_t *churn_slots;
     sigset_t block_set;
 		
     while(1) {
       i = 0;
-      c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:x:"
+      c = getopt_long(argc, argv, "hAf:d:i:t:r:S:u:c:x:"
 		      , long_options, &i);
 			
       if(c == -1)
@@ -448,6 +447,8 @@ void *test2(void *data)
 	       "        RNG seed (0=time-based, default=" XSTR(DEFAULT_SEED) ")\n"
 	       "  -u, --update-rate <int>\n"
 	       "        Percentage of update transactions (default=" XSTR(DEFAULT_UPDATE) ")\n"
+	       "  -c, --churn <int>\n"
+	       "        Threads leave after that many operations and are replaced (0=no churn, default=" XSTR(DEFAULT_CHURN) ")\n"
 	       "  -x, --unit-tx (default=1)\n"
 	       "        Use unit transactions\n"
 	       "        0 = non-protected,\n"
@@ -483,6 +484,9 @@ void *test2(void *data)
       case 'u':
 	update = atoi(optarg);
 	break;
+      case 'c':
+	churn = atoi(optarg);
+	break;
       case 'x':
 	unit_tx = atoi(optarg);
 	break;
@@ -499,6 +503,7 @@ void *test2(void *data)
     assert(nb_threads > 0);
     assert(range > 0 && range >= initial);
     assert(update >= 0 && update <= 100);
+    assert(churn >= 0);
 		
     printf("Set type     : skip list\n");
     printf("Duration     : %d\n", duration);
@@ -508,8 +513,10 @@ void *test2(void *data)
     printf("Seed         : %d\n", seed);
     printf("Update rate  : %d\n", update);
     printf("Lock alg.    : %d\n", unit_tx);
+    printf("Lock type    : %s\n", LOCK_NAME);
     printf("Alternate    : %d\n", alternate);
     printf("Effective    : %d\n", effective);
+    printf("Churn        : %d\n", churn);
     printf("Type sizes   : int=%d/long=%d/ptr=%d/word=%d\n",
 	   (int)sizeof(int),
 	   (int)sizeof(long),
@@ -521,6 +528,7 @@ void *test2(void *data)
 		
     data = (thread_data_t *)xmalloc(nb_threads * sizeof(thread_data_t));
     threads = (pthread_t *)xmalloc(nb_threads * sizeof(pthread_t));
+    churn_slots = (churn_t *)xmalloc(nb_threads * sizeof(churn_t));
 		
     if (seed == 0)
       srand((int)time(0));
@@ -591,6 +599,8 @@ void *test2(void *data)
       data[i].set = set;
       data[i].barrier = &barrier;
       data[i].id = i;
+      data[i].churn = &churn_slots[i];
+      churn_init(&churn_slots[i], churn, &data[i]);
       if (pthread_create(&threads[i], &attr, test, (void *)(&data[i])) != 0) {
 	fprintf(stderr, "Error creating thread\n");
 	exit(1);
@@ -603,7 +613,9 @@ void *test2(void *data)
 		
     printf("STARTING...\n");
     gettimeofday(&start, NULL);
-    if (duration > 0) {
+    if (churn > 0) {
+      churn_run(churn_slots, threads, nb_threads, test, duration);
+    } else if (duration > 0) {
       nanosleep(&timeout, NULL);
     } else {
       sigemptyset(&block_set);
@@ -710,6 +722,11 @@ void *test2(void *data)
     printf("  #inv-mem    : %lu (%f / s)\n", aborts_invalid_memory, 
 	   aborts_invalid_memory * 1000.0 / duration);
     printf("Max retries   : %lu\n", max_retries);
+    if (churn > 0) {
+      churn_print(churn_slots, nb_threads, duration);
+      printf("  #urcu slots : %d in use after join, %lu registrations\n",
+	     urcu_slots_used(), urcu_registrations());
+    }
 		
     /* Delete set */
     //sl_set_delete(set);
@@ -720,6 +737,7 @@ void *test2(void *data)
 		
     free(threads);
     free(data);
+    free(churn_slots);
 		
     return 0;
   }
@@ -26,7 +26,8 @@
 
 typedef struct rcu_node_t {
     volatile long time; 
-    char p[184];
+    volatile int used;
+    char p[180];
 } rcu_node;
 
 void initURCU(int num_threads);
@@ -35,6 +36,8 @@ void urcu_read_unlock();
 void urcu_synchronize(); 
 void urcu_register(int id);
 void urcu_unregister();
+int urcu_slots_used();
+unsigned long urcu_registrations();
 
 #else
 
@@ -55,6 +58,16 @@ static inline void urcu_unregister()
     rcu_unregister_thread();
 }
 
+static inline int urcu_slots_used()
+{
+    return 0;
+}
+
+static inline unsigned long urcu_registrations()
+{
+    return 0;
+}
+
 static inline void urcu_read_lock()
 {
     rcu_read_lock();